@@ -87,6 +87,12 @@
 #define BRIDGE_RX_PIN 36
 #define BRIDGE_TX_PIN 4
 #define BRIDGE_BAUD 115200
+// Serial1 is UART port 1. The bridge reads it through the ESP-IDF UART driver
+// (setBridgeUart), one copy from the driver buffer into the bridge ring.
+#define BRIDGE_UART_NUM 1
+// Bytes the UART driver buffers between two bridgePoll() calls. At high
+// baudrates (2 Mbaud is 200 bytes per millisecond) raise it.
+#define BRIDGE_UART_RX_BUFFER 4096
 
 // Instantiate a new BlaeckTCP object
 BlaeckTCP BlaeckTCP;
@@ -142,6 +148,7 @@ void setup()
 
   // The UART the BlaeckSerial device is wired to. Its baudrate must match the
   // device's Serial.begin(...).
+  Serial1.setRxBufferSize(BRIDGE_UART_RX_BUFFER);
   Serial1.begin(BRIDGE_BAUD, SERIAL_8N1, BRIDGE_RX_PIN, BRIDGE_TX_PIN);
 
   // Register ETH event handler
@@ -160,9 +167,33 @@ void setup()
       &Serial1,    // Bridge Serial reference; connects to the BlaeckSerial device
       SERVER_PORT  // TCP server port
   );
+
+  // Read the device's UART through the driver instead of Serial1
+  BlaeckTCP.setBridgeUart(0, BRIDGE_UART_NUM);
 }
 
 void loop()
 {
   BlaeckTCP.bridgePoll();
+
+  // Throughput and CPU share of the bridge, every 5 seconds
+  static unsigned long lastReport_ms = 0;
+  static uint32_t lastBytes = 0;
+  static uint32_t lastBusy_us = 0;
+  unsigned long now = millis();
+  if (now - lastReport_ms >= 5000)
+  {
+    uint32_t bytes = BlaeckTCP.getBridgeBytesToClients();
+    uint32_t busy_us = BlaeckTCP.getBridgeBusyMicros();
+    unsigned long elapsed_ms = now - lastReport_ms;
+    Serial.print("Bridge: ");
+    Serial.print((bytes - lastBytes) * 1000.0 / elapsed_ms, 0);
+    Serial.print(" bytes/s to clients, load ");
+    Serial.print((busy_us - lastBusy_us) / (elapsed_ms * 10.0), 1);
+    Serial.print(" %, overflows ");
+    Serial.println(BlaeckTCP.getBridgeOverflowsToClients());
+    lastReport_ms = now;
+    lastBytes = bytes;
+    lastBusy_us = busy_us;
+  }
 }
\ No newline at end of file
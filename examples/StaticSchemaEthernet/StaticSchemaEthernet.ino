@@ -0,0 +1,163 @@
+/*
+  StaticSchemaEthernet.ino
+
+  This is a sample sketch to show how to declare the signals of BlaeckTCP at compile time
+  and how much faster a data frame is written that way. It runs on an Arduino with
+  Ethernet Shield (Server) and transmits data to your PC (Client) every minute
+  (or the user-set interval).
+
+  With BlaeckStaticSchema the type codes and the schema hash are computed by the compiler
+  and a full data frame is written without a type switch per signal. At startup the sketch
+  writes the same frames with both schemas into the history ring (no client needed) and
+  prints the time per frame to the serial monitor.
+
+  Circuit:
+    Ethernet shield attached to pins 10, 11, 12, 13
+
+  Usage:
+    Upload the sketch to your board and open the serial monitor (115200 baud).
+    Open a Telnet Client (e.g. PuTTY) and connect to IP Address 192.168.1.177 (Port 23)
+    Type the following commands and press enter:
+
+    <BLAECK.GET_DEVICES>              Writes the device's information to the PC
+    <BLAECK.WRITE_SYMBOLS>            Writes the symbol list to the PC
+    <BLAECK.WRITE_DATA>               Writes the data to the PC
+    <BLAECK.ACTIVATE,96,234>          The data is written every 60 seconds (60 000ms)
+                                      first Byte:  0b01100000 = 96 DEC
+                                      second Byte: 0b11101010 = 234 DEC
+                                      Minimum: 0[milliseconds] Maximum: 4 294 967 295[milliseconds]
+    <BLAECK.DEACTIVATE>               Stops writing the data every 60s
+
+
+  created by Sebastian Strobl
+  More information on: https://github.com/sebaJoSt/BlaeckTCP
+ */
+
+#include <SPI.h>
+#include <Ethernet.h>
+#include "BlaeckTCP.h"
+
+#define EXAMPLE_VERSION "1.0"
+#define SERVER_PORT 23
+#define MAX_CLIENTS 8
+#define BENCHMARK_FRAMES 1000
+
+// Instantiate a new BlaeckTCP object
+BlaeckTCP BlaeckTCP;
+
+// Signals
+float temperature;
+float humidity;
+long counter;
+unsigned int adcValue;
+bool relayOn;
+
+// Signal declarations: name and type, fixed at compile time
+BLAECK_STATIC_SIGNAL(Temperature, float, "Temperature");
+BLAECK_STATIC_SIGNAL(Humidity, float, "Humidity");
+BLAECK_STATIC_SIGNAL(Counter, long, "Counter");
+BLAECK_STATIC_SIGNAL(AdcValue, unsigned int, "ADC Value");
+BLAECK_STATIC_SIGNAL(RelayOn, bool, "Relay On");
+
+// The schema: signal order and the variables they read
+BlaeckStaticSchema<Temperature, Humidity, Counter, AdcValue, RelayOn> schema(
+    &temperature, &humidity, &counter, &adcValue, &relayOn);
+
+// Enter a MAC address and IP address for your controller below.
+// The IP address will be dependent on your local network.
+// gateway and subnet are optional:
+byte mac[] = {0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED};
+IPAddress ip(192, 168, 1, 177);
+IPAddress myDns(192, 168, 1, 1);
+IPAddress gateway(192, 168, 1, 1);
+IPAddress subnet(255, 255, 0, 0);
+
+void setup()
+{
+  // You can use Ethernet.init(pin) to configure the CS pin
+  // Ethernet.init(10);  // Most Arduino shields
+
+  // initialize the Ethernet device
+  Ethernet.begin(mac, ip, myDns, gateway, subnet);
+
+  // Open serial communications (used for debug output only)
+  Serial.begin(115200);
+
+  Serial.print("BlaeckTCP Server: ");
+  Serial.print(Ethernet.localIP());
+  Serial.print(":");
+  Serial.println(SERVER_PORT);
+
+  // Setup BlaeckTCP
+  BlaeckTCP.begin(
+      MAX_CLIENTS, // Maximal number of allowed clients
+      &Serial,     // Serial reference, used for debugging
+      5,           // Maximal signal count used;
+      SERVER_PORT  // TCP server port
+  );
+
+  BlaeckTCP.DeviceName = "Static Schema Ethernet";
+  BlaeckTCP.DeviceHWVersion = "Arduino Mega 2560 Rev3";
+  BlaeckTCP.DeviceFWVersion = EXAMPLE_VERSION;
+
+  Serial.print("Schema hash (compile time): 0x");
+  Serial.println(schema.schemaHash, HEX);
+
+  RunBenchmark();
+
+  // Register the compile-time schema for normal operation
+  BlaeckTCP.setSchema(schema);
+}
+
+void loop()
+{
+  UpdateSignals();
+
+  BlaeckTCP.tick();
+}
+
+void UpdateSignals()
+{
+  temperature = 20.0 + random(100) / 10.0;
+  humidity = 40.0 + random(200) / 10.0;
+  counter++;
+  adcValue = analogRead(A0);
+  relayOn = counter % 2;
+}
+
+// Writes the same full data frame BENCHMARK_FRAMES times with each schema.
+// The history ring records frames even without a client, so only the
+// encoding is timed, not the network.
+void RunBenchmark()
+{
+  BlaeckTCP.beginHistory(512);
+
+  BlaeckTCP.deleteSignals();
+  BlaeckTCP.addSignal("Temperature", &temperature);
+  BlaeckTCP.addSignal("Humidity", &humidity);
+  BlaeckTCP.addSignal("Counter", &counter);
+  BlaeckTCP.addSignal("ADC Value", &adcValue);
+  BlaeckTCP.addSignal("Relay On", &relayOn);
+  unsigned long dynamicTime = TimeFrames();
+
+  BlaeckTCP.setSchema(schema);
+  unsigned long staticTime = TimeFrames();
+
+  BlaeckTCP.endHistory();
+
+  Serial.print("addSignal():   ");
+  Serial.print(dynamicTime / (float)BENCHMARK_FRAMES);
+  Serial.println(" us/frame");
+  Serial.print("setSchema():   ");
+  Serial.print(staticTime / (float)BENCHMARK_FRAMES);
+  Serial.println(" us/frame");
+}
+
+unsigned long TimeFrames()
+{
+  UpdateSignals();
+  unsigned long start = micros();
+  for (int i = 0; i < BENCHMARK_FRAMES; i++)
+    BlaeckTCP.writeAllData();
+  return micros() - start;
+}
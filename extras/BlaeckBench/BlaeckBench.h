@@ -0,0 +1,436 @@
+/*
+        File: BlaeckBench.h
+        Author: Sebastian Strobl
+
+        Microbenchmarks of the hot paths: data frame encoding, the symbol
+        list, the schema hash, command parsing and handler dispatch. Each
+        case runs until it has taken about 20 ms and reports the time per
+        operation and the bytes it produced per operation.
+
+        Time is in nanoseconds on the host build (extras/host), in CPU cycles
+        on ESP32/ESP8266 and in microseconds elsewhere. The cases that need a
+        connected client (fan-out to 1-8 clients, the symbol list, receiving
+        commands) run on the host only, over the loopback.
+
+        The library is measured as configured: statistics (on by default)
+        and tracing add their own cost, so build with -DBLAECK_ENABLE_STATS=0
+        to see the bare paths. Dispatch is measured with as many handlers as
+        BLAECK_COMMAND_MAX_HANDLERS_DEFAULT allows.
+*/
+
+#ifndef BLAECK_BENCH_H
+#define BLAECK_BENCH_H
+
+#include <BlaeckTCP.h>
+#if defined(BLAECK_HOST)
+  #include <BlaeckHost.h>
+  #include <chrono>
+#endif
+
+#if defined(BLAECK_HOST)
+typedef unsigned long long BlaeckBenchTicks;
+  #define BLAECK_BENCH_UNIT "ns"
+#elif defined(ESP32) || defined(ESP8266)
+typedef uint32_t BlaeckBenchTicks;
+  #define BLAECK_BENCH_UNIT "cycles"
+#else
+typedef unsigned long BlaeckBenchTicks;
+  #define BLAECK_BENCH_UNIT "us"
+#endif
+
+// Largest signal count of the cases; each signal gets a 16-byte slot
+#define BLAECK_BENCH_MAX_SIGNALS 1000
+#define BLAECK_BENCH_SLOT_SIZE 16
+
+// The mixed signal set of the static schema cases, also added one by one
+// with addSignal() for the comparison
+BLAECK_STATIC_SIGNAL(BenchFloat0, float, "f0");
+BLAECK_STATIC_SIGNAL(BenchFloat1, float, "f1");
+BLAECK_STATIC_SIGNAL(BenchFloat2, float, "f2");
+BLAECK_STATIC_SIGNAL(BenchFloat3, float, "f3");
+BLAECK_STATIC_SIGNAL(BenchLong0, long, "l0");
+BLAECK_STATIC_SIGNAL(BenchLong1, long, "l1");
+BLAECK_STATIC_SIGNAL(BenchInt, int, "i0");
+BLAECK_STATIC_SIGNAL(BenchByte, byte, "b0");
+BLAECK_STATIC_SIGNAL(BenchDouble, double, "d0");
+BLAECK_STATIC_SIGNAL(BenchString, char, "s0");
+
+class BlaeckBench
+{
+public:
+  explicit BlaeckBench(Print &report) : _report(report) {}
+
+  // Only cases whose name contains filter run (nullptr: all)
+  void setFilter(const char *filter) { _filter = filter; }
+
+  void run()
+  {
+    _line("%-34s %14s %12s", "case", BLAECK_BENCH_UNIT "/op", "bytes/op");
+
+    _encodeCases<bool>("bool");
+    _encodeCases<byte>("byte");
+    _encodeCases<short>("short");
+    _encodeCases<unsigned short>("ushort");
+    _encodeCases<int>("int");
+    _encodeCases<unsigned int>("uint");
+    _encodeCases<long>("long");
+    _encodeCases<unsigned long>("ulong");
+    _encodeCases<float>("float");
+    _encodeCases<double>("double");
+    _encodeCases<char>("string");
+    _staticSchemaCases();
+
+    _schemaHashCases();
+    _parseCase();
+    _dispatchCases();
+#if defined(BLAECK_HOST)
+    _fanOutCases();
+    _symbolCases();
+    _receiveCase();
+#endif
+  }
+
+private:
+  // Takes every byte and keeps none: the frame target and the debug stream
+  class Sink : public Stream
+  {
+  public:
+    unsigned long long bytes = 0;
+    using Print::write;
+    size_t write(uint8_t) override
+    {
+      bytes++;
+      return 1;
+    }
+    size_t write(const uint8_t *, size_t size) override
+    {
+      bytes += size;
+      return size;
+    }
+    int availableForWrite() override { return 1460; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+  };
+
+  static BlaeckBenchTicks _now()
+  {
+#if defined(BLAECK_HOST)
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#elif defined(ESP32) || defined(ESP8266)
+    return ESP.getCycleCount();
+#else
+    return micros();
+#endif
+  }
+
+  // About 20 ms in _now() ticks
+  static BlaeckBenchTicks _target()
+  {
+#if defined(BLAECK_HOST)
+    return 20000000ULL;
+#elif defined(ESP32) || defined(ESP8266)
+    return ESP.getCpuFreqMHz() * 20000UL;
+#else
+    return 20000UL;
+#endif
+  }
+
+  void _line(const char *format, const char *name, const char *a, const char *b)
+  {
+    char line[96];
+    int len = snprintf(line, sizeof(line) - 2, format, name, a, b);
+    if (len > (int)sizeof(line) - 3)
+      len = sizeof(line) - 3;
+    line[len++] = '\r';
+    line[len++] = '\n';
+    _report.write((const uint8_t *)line, len);
+  }
+
+  bool _selected(const char *name) const { return _filter == nullptr || strstr(name, _filter) != nullptr; }
+
+  // Runs op (which returns the bytes it produced) in doubling batches until
+  // a batch takes the target time, after one untimed warm-up call
+  template <typename Op>
+  void _measure(const char *name, Op op)
+  {
+    if (!_selected(name))
+      return;
+
+    op();
+    unsigned long iterations = 1;
+    BlaeckBenchTicks elapsed;
+    unsigned long long bytes;
+    for (;;)
+    {
+      bytes = 0;
+      BlaeckBenchTicks start = _now();
+      for (unsigned long i = 0; i < iterations; i++)
+        bytes += op();
+      elapsed = _now() - start;
+      if (elapsed >= _target() || iterations >= 0x40000000UL)
+        break;
+      iterations *= 2;
+    }
+
+    char perOp[24];
+    char bytesPerOp[24];
+    snprintf(perOp, sizeof(perOp), "%.1f", (double)elapsed / iterations);
+    snprintf(bytesPerOp, sizeof(bytesPerOp), "%.1f", (double)bytes / iterations);
+    _line("%-34s %14s %12s", name, perOp, bytesPerOp);
+    yield();
+  }
+
+  static void _nopHandler(const char *, const char *const *, byte) {}
+
+  template <typename T>
+  static T *_slot(unsigned int i) { return reinterpret_cast<T *>(&_storage()[i * BLAECK_BENCH_SLOT_SIZE]); }
+
+  static uint8_t *_storage()
+  {
+    static uint8_t storage[BLAECK_BENCH_MAX_SIGNALS * BLAECK_BENCH_SLOT_SIZE];
+    return storage;
+  }
+
+  template <typename T>
+  static void _fill(T *value, unsigned int i) { *value = (T)(i + 1); }
+  static void _fill(char *value, unsigned int) { strcpy(value, "value"); }
+
+  template <typename T>
+  static void _addSignals(BlaeckTCP &lib, unsigned int count)
+  {
+    char name[12];
+    for (unsigned int i = 0; i < count; i++)
+    {
+      memset(_slot<uint8_t>(i), 0, BLAECK_BENCH_SLOT_SIZE);
+      _fill(_slot<T>(i), i);
+      snprintf(name, sizeof(name), "s%u", i);
+      lib.addSignal(String(name), _slot<T>(i));
+    }
+  }
+
+  void _encodeCase(BlaeckTCP &lib, const char *typeName, unsigned int count, bool onlyUpdated)
+  {
+    char name[40];
+    snprintf(name, sizeof(name), "encode/%s/%u/%s", typeName, count, onlyUpdated ? "updated" : "all");
+    _measure(name, [&]() -> unsigned long long {
+      // Updated: one signal in ten changed since the last frame
+      if (onlyUpdated)
+        for (unsigned int i = 0; i < count; i += 10)
+          lib.markSignalUpdated(i);
+      unsigned long long before = _sink.bytes;
+      lib.writeData(1, _sink, 0, count - 1, onlyUpdated, 0);
+      return _sink.bytes - before;
+    });
+  }
+
+  template <typename T>
+  void _encodeCases(const char *typeName)
+  {
+    static const unsigned int counts[] = {1, 10, 100, BLAECK_BENCH_MAX_SIGNALS};
+    for (unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+      BlaeckTCP *lib = new BlaeckTCP();
+      lib->begin(1, &_sink, counts[c], 23);
+      _addSignals<T>(*lib, counts[c]);
+      _encodeCase(*lib, typeName, counts[c], false);
+      _encodeCase(*lib, typeName, counts[c], true);
+      delete lib;
+    }
+  }
+
+  // The same ten mixed signals through setSchema() and through addSignal()
+  void _staticSchemaCases()
+  {
+    static float f[4] = {1.5f, 2.5f, 3.5f, 4.5f};
+    static long l[2] = {100000L, -100000L};
+    static int i0 = 42;
+    static byte b0 = 7;
+    static double d0 = 3.25;
+    static char s0[16] = "value";
+    static BlaeckStaticSchema<BenchFloat0, BenchFloat1, BenchFloat2, BenchFloat3, BenchLong0, BenchLong1,
+                              BenchInt, BenchByte, BenchDouble, BenchString>
+        schema(&f[0], &f[1], &f[2], &f[3], &l[0], &l[1], &i0, &b0, &d0, s0);
+
+    for (byte dynamic = 0; dynamic < 2; dynamic++)
+    {
+      BlaeckTCP *lib = new BlaeckTCP();
+      lib->begin(1, &_sink, schema.count, 23);
+      if (dynamic)
+      {
+        for (unsigned int i = 0; i < schema.count; i++)
+          lib->_addSignal(schema.signalName(i), false, schema.signalType(i), schema.signalAddress(i));
+      }
+      else
+        lib->setSchema(schema);
+      _encodeCase(*lib, dynamic ? "mixed" : "static", schema.count, false);
+      delete lib;
+    }
+  }
+
+  void _schemaHashCases()
+  {
+    static const unsigned int counts[] = {1, 10, 100, BLAECK_BENCH_MAX_SIGNALS};
+    for (unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+      BlaeckTCP *lib = new BlaeckTCP();
+      lib->begin(1, &_sink, counts[c], 23);
+      _addSignals<float>(*lib, counts[c]);
+      char name[40];
+      snprintf(name, sizeof(name), "schemahash/%u", counts[c]);
+      volatile uint16_t hash = 0;
+      _measure(name, [&]() -> unsigned long long {
+        hash = hash ^ lib->_schemaHashAdd(0, 0, lib->SignalCount);
+        return 0;
+      });
+      delete lib;
+    }
+  }
+
+  void _parseCase()
+  {
+    BlaeckTCP *lib = new BlaeckTCP();
+    lib->begin(1, &_sink, 1, 23);
+    _measure("parse/BLAECK.WRITE_DATA", [&]() -> unsigned long long {
+      strcpy(lib->receivedChars, "BLAECK.WRITE_DATA,1,0,0,0");
+      lib->parseData();
+      return 0;
+    });
+    delete lib;
+  }
+
+  // The command matches the last handler registered: the longest search
+  void _dispatchCases()
+  {
+    static char commands[BlaeckTCP::MAX_COMMAND_HANDLERS][16];
+    const byte maxHandlers = BlaeckTCP::MAX_COMMAND_HANDLERS;
+    const byte handlerCounts[] = {1, (byte)((maxHandlers + 1) / 2), maxHandlers};
+    for (byte c = 0; c < sizeof(handlerCounts); c++)
+    {
+      BlaeckTCP *lib = new BlaeckTCP();
+      lib->begin(1, &_sink, 1, 23);
+      for (byte h = 0; h < handlerCounts[c]; h++)
+      {
+        snprintf(commands[h], sizeof(commands[h]), "BENCH.C%u", h);
+        lib->onCommand(commands[h], _nopHandler);
+      }
+      char received[32];
+      snprintf(received, sizeof(received), "%s,1,2", commands[handlerCounts[c] - 1]);
+
+      char name[40];
+      snprintf(name, sizeof(name), "dispatch/%u-handlers", handlerCounts[c]);
+      _measure(name, [&]() -> unsigned long long {
+        strcpy(lib->receivedChars, received);
+        lib->_dispatchRegisteredHandlers();
+        return 0;
+      });
+      delete lib;
+    }
+  }
+
+#if defined(BLAECK_HOST)
+  // Accepts one loopback per client slot; they count what they get
+  static void _connect(BlaeckTCP &lib, BlaeckLoopback *hosts, byte clients)
+  {
+    for (byte i = 0; i < clients; i++)
+    {
+      hosts[i].connect(23);
+      hosts[i].setDiscard(true);
+      lib.read();
+    }
+  }
+
+  static unsigned long long _received(BlaeckLoopback *hosts, byte clients)
+  {
+    unsigned long long bytes = 0;
+    for (byte i = 0; i < clients; i++)
+      bytes += hosts[i].bytesReceived();
+    return bytes;
+  }
+
+  void _fanOutCases()
+  {
+    static const unsigned int counts[] = {1, 10, 100, BLAECK_BENCH_MAX_SIGNALS};
+    static const byte clientCounts[] = {1, 2, 4, 8};
+    for (byte k = 0; k < sizeof(clientCounts); k++)
+    {
+      for (unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+      {
+        const byte clients = clientCounts[k];
+        const unsigned int count = counts[c];
+        BlaeckTCP *lib = new BlaeckTCP();
+        BlaeckLoopback hosts[8];
+        lib->begin(clients, &_sink, count, 23);
+        _addSignals<float>(*lib, count);
+        _connect(*lib, hosts, clients);
+
+        for (byte updated = 0; updated < 2; updated++)
+        {
+          char name[40];
+          snprintf(name, sizeof(name), "fanout/float/%u/%s/%u-clients", count, updated ? "updated" : "all", clients);
+          _measure(name, [&]() -> unsigned long long {
+            unsigned long long before = _received(hosts, clients);
+            if (updated)
+            {
+              for (unsigned int i = 0; i < count; i += 10)
+                lib->markSignalUpdated(i);
+              lib->writeUpdatedData(1);
+            }
+            else
+            {
+              lib->writeAllData(1);
+            }
+            return _received(hosts, clients) - before;
+          });
+        }
+        delete lib;
+      }
+    }
+  }
+
+  void _symbolCases()
+  {
+    static const unsigned int counts[] = {1, 10, 100, BLAECK_BENCH_MAX_SIGNALS};
+    for (unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+      BlaeckTCP *lib = new BlaeckTCP();
+      BlaeckLoopback host;
+      lib->begin(1, &_sink, counts[c], 23);
+      _addSignals<float>(*lib, counts[c]);
+      _connect(*lib, &host, 1);
+
+      char name[40];
+      snprintf(name, sizeof(name), "symbols/%u", counts[c]);
+      _measure(name, [&]() -> unsigned long long {
+        unsigned long long before = host.bytesReceived();
+        lib->writeSymbols(1);
+        return host.bytesReceived() - before;
+      });
+      delete lib;
+    }
+  }
+
+  // One command through read(): receive, parse and the BLAECK.* dispatch
+  void _receiveCase()
+  {
+    BlaeckTCP *lib = new BlaeckTCP();
+    BlaeckLoopback host;
+    lib->begin(1, &_sink, 1, 23);
+    _connect(*lib, &host, 1);
+    _measure("receive/BLAECK.DEACTIVATE", [&]() -> unsigned long long {
+      host.send("<BLAECK.DEACTIVATE>");
+      lib->read();
+      return 0;
+    });
+    delete lib;
+  }
+#endif
+
+  Print &_report;
+  Sink _sink;
+  const char *_filter = nullptr;
+};
+
+#endif
@@ -0,0 +1,39 @@
+/*
+  BlaeckBench
+
+  Times the encoder, schema hash, parser and dispatcher of BlaeckTCP in CPU
+  cycles and prints one line per case to the serial monitor (115200 baud).
+  No network connection is needed; the cases that need a client run on the
+  host build (BlaeckBenchHost.cpp).
+
+  For ESP32/ESP8266: the cycle counter is their ESP.getCycleCount().
+
+  Created by Sebastian Strobl
+*/
+
+#if defined(ESP32)
+#include <WiFi.h>
+#elif defined(ESP8266)
+#include <ESP8266WiFi.h>
+#endif
+#include <BlaeckTCP.h>
+#include "BlaeckBench.h"
+
+void setup()
+{
+  Serial.begin(115200);
+  delay(2000);
+
+#if defined(ESP32) || defined(ESP8266)
+  // Brings up the TCP/IP stack so begin() can open its (unused) server socket
+  WiFi.mode(WIFI_STA);
+#endif
+
+  BlaeckBench bench(Serial);
+  bench.run();
+  Serial.println("done");
+}
+
+void loop()
+{
+}
@@ -0,0 +1,30 @@
+/*
+        File: BlaeckBenchHost.cpp
+        Author: Sebastian Strobl
+
+        BlaeckBench on the host build:
+
+        CXXFLAGS="-O2" extras/host/build.sh extras/BlaeckBench/BlaeckBenchHost.cpp -o BlaeckBench
+        ./BlaeckBench [filter]        e.g. ./BlaeckBench encode/float
+*/
+
+#if defined(BLAECK_HOST)
+
+#include "BlaeckBench.h"
+
+int main(int argc, char **argv)
+{
+  // micros() does real work on the boards; let the statistics timers do it here too
+  BlaeckHostClock::useSystemClock(true);
+
+  BlaeckHostStream report;
+  report.setEcho(true);
+
+  BlaeckBench bench(report);
+  if (argc > 1)
+    bench.setFilter(argv[1]);
+  bench.run();
+  return 0;
+}
+
+#endif
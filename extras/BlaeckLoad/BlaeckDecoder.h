@@ -0,0 +1,346 @@
+/*
+        File: BlaeckDecoder.h
+        Author: Sebastian Strobl
+
+        Reference decoder for what a BlaeckTCP device sends, written from the
+        protocol rather than from the library: plain C++11, no Arduino types
+        and its own CRC32. It splits a byte stream into frames and decodes
+        the symbol list (0xB0), device info (0xB6), data (0xD2, CRC checked)
+        and command acks (0xF0).
+
+        Every frame is  <BLAECK:  key  :  msgId(4)  :  payload  /BLAECK>\r\n.
+        A data frame's payload ends with status(1), status payload(4) and the
+        CRC32 of everything from the key on, so a "/BLAECK>\r\n" inside its
+        values is told apart by the CRC. Bytes outside frames (the greeting
+        text on connect) are skipped and counted.
+*/
+
+#ifndef BLAECK_DECODER_H
+#define BLAECK_DECODER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+struct BlaeckDecodedFrame
+{
+  uint8_t key;
+  uint32_t msgId;
+  std::string payload; // between "msgId:" and "/BLAECK>"
+};
+
+struct BlaeckDecodedSymbol
+{
+  std::string name;
+  uint8_t type; // dataType of BlaeckTCP.h: 0 bool ... 10 string
+};
+
+struct BlaeckDecodedDevice
+{
+  std::string name;
+  std::string hwVersion;
+  std::string fwVersion;
+  std::string libVersion;
+  std::string libName;
+};
+
+struct BlaeckDecodedValue
+{
+  uint16_t index;
+  double number;    // every type but string
+  std::string text; // string signals
+};
+
+struct BlaeckDecodedData
+{
+  bool restarted;
+  uint16_t schemaHash;
+  uint8_t timestampMode;
+  unsigned long long timestamp;
+  std::vector<BlaeckDecodedValue> values;
+  uint8_t status;
+};
+
+class BlaeckDecoder
+{
+public:
+  // Data frames longer than this without a matching CRC are dropped as corrupt
+  static const size_t MAX_FRAME_SIZE = 65536;
+
+  unsigned long long skippedBytes = 0;
+  unsigned long crcErrors = 0;
+
+  void feed(const uint8_t *data, size_t length) { _buffer.append((const char *)data, length); }
+
+  // The next complete frame, false until one has arrived
+  bool next(BlaeckDecodedFrame &frame)
+  {
+    static const char start[] = "<BLAECK:";
+    static const char end[] = "/BLAECK>\r\n";
+
+    for (;;)
+    {
+      size_t begin = _buffer.find(start);
+      if (begin == std::string::npos)
+      {
+        // Keep a tail that may be the start of a marker
+        size_t keep = _buffer.size() < 7 ? _buffer.size() : 7;
+        skippedBytes += _buffer.size() - keep;
+        _buffer.erase(0, _buffer.size() - keep);
+        return false;
+      }
+      if (begin > 0)
+      {
+        skippedBytes += begin;
+        _buffer.erase(0, begin);
+      }
+      if (_buffer.size() < 15)
+        return false;
+
+      uint8_t key = (uint8_t)_buffer[8];
+      size_t search = 15;
+      for (;;)
+      {
+        size_t stop = _buffer.find(end, search);
+        if (stop == std::string::npos)
+        {
+          if (_buffer.size() <= MAX_FRAME_SIZE)
+            return false;
+          // No valid end within the limit: corrupt, look for the next frame
+          crcErrors++;
+          _buffer.erase(0, 1);
+          break;
+        }
+        if (key != 0xD2 || _crcMatches(stop))
+        {
+          frame.key = key;
+          frame.msgId = _u32(10);
+          frame.payload.assign(_buffer, 15, stop - 15);
+          _buffer.erase(0, stop + 10);
+          return true;
+        }
+        // The marker was part of the values, or the frame is corrupt: a
+        // later start marker decides which
+        size_t nextStart = _buffer.find(start, 8);
+        size_t nextEnd = _buffer.find(end, stop + 1);
+        if (nextStart != std::string::npos && (nextEnd == std::string::npos || nextStart < nextEnd))
+        {
+          crcErrors++;
+          _buffer.erase(0, nextStart);
+          break;
+        }
+        search = stop + 1;
+      }
+    }
+  }
+
+  static bool parseSymbols(const BlaeckDecodedFrame &frame, std::vector<BlaeckDecodedSymbol> &symbols)
+  {
+    // msConfig(1) slaveID(1) name\0 type(1), repeated
+    symbols.clear();
+    const std::string &p = frame.payload;
+    size_t i = 0;
+    while (i < p.size())
+    {
+      if (i + 2 >= p.size())
+        return false;
+      size_t nul = p.find('\0', i + 2);
+      if (nul == std::string::npos || nul + 1 >= p.size())
+        return false;
+      BlaeckDecodedSymbol symbol;
+      symbol.name.assign(p, i + 2, nul - i - 2);
+      symbol.type = (uint8_t)p[nul + 1];
+      symbols.push_back(symbol);
+      i = nul + 2;
+    }
+    return true;
+  }
+
+  static bool parseDevice(const BlaeckDecodedFrame &frame, BlaeckDecodedDevice &device)
+  {
+    // count(1), msConfig(1), slaveID(1), then NUL-terminated strings
+    const std::string &p = frame.payload;
+    if (p.size() < 3)
+      return false;
+    std::string *fields[] = {&device.name, &device.hwVersion, &device.fwVersion, &device.libVersion, &device.libName};
+    size_t i = 3;
+    for (size_t f = 0; f < sizeof(fields) / sizeof(fields[0]); f++)
+    {
+      size_t nul = p.find('\0', i);
+      if (nul == std::string::npos)
+        return false;
+      fields[f]->assign(p, i, nul - i);
+      i = nul + 1;
+    }
+    return true;
+  }
+
+  // Needs the symbol list for the value sizes; false if the values do not
+  // add up to the frame
+  static bool parseData(const BlaeckDecodedFrame &frame, const std::vector<BlaeckDecodedSymbol> &symbols, BlaeckDecodedData &data)
+  {
+    // restart(1) : hash(2) : tsMode(1) [timestamp(8)] : values status(1) statusPayload(4) crc(4)
+    const std::string &p = frame.payload;
+    data.values.clear();
+    if (p.size() < 7 || p[1] != ':' || p[4] != ':')
+      return false;
+    data.restarted = p[0] != 0;
+    data.schemaHash = (uint16_t)((uint8_t)p[2] | ((uint8_t)p[3] << 8));
+    data.timestampMode = (uint8_t)p[5];
+    size_t i = 6;
+    data.timestamp = 0;
+    if (data.timestampMode != 0)
+    {
+      if (i + 8 > p.size())
+        return false;
+      for (int b = 7; b >= 0; b--)
+        data.timestamp = (data.timestamp << 8) | (uint8_t)p[i + b];
+      i += 8;
+    }
+    if (i >= p.size() || p[i] != ':')
+      return false;
+    i++;
+
+    const size_t tail = 9;
+    if (p.size() < i + tail)
+      return false;
+    const size_t valuesEnd = p.size() - tail;
+    while (i < valuesEnd)
+    {
+      if (i + 2 > valuesEnd)
+        return false;
+      BlaeckDecodedValue value;
+      value.index = (uint16_t)((uint8_t)p[i] | ((uint8_t)p[i + 1] << 8));
+      i += 2;
+      if (value.index >= symbols.size())
+        return false;
+      if (!_parseValue(p, i, valuesEnd, symbols[value.index].type, value))
+        return false;
+      data.values.push_back(value);
+    }
+    data.status = (uint8_t)p[valuesEnd];
+    return true;
+  }
+
+  static bool parseAck(const BlaeckDecodedFrame &frame, uint32_t &commandHash, uint8_t &status, uint8_t &reason)
+  {
+    // commandHash(4) status(1) reason(1)
+    if (frame.payload.size() < 6)
+      return false;
+    const uint8_t *p = (const uint8_t *)frame.payload.data();
+    commandHash = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    status = p[4];
+    reason = p[5];
+    return true;
+  }
+
+  // FNV-1a of a command's text between '<' and '>', as acks carry it
+  static uint32_t commandHash(const char *command)
+  {
+    uint32_t hash = 0x811C9DC5UL;
+    while (*command != '\0')
+    {
+      hash ^= (uint8_t)(*command++);
+      hash *= 0x01000193UL;
+    }
+    return hash;
+  }
+
+  // CRC-32 (IEEE 802.3, reflected), table driven
+  static uint32_t crc32(const uint8_t *data, size_t length)
+  {
+    static uint32_t table[256];
+    static bool tableReady = false;
+    if (!tableReady)
+    {
+      for (uint32_t n = 0; n < 256; n++)
+      {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+          c = (c & 1) ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+        table[n] = c;
+      }
+      tableReady = true;
+    }
+    uint32_t crc = 0xFFFFFFFFUL;
+    while (length--)
+      crc = table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFUL;
+  }
+
+private:
+  uint32_t _u32(size_t at) const
+  {
+    const uint8_t *p = (const uint8_t *)_buffer.data() + at;
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+  }
+
+  // CRC over key ... status payload against the 4 bytes before the end marker
+  bool _crcMatches(size_t stop) const
+  {
+    if (stop < 8 + 4 + 1)
+      return false;
+    const uint8_t *p = (const uint8_t *)_buffer.data();
+    return crc32(p + 8, stop - 4 - 8) == _u32(stop - 4);
+  }
+
+  static bool _parseValue(const std::string &p, size_t &i, size_t valuesEnd, uint8_t type, BlaeckDecodedValue &value)
+  {
+    static const uint8_t sizes[] = {1, 1, 2, 2, 2, 2, 4, 4, 4, 8};
+    const uint8_t *b = (const uint8_t *)p.data() + i;
+    value.number = 0;
+    if (type == 10)
+    {
+      if (i + 1 > valuesEnd || i + 1 + b[0] > valuesEnd)
+        return false;
+      value.text.assign(p, i + 1, b[0]);
+      i += 1 + b[0];
+      return true;
+    }
+    if (type >= sizeof(sizes) || i + sizes[type] > valuesEnd)
+      return false;
+
+    uint64_t raw = 0;
+    for (int k = sizes[type] - 1; k >= 0; k--)
+      raw = (raw << 8) | b[k];
+    switch (type)
+    {
+    case 0: // bool
+    case 1: // byte
+    case 3: // ushort
+    case 5: // uint (2 bytes on the wire)
+    case 7: // ulong
+      value.number = (double)raw;
+      break;
+    case 2: // short
+    case 4: // int
+      value.number = (double)(int16_t)raw;
+      break;
+    case 6: // long
+      value.number = (double)(int32_t)raw;
+      break;
+    case 8: // float
+    {
+      uint32_t bits = (uint32_t)raw;
+      float f;
+      memcpy(&f, &bits, 4);
+      value.number = f;
+    }
+    break;
+    case 9: // double
+    {
+      double d;
+      memcpy(&d, &raw, 8);
+      value.number = d;
+    }
+    break;
+    }
+    i += sizes[type];
+    return true;
+  }
+
+  std::string _buffer;
+};
+
+#endif
@@ -0,0 +1,588 @@
+/*
+        File: BlaeckLoad.cpp
+        Author: Sebastian Strobl
+
+        Load test: simulated hosts connect to a BlaeckTCP device, do the
+        BLAECK.GET_DEVICES / BLAECK.WRITE_SYMBOLS / BLAECK.ACTIVATE handshake,
+        decode every data frame with the reference decoder (CRC checked) and
+        ping the device with a command every few milliseconds. At the end it
+        reports per host the sustained frames/s and bytes/s, CRC and decode
+        errors, message id gaps and the command-to-ack (0xF0) latency.
+
+        The device is either this process (the library on the host build,
+        over the loopback, running as fast as the CPU allows) or a real
+        board over TCP:
+
+        extras/host/build.sh extras/BlaeckLoad/BlaeckLoad.cpp -o BlaeckLoad
+        ./BlaeckLoad --clients 4 --signals 200 --interval 10 --duration 5
+        ./BlaeckLoad --connect 192.168.1.177:23 --clients 2 --interval 20
+
+        Options:
+          --connect host[:port]  a real device (default: in-process loopback)
+          --clients n            simulated hosts, 1-8 (default 1)
+          --signals n            loopback device: signal count (default 100)
+          --type name            loopback device: signal type (default float)
+          --interval ms          BLAECK.ACTIVATE interval (default 10; 0: every tick)
+          --duration s           measuring time (default 5)
+          --ping ms              ping interval (default 100; 0: off)
+
+        The loopback device numbers its data frames (one message id per frame
+        sent), so a gap is a frame that a host did not get intact. Devices that
+        use tick() send a constant id; gaps are not measurable then.
+*/
+
+#if defined(BLAECK_HOST)
+
+#include <BlaeckTCP.h>
+#include <BlaeckHost.h>
+#include "BlaeckDecoder.h"
+
+#include <chrono>
+#include <map>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+BlaeckTCP BlaeckTCP;
+
+static double nowSeconds()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct LoadOptions
+{
+  const char *connectTo = nullptr;
+  int clients = 1;
+  int signals = 100;
+  const char *type = "float";
+  unsigned long interval_ms = 10;
+  double duration_s = 5;
+  unsigned long ping_ms = 100;
+};
+
+// One simulated host: its connection, decoder, handshake state and counters
+class LoadHost
+{
+public:
+  enum State
+  {
+    WAIT_DEVICES,
+    WAIT_SYMBOLS,
+    ACTIVE,
+    CLOSED
+  };
+
+  int number = 0;
+  State state = WAIT_DEVICES;
+  BlaeckDecodedDevice device;
+  std::vector<BlaeckDecodedSymbol> symbols;
+
+  double activeSince = 0;
+  unsigned long long bytes = 0;
+  unsigned long frames = 0;
+  unsigned long decodeErrors = 0;
+  unsigned long restarts = 0;
+  unsigned long gaps = 0;
+  unsigned long long missing = 0;
+  unsigned long repeatedIds = 0;
+  unsigned long pings = 0;
+  unsigned long acks = 0;
+  double latencyMin = 0;
+  double latencyMax = 0;
+  double latencySum = 0;
+
+  bool openLoopback(int hostNumber)
+  {
+    number = hostNumber;
+    if (!_loopback.connect(23))
+      return false;
+    _start();
+    return true;
+  }
+
+  bool openSocket(int hostNumber, const char *host, const char *port)
+  {
+    number = hostNumber;
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *result = nullptr;
+    if (getaddrinfo(host, port, &hints, &result) != 0)
+      return false;
+    for (addrinfo *a = result; a != nullptr && _fd < 0; a = a->ai_next)
+    {
+      _fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+      if (_fd >= 0 && connect(_fd, a->ai_addr, a->ai_addrlen) != 0)
+      {
+        close(_fd);
+        _fd = -1;
+      }
+    }
+    freeaddrinfo(result);
+    if (_fd < 0)
+      return false;
+    int one = 1;
+    setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+    _start();
+    return true;
+  }
+
+  int fd() const { return _fd; }
+
+  void poll(const LoadOptions &options)
+  {
+    if (state == CLOSED)
+      return;
+
+    uint8_t buffer[16384];
+    for (;;)
+    {
+      size_t n = _receive(buffer, sizeof(buffer));
+      if (n == 0)
+        break;
+      if (state == ACTIVE)
+        bytes += n;
+      _decoder.feed(buffer, n);
+    }
+
+    BlaeckDecodedFrame frame;
+    while (_decoder.next(frame))
+      _handle(frame, options);
+
+    if (state == ACTIVE && options.ping_ms > 0 && nowSeconds() >= _nextPing)
+    {
+      char command[32];
+      snprintf(command, sizeof(command), "LOAD.PING,%lu", pings);
+      _outstanding[BlaeckDecoder::commandHash(command)] = nowSeconds();
+      _sendCommand(command);
+      pings++;
+      _nextPing += options.ping_ms / 1000.0;
+    }
+  }
+
+  void stop()
+  {
+    if (state == CLOSED)
+      return;
+    _sendCommand("BLAECK.DEACTIVATE");
+    if (_fd >= 0)
+      close(_fd);
+    _fd = -1;
+    _loopback.close();
+    _activeTime = state == ACTIVE ? nowSeconds() - activeSince : 0;
+    state = CLOSED;
+  }
+
+  double activeTime() const { return _activeTime; }
+  unsigned long crcErrors() const { return _decoder.crcErrors; }
+
+private:
+  void _start()
+  {
+    char command[64];
+    snprintf(command, sizeof(command), "BLAECK.GET_DEVICES,1,0,0,0,BlaeckLoad%d,load", number);
+    _sendCommand(command);
+  }
+
+  void _activate(const LoadOptions &options)
+  {
+    char command[64];
+    unsigned long ms = options.interval_ms;
+    snprintf(command, sizeof(command), "BLAECK.ACTIVATE,%lu,%lu,%lu,%lu",
+             ms & 0xFF, (ms >> 8) & 0xFF, (ms >> 16) & 0xFF, (ms >> 24) & 0xFF);
+    _sendCommand(command);
+    state = ACTIVE;
+    activeSince = nowSeconds();
+    _nextPing = activeSince;
+  }
+
+  void _handle(const BlaeckDecodedFrame &frame, const LoadOptions &options)
+  {
+    switch (frame.key)
+    {
+    case 0xB6:
+      if (state == WAIT_DEVICES && frame.msgId == 1)
+      {
+        if (!BlaeckDecoder::parseDevice(frame, device))
+          decodeErrors++;
+        _sendCommand("BLAECK.WRITE_SYMBOLS,2,0,0,0");
+        state = WAIT_SYMBOLS;
+      }
+      break;
+    case 0xB0:
+      if (state == WAIT_SYMBOLS && frame.msgId == 2)
+      {
+        if (!BlaeckDecoder::parseSymbols(frame, symbols))
+          decodeErrors++;
+        _activate(options);
+      }
+      break;
+    case 0xD2:
+      if (state == ACTIVE)
+        _handleData(frame);
+      break;
+    case 0xF0:
+      _handleAck(frame);
+      break;
+    }
+  }
+
+  void _handleData(const BlaeckDecodedFrame &frame)
+  {
+    BlaeckDecodedData data;
+    if (!BlaeckDecoder::parseData(frame, symbols, data))
+    {
+      decodeErrors++;
+      return;
+    }
+    if (data.restarted)
+      restarts++;
+    if (frames > 0)
+    {
+      if (frame.msgId == _lastMsgId)
+        repeatedIds++;
+      else if (frame.msgId != _lastMsgId + 1)
+      {
+        gaps++;
+        if (frame.msgId > _lastMsgId)
+          missing += frame.msgId - _lastMsgId - 1;
+      }
+    }
+    _lastMsgId = frame.msgId;
+    frames++;
+  }
+
+  void _handleAck(const BlaeckDecodedFrame &frame)
+  {
+    uint32_t hash;
+    uint8_t status;
+    uint8_t reason;
+    if (!BlaeckDecoder::parseAck(frame, hash, status, reason))
+    {
+      decodeErrors++;
+      return;
+    }
+    // Accepted or rejected alike: a device without a LOAD.PING handler
+    // still acks it
+    std::map<uint32_t, double>::iterator sent = _outstanding.find(hash);
+    if (sent == _outstanding.end())
+      return;
+    double latency = nowSeconds() - sent->second;
+    _outstanding.erase(sent);
+    if (acks == 0 || latency < latencyMin)
+      latencyMin = latency;
+    if (latency > latencyMax)
+      latencyMax = latency;
+    latencySum += latency;
+    acks++;
+  }
+
+  void _sendCommand(const char *command)
+  {
+    std::string text = std::string("<") + command + ">";
+    if (_fd >= 0)
+    {
+      // Commands are short; a full socket buffer only happens if the device
+      // stopped reading, and then the run is void anyway
+      if (send(_fd, text.data(), text.size(), MSG_NOSIGNAL) < 0 && errno != EAGAIN)
+        state = CLOSED;
+    }
+    else
+    {
+      _loopback.send(text.c_str());
+    }
+  }
+
+  size_t _receive(uint8_t *buffer, size_t size)
+  {
+    if (_fd < 0)
+      return _loopback.read(buffer, size);
+    ssize_t n = recv(_fd, buffer, size, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+    {
+      close(_fd);
+      _fd = -1;
+      state = CLOSED;
+      return 0;
+    }
+    return n > 0 ? (size_t)n : 0;
+  }
+
+  BlaeckLoopback _loopback;
+  int _fd = -1;
+  BlaeckDecoder _decoder;
+  uint32_t _lastMsgId = 0;
+  double _nextPing = 0;
+  double _activeTime = 0;
+  std::map<uint32_t, double> _outstanding;
+};
+
+// ----- The in-process device -----
+
+static uint8_t deviceValues[1000][16];
+#if BLAECK_ENABLE_STATS
+static unsigned long deviceFrameNo = 0;
+#endif
+
+static void pingHandler(const char *, const char *const *, byte) {}
+
+template <typename T>
+static void addDeviceSignals(int count)
+{
+  char name[16];
+  for (int i = 0; i < count; i++)
+  {
+    snprintf(name, sizeof(name), "s%d", i);
+    BlaeckTCP.addSignal(String(name), reinterpret_cast<T *>(deviceValues[i]));
+  }
+}
+
+static bool beginDevice(const LoadOptions &options)
+{
+  if (options.signals < 1 || options.signals > 1000)
+    return false;
+  for (int i = 0; i < options.signals; i++)
+    strcpy((char *)deviceValues[i], "value");
+
+  BlaeckHostClock::useSystemClock(true);
+  BlaeckTCP.begin(options.clients, &Serial, options.signals, 23);
+  BlaeckTCP.DeviceName = "BlaeckLoad";
+  BlaeckTCP.onCommand("LOAD.PING", pingHandler);
+
+  const char *t = options.type;
+  if (strcmp(t, "bool") == 0)
+    addDeviceSignals<bool>(options.signals);
+  else if (strcmp(t, "byte") == 0)
+    addDeviceSignals<byte>(options.signals);
+  else if (strcmp(t, "short") == 0)
+    addDeviceSignals<short>(options.signals);
+  else if (strcmp(t, "ushort") == 0)
+    addDeviceSignals<unsigned short>(options.signals);
+  else if (strcmp(t, "int") == 0)
+    addDeviceSignals<int>(options.signals);
+  else if (strcmp(t, "uint") == 0)
+    addDeviceSignals<unsigned int>(options.signals);
+  else if (strcmp(t, "long") == 0)
+    addDeviceSignals<long>(options.signals);
+  else if (strcmp(t, "ulong") == 0)
+    addDeviceSignals<unsigned long>(options.signals);
+  else if (strcmp(t, "float") == 0)
+    addDeviceSignals<float>(options.signals);
+  else if (strcmp(t, "double") == 0)
+    addDeviceSignals<double>(options.signals);
+  else if (strcmp(t, "string") == 0)
+    addDeviceSignals<char>(options.signals);
+  else
+    return false;
+  return true;
+}
+
+static void tickDevice(const LoadOptions &options)
+{
+  // New values for every frame, so the CRC check sees changing data
+  if (strcmp(options.type, "string") != 0)
+    for (int i = 0; i < options.signals; i++)
+      deviceValues[i][0]++;
+
+#if BLAECK_ENABLE_STATS
+  uint32_t before = BlaeckTCP.getStats().dataFrames;
+  BlaeckTCP.tick(deviceFrameNo);
+  if (BlaeckTCP.getStats().dataFrames != before)
+    deviceFrameNo++;
+#else
+  BlaeckTCP.tick();
+#endif
+}
+
+// ----- Report -----
+
+static void printRow(const char *label, unsigned long frames, unsigned long long bytes, double seconds,
+                     unsigned long crc, unsigned long decode, unsigned long gaps, unsigned long long missing,
+                     unsigned long acks, unsigned long pings, double latMin, double latMean, double latMax)
+{
+  if (seconds <= 0)
+    seconds = 1e-9;
+  printf("%-6s %9lu %10.1f %12.0f %5lu %6lu %6lu(%llu) %6lu/%-6lu",
+         label, frames, frames / seconds, bytes / seconds, crc, decode, gaps, missing, acks, pings);
+  if (acks > 0)
+    printf(" %7.3f %7.3f %7.3f", latMin * 1000, latMean * 1000, latMax * 1000);
+  printf("\n");
+}
+
+static bool parseOptions(int argc, char **argv, LoadOptions &options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (value == nullptr)
+      return false;
+    if (strcmp(arg, "--connect") == 0)
+      options.connectTo = value;
+    else if (strcmp(arg, "--clients") == 0)
+      options.clients = atoi(value);
+    else if (strcmp(arg, "--signals") == 0)
+      options.signals = atoi(value);
+    else if (strcmp(arg, "--type") == 0)
+      options.type = value;
+    else if (strcmp(arg, "--interval") == 0)
+      options.interval_ms = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--duration") == 0)
+      options.duration_s = atof(value);
+    else if (strcmp(arg, "--ping") == 0)
+      options.ping_ms = strtoul(value, nullptr, 10);
+    else
+      return false;
+    i++;
+  }
+  return options.clients >= 1 && options.clients <= 8 && options.duration_s > 0;
+}
+
+int main(int argc, char **argv)
+{
+  LoadOptions options;
+  if (!parseOptions(argc, argv, options))
+  {
+    fprintf(stderr, "usage: %s [--connect host[:port]] [--clients 1-8] [--signals n] [--type name]\n"
+                    "          [--interval ms] [--duration s] [--ping ms]\n",
+            argv[0]);
+    return 2;
+  }
+
+  const bool loopback = options.connectTo == nullptr;
+  std::string host;
+  std::string port = "23";
+  if (loopback)
+  {
+    if (!beginDevice(options))
+    {
+      fprintf(stderr, "bad --signals (1-1000) or --type\n");
+      return 2;
+    }
+  }
+  else
+  {
+    host = options.connectTo;
+    size_t colon = host.rfind(':');
+    if (colon != std::string::npos && host.find(':') == colon)
+    {
+      port = host.substr(colon + 1);
+      host.erase(colon);
+    }
+  }
+
+  std::vector<LoadHost> hosts(options.clients);
+  for (int i = 0; i < options.clients; i++)
+  {
+    bool opened = loopback ? hosts[i].openLoopback(i)
+                           : hosts[i].openSocket(i, host.c_str(), port.c_str());
+    if (!opened)
+    {
+      fprintf(stderr, "host %d: cannot connect\n", i);
+      return 1;
+    }
+  }
+
+  // Handshake, then the measuring time from when the last host is active
+  double deadline = 0;
+  double giveUp = nowSeconds() + 10;
+  for (;;)
+  {
+    if (loopback)
+      tickDevice(options);
+    else
+    {
+      std::vector<pollfd> fds;
+      for (size_t i = 0; i < hosts.size(); i++)
+        if (hosts[i].fd() >= 0)
+          fds.push_back(pollfd{hosts[i].fd(), POLLIN, 0});
+      ::poll(fds.data(), fds.size(), 1);
+    }
+    for (size_t i = 0; i < hosts.size(); i++)
+      hosts[i].poll(options);
+
+    double now = nowSeconds();
+    if (deadline == 0)
+    {
+      bool allActive = true;
+      for (size_t i = 0; i < hosts.size(); i++)
+        allActive = allActive && hosts[i].state == LoadHost::ACTIVE;
+      if (allActive)
+        deadline = now + options.duration_s;
+      else if (now > giveUp)
+      {
+        fprintf(stderr, "handshake timed out\n");
+        return 1;
+      }
+    }
+    else if (now >= deadline)
+      break;
+  }
+  for (size_t i = 0; i < hosts.size(); i++)
+    hosts[i].stop();
+  if (loopback)
+    tickDevice(options);
+
+  const BlaeckDecodedDevice &device = hosts[0].device;
+  printf("%s: %s %s, %u signals (%s), %d client(s), interval %lu ms, %.1f s\n",
+         loopback ? "loopback" : options.connectTo, device.libName.c_str(), device.libVersion.c_str(),
+         (unsigned int)hosts[0].symbols.size(), loopback ? options.type : device.name.c_str(),
+         options.clients, options.interval_ms, options.duration_s);
+  printf("%-6s %9s %10s %12s %5s %6s %12s %13s %7s %7s %7s\n", "host", "frames", "frames/s", "bytes/s", "crc",
+         "decode", "gaps(miss)", "acks/pings", "lat min", "mean", "max ms");
+
+  unsigned long frames = 0, crc = 0, decode = 0, gaps = 0, acks = 0, pings = 0, repeated = 0;
+  unsigned long long bytes = 0, missing = 0;
+  double seconds = 0, latMin = 0, latMax = 0, latSum = 0;
+  for (size_t i = 0; i < hosts.size(); i++)
+  {
+    const LoadHost &h = hosts[i];
+    char label[8];
+    snprintf(label, sizeof(label), "%d", h.number);
+    printRow(label, h.frames, h.bytes, h.activeTime(), h.crcErrors(), h.decodeErrors, h.gaps, h.missing,
+             h.acks, h.pings, h.latencyMin, h.acks ? h.latencySum / h.acks : 0, h.latencyMax);
+    frames += h.frames;
+    bytes += h.bytes;
+    crc += h.crcErrors();
+    decode += h.decodeErrors;
+    gaps += h.gaps;
+    missing += h.missing;
+    repeated += h.repeatedIds;
+    if (h.acks > 0 && (acks == 0 || h.latencyMin < latMin))
+      latMin = h.latencyMin;
+    if (h.latencyMax > latMax)
+      latMax = h.latencyMax;
+    latSum += h.latencySum;
+    acks += h.acks;
+    pings += h.pings;
+    if (h.activeTime() > seconds)
+      seconds = h.activeTime();
+  }
+  if (hosts.size() > 1)
+    printRow("total", frames, bytes, seconds, crc, decode, gaps, missing, acks, pings,
+             latMin, acks ? latSum / acks : 0, latMax);
+  if (frames > hosts.size() && repeated >= frames - hosts.size())
+    printf("message ids are constant: the device does not number its frames, gaps are not measurable\n");
+
+#if BLAECK_ENABLE_STATS
+  if (loopback)
+  {
+    const BlaeckStats &stats = BlaeckTCP.getStats();
+    printf("device: tick mean %u us max %u us, frame encoding mean %u us max %u us, %u short writes\n",
+           stats.tick.mean_us(), stats.tick.max_us, stats.writeData.mean_us(), stats.writeData.max_us,
+           stats.writeStalls);
+  }
+#endif
+  // A failed run for CI: the loopback loses nothing, so any gap is a bug too
+  return crc > 0 || decode > 0 || (loopback && gaps > 0) ? 1 : 0;
+}
+
+#endif
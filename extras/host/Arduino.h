@@ -0,0 +1,200 @@
+/*
+        File: Arduino.h
+        Author: Sebastian Strobl
+
+        Host build (extras/host): the part of the Arduino core BlaeckTCP uses,
+        for Linux. millis()/micros() read the clock of BlaeckHost.h.
+*/
+
+#ifndef BLAECK_HOST_ARDUINO_H
+#define BLAECK_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// No separate flash address space: flash strings are plain strings
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+#define PROGMEM
+#define PGM_P const char *
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define memcpy_P memcpy
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+using std::max;
+using std::min;
+
+// The clock of BlaeckHost.h, in microseconds. millis() and micros() wrap at
+// 32 bits like on the boards.
+unsigned long long blaeckHostMicros();
+void blaeckHostDelay(unsigned long ms);
+inline unsigned long millis() { return (uint32_t)(blaeckHostMicros() / 1000); }
+inline unsigned long micros() { return (uint32_t)blaeckHostMicros(); }
+inline void delay(unsigned long ms) { blaeckHostDelay(ms); }
+inline void yield() {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class String
+{
+public:
+  String() {}
+  String(const char *text) : _s(text != nullptr ? text : "") {}
+  String(const __FlashStringHelper *text) : _s(reinterpret_cast<const char *>(text)) {}
+  String(int value) : _s(std::to_string(value)) {}
+  String(unsigned int value) : _s(std::to_string(value)) {}
+  String(long value) : _s(std::to_string(value)) {}
+  String(unsigned long value) : _s(std::to_string(value)) {}
+
+  const char *c_str() const { return _s.c_str(); }
+  unsigned int length() const { return _s.size(); }
+  bool reserve(unsigned int size)
+  {
+    _s.reserve(size);
+    return true;
+  }
+  String &operator+=(const String &other)
+  {
+    _s += other._s;
+    return *this;
+  }
+  String &operator+=(const char *other)
+  {
+    _s += other;
+    return *this;
+  }
+  String &operator+=(char c)
+  {
+    _s += c;
+    return *this;
+  }
+  friend String operator+(String left, const String &right) { return left += right; }
+  bool operator==(const String &other) const { return _s == other._s; }
+  bool operator==(const char *other) const { return _s == other; }
+  bool operator!=(const String &other) const { return _s != other._s; }
+  char operator[](unsigned int index) const { return index < _s.size() ? _s[index] : '\0'; }
+
+private:
+  std::string _s;
+};
+
+class Print;
+
+class Printable
+{
+public:
+  virtual ~Printable() {}
+  virtual size_t printTo(Print &p) const = 0;
+};
+
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size)
+  {
+    size_t n = 0;
+    while (size--)
+      n += write(*buffer++);
+    return n;
+  }
+  size_t write(const char *str) { return str != nullptr ? write((const uint8_t *)str, strlen(str)) : 0; }
+  size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const char *str) { return write(str); }
+  size_t print(const String &s) { return write(s.c_str()); }
+  size_t print(const __FlashStringHelper *str) { return write(reinterpret_cast<const char *>(str)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char value, int base = 10) { return print((unsigned long)value, base); }
+  size_t print(int value, int base = 10) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = 10) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = 10)
+  {
+    if (base == 10 && value < 0)
+      return print('-') + print((unsigned long)-value, 10);
+    return print((unsigned long)value, base);
+  }
+  size_t print(unsigned long value, int base = 10) { return print((unsigned long long)value, base); }
+  size_t print(unsigned long long value, int base = 10)
+  {
+    char buf[66];
+    char *p = buf + sizeof(buf) - 1;
+    *p = '\0';
+    if (base < 2)
+      base = 10;
+    do
+    {
+      int digit = (int)(value % base);
+      *--p = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+      value /= base;
+    } while (value != 0);
+    return write(p);
+  }
+  size_t print(double value, int digits = 2)
+  {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", digits, value);
+    return write(buf);
+  }
+  size_t print(const Printable &x) { return x.printTo(*this); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T &value) { return print(value) + println(); }
+  template <typename T>
+  size_t println(const T &value, int format) { return print(value, format) + println(); }
+};
+
+class Stream : public Print
+{
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  size_t readBytes(uint8_t *buffer, size_t length)
+  {
+    size_t count = 0;
+    while (count < length && available() > 0)
+      buffer[count++] = (uint8_t)read();
+    return count;
+  }
+  size_t readBytes(char *buffer, size_t length) { return readBytes((uint8_t *)buffer, length); }
+};
+
+class IPAddress : public Printable
+{
+public:
+  IPAddress() : _address{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _address{a, b, c, d} {}
+  bool operator==(const IPAddress &other) const { return memcmp(_address, other._address, 4) == 0; }
+  bool operator!=(const IPAddress &other) const { return !(*this == other); }
+  uint8_t operator[](int index) const { return _address[index]; }
+  size_t printTo(Print &p) const override
+  {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _address[0], _address[1], _address[2], _address[3]);
+    return p.write(buf);
+  }
+
+private:
+  uint8_t _address[4];
+};
+
+#endif
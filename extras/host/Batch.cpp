@@ -0,0 +1,142 @@
+/*
+        File: Batch.cpp
+        Author: Sebastian Strobl
+
+        Host build example: write calls grouped in a batch. Between
+        beginBatch() and commitBatch() the writes only store their values;
+        the commit sends one data frame with every signal written, each once
+        with its last value, under one timestamp. An aborted batch sends
+        nothing. The frames are decoded and checked for their indices, values,
+        schema hash and CRC.
+
+        extras/host/build.sh extras/host/Batch.cpp && ./Batch
+*/
+
+#include <BlaeckTCP.h>
+#include <BlaeckHost.h>
+#include "../BlaeckLoad/BlaeckDecoder.h"
+
+BlaeckTCP BlaeckTCP;
+BlaeckLoopback host;
+
+float pressure = 0;
+long count = 0;
+bool flag = false;
+char state[16] = "idle";
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+  printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok)
+    failures++;
+}
+
+// CRC16-CCITT of names and type codes, as the library computes its schema hash
+static uint16_t schemaHash(const std::vector<BlaeckDecodedSymbol> &symbols)
+{
+  uint16_t crc = 0;
+  for (const BlaeckDecodedSymbol &s : symbols)
+  {
+    std::string bytes = s.name + (char)s.type;
+    for (unsigned char b : bytes)
+    {
+      crc ^= (uint16_t)(b << 8);
+      for (int k = 0; k < 8; k++)
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+static std::vector<BlaeckDecodedFrame> readFrames(BlaeckDecoder &decoder)
+{
+  std::string bytes = host.readAll();
+  decoder.feed((const uint8_t *)bytes.data(), bytes.size());
+  std::vector<BlaeckDecodedFrame> frames;
+  BlaeckDecodedFrame frame;
+  while (decoder.next(frame))
+    frames.push_back(frame);
+  return frames;
+}
+
+static unsigned long long fixedTime()
+{
+  return 1700000000ULL;
+}
+
+int main()
+{
+  BlaeckTCP.begin(1, &Serial, 4, 23);
+  BlaeckTCP.setTimestampMode(BLAECK_UNIX);
+  BlaeckTCP.setTimestampCallback(fixedTime);
+  BlaeckTCP.addSignal("pressure", &pressure);
+  BlaeckSignal<long> countSignal = BlaeckTCP.addSignal("count", &count);
+  BlaeckTCP.addSignal("flag", &flag);
+  BlaeckTCP.addSignal("state", state);
+
+  BlaeckDecoder decoder;
+  host.connect(23);
+  BlaeckTCP.tick();
+  readFrames(decoder);
+  host.send("<BLAECK.WRITE_SYMBOLS,1,0,0,0>");
+  BlaeckTCP.tick();
+  std::vector<BlaeckDecodedFrame> frames = readFrames(decoder);
+  std::vector<BlaeckDecodedSymbol> symbols;
+  check(frames.size() == 1 && BlaeckDecoder::parseSymbols(frames[0], symbols) && symbols.size() == 4,
+        "symbol list with 4 signals");
+
+  // By name, by handle and by index; the first pressure is overwritten
+  BlaeckTCP.beginBatch();
+  BlaeckTCP.write("pressure", 1.0f);
+  countSignal.write(42);
+  BlaeckTCP.write("pressure", 2.5f);
+  BlaeckTCP.write(3, (char *)"busy");
+  check(BlaeckTCP.isBatchActive() && readFrames(decoder).empty(), "nothing sent while the batch is open");
+  check(pressure == 2.5f && count == 42, "writes store their values right away");
+
+  BlaeckTCP.commitBatch(5, 123456789ULL);
+  frames = readFrames(decoder);
+  BlaeckDecodedData data = BlaeckDecodedData();
+  bool parsed = frames.size() == 1 && BlaeckDecoder::parseData(frames[0], symbols, data);
+  check(parsed && frames[0].key == 0xD2 && frames[0].msgId == 5 && decoder.crcErrors == 0,
+        "commit sends one data frame with its message id and a valid CRC32");
+  check(parsed && data.values.size() == 3 && data.values[0].index == 0 && data.values[0].number == 2.5 &&
+            data.values[1].index == 1 && data.values[1].number == 42 && data.values[2].index == 3 &&
+            data.values[2].text == "busy",
+        "every written signal once, in index order, with its last value");
+  check(parsed && data.timestampMode == BLAECK_UNIX && data.timestamp == 123456789ULL,
+        "the batch's one timestamp");
+  check(parsed && data.schemaHash == schemaHash(symbols), "schema hash of the symbol list");
+
+  // Aborted: the value stays, nothing goes out
+  BlaeckTCP.beginBatch();
+  BlaeckTCP.write("flag", true);
+  BlaeckTCP.abortBatch();
+  check(!BlaeckTCP.isBatchActive() && flag && readFrames(decoder).empty(), "aborted batch sends nothing");
+
+  // Without an open batch a commit sends nothing, a write its own frame
+  BlaeckTCP.commitBatch(6);
+  check(readFrames(decoder).empty(), "commit without a batch sends nothing");
+  BlaeckTCP.write("flag", false, 7);
+  frames = readFrames(decoder);
+  parsed = frames.size() == 1 && BlaeckDecoder::parseData(frames[0], symbols, data);
+  check(parsed && frames[0].msgId == 7 && data.values.size() == 1 && data.values[0].index == 2 &&
+            data.values[0].number == 0 && data.timestamp == fixedTime() && decoder.crcErrors == 0,
+        "a write outside the batch is its own frame again");
+
+  // A new batch starts empty: the signals of the last one are not sent again
+  BlaeckTCP.beginBatch();
+  BlaeckTCP.write("flag", true);
+  BlaeckTCP.commitBatch(8);
+  frames = readFrames(decoder);
+  parsed = frames.size() == 1 && BlaeckDecoder::parseData(frames[0], symbols, data);
+  check(parsed && data.values.size() == 1 && data.values[0].index == 2 && data.values[0].number == 1,
+        "a new batch holds only its own writes");
+
+  host.close();
+  BlaeckTCP.tick();
+  printf("%s\n", failures == 0 ? "all checks passed" : "checks failed");
+  return failures == 0 ? 0 : 1;
+}
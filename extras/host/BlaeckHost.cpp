@@ -0,0 +1,198 @@
+/*
+        File: BlaeckHost.cpp
+        Author: Sebastian Strobl
+*/
+
+#include "BlaeckHost.h"
+#include <TelnetPrint.h>
+#include <chrono>
+#include <map>
+#include <set>
+#include <thread>
+
+NetServer TelnetPrint(23);
+BlaeckHostStream Serial;
+
+static unsigned long long fakeMicros = 0;
+static bool systemClock = false;
+static std::chrono::steady_clock::time_point systemStart;
+// Where the system clock started counting from: the fake time it replaced
+static unsigned long long systemOffset = 0;
+
+void BlaeckHostClock::set(unsigned long long us)
+{
+  fakeMicros = us;
+}
+
+void BlaeckHostClock::advance(unsigned long long us)
+{
+  fakeMicros += us;
+}
+
+unsigned long long BlaeckHostClock::now()
+{
+  if (!systemClock)
+    return fakeMicros;
+  return systemOffset + std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - systemStart)
+                            .count();
+}
+
+void BlaeckHostClock::useSystemClock(bool on)
+{
+  if (on == systemClock)
+    return;
+  if (on)
+  {
+    systemOffset = fakeMicros;
+    systemStart = std::chrono::steady_clock::now();
+  }
+  else
+  {
+    fakeMicros = now();
+  }
+  systemClock = on;
+}
+
+bool BlaeckHostClock::isSystemClock()
+{
+  return systemClock;
+}
+
+unsigned long long blaeckHostMicros()
+{
+  return BlaeckHostClock::now();
+}
+
+void blaeckHostDelay(unsigned long ms)
+{
+  if (systemClock)
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  else
+    fakeMicros += ms * 1000ULL;
+}
+
+static std::set<uint16_t> &listeningPorts()
+{
+  static std::set<uint16_t> ports;
+  return ports;
+}
+
+static std::map<uint16_t, std::deque<std::shared_ptr<BlaeckHostPipe>>> &pendingConnections()
+{
+  static std::map<uint16_t, std::deque<std::shared_ptr<BlaeckHostPipe>>> pending;
+  return pending;
+}
+
+void blaeckHostListen(uint16_t port)
+{
+  listeningPorts().insert(port);
+}
+
+bool blaeckHostIsListening(uint16_t port)
+{
+  return listeningPorts().count(port) != 0;
+}
+
+void blaeckHostQueueConnection(uint16_t port, const std::shared_ptr<BlaeckHostPipe> &pipe)
+{
+  pendingConnections()[port].push_back(pipe);
+}
+
+std::shared_ptr<BlaeckHostPipe> blaeckHostAccept(uint16_t port)
+{
+  std::deque<std::shared_ptr<BlaeckHostPipe>> &queue = pendingConnections()[port];
+  while (!queue.empty())
+  {
+    std::shared_ptr<BlaeckHostPipe> pipe = queue.front();
+    queue.pop_front();
+    // Given up on by the host before it was accepted
+    if (pipe->hostOpen)
+      return pipe;
+  }
+  return nullptr;
+}
+
+bool BlaeckLoopback::connect(uint16_t port)
+{
+  close();
+  if (!blaeckHostIsListening(port))
+    return false;
+  _pipe = std::make_shared<BlaeckHostPipe>();
+  blaeckHostQueueConnection(port, _pipe);
+  return true;
+}
+
+void BlaeckLoopback::close()
+{
+  if (_pipe != nullptr)
+    _pipe->hostOpen = false;
+  _pipe.reset();
+}
+
+void BlaeckLoopback::send(const char *text)
+{
+  send((const uint8_t *)text, strlen(text));
+}
+
+void BlaeckLoopback::send(const uint8_t *data, size_t length)
+{
+  if (_pipe == nullptr || !_pipe->deviceOpen)
+    return;
+  _pipe->toDevice.insert(_pipe->toDevice.end(), data, data + length);
+}
+
+size_t BlaeckLoopback::read(uint8_t *buffer, size_t size)
+{
+  if (_pipe == nullptr)
+    return 0;
+  size_t count = size < _pipe->toHost.size() ? size : _pipe->toHost.size();
+  std::copy(_pipe->toHost.begin(), _pipe->toHost.begin() + count, buffer);
+  _pipe->toHost.erase(_pipe->toHost.begin(), _pipe->toHost.begin() + count);
+  return count;
+}
+
+std::string BlaeckLoopback::readAll()
+{
+  if (_pipe == nullptr)
+    return std::string();
+  std::string bytes(_pipe->toHost.begin(), _pipe->toHost.end());
+  _pipe->toHost.clear();
+  return bytes;
+}
+
+void BlaeckLoopback::discard()
+{
+  if (_pipe != nullptr)
+    _pipe->toHost.clear();
+}
+
+void BlaeckLoopback::setWindow(size_t bytes)
+{
+  if (_pipe != nullptr)
+    _pipe->window = bytes;
+}
+
+void BlaeckLoopback::setDiscard(bool on)
+{
+  if (_pipe != nullptr)
+    _pipe->discard = on;
+}
+
+size_t BlaeckHostStream::write(const uint8_t *buffer, size_t size)
+{
+  if (_capture)
+    _output.append((const char *)buffer, size);
+  if (_echo)
+    fwrite(buffer, 1, size, stdout);
+  return size;
+}
+
+int BlaeckHostStream::read()
+{
+  if (_input.empty())
+    return -1;
+  int c = _input.front();
+  _input.pop_front();
+  return c;
+}
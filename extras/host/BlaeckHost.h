@@ -0,0 +1,126 @@
+/*
+        File: BlaeckHost.h
+        Author: Sebastian Strobl
+
+        Host build (extras/host): runs BlaeckTCP.cpp on Linux against an
+        in-memory loopback instead of a network stack, with a clock the
+        program advances itself. Nothing happens behind the program's back:
+        a connection is accepted, a command read and a frame written only
+        inside the library call that would do it on the board.
+
+        BlaeckTCP device;
+        BlaeckLoopback host;
+
+        device.begin(2, &Serial, 1, 23);
+        host.connect(23);                              // accepted by the next tick()
+        host.send("<BLAECK.WRITE_SYMBOLS,1,0,0,0>");
+        device.tick();
+        std::string frames = host.readAll();
+        BlaeckHostClock::advance(100000);              // 100 ms later
+*/
+
+#ifndef BLAECK_HOST_H
+#define BLAECK_HOST_H
+
+#include <Arduino.h>
+#include <deque>
+#include <memory>
+#include <string>
+
+// The clock behind millis() and micros(). It starts at 0 and only moves
+// when advanced (delay() advances it too), so runs are repeatable.
+// useSystemClock(true) makes it follow the monotonic system clock instead,
+// for measuring real durations.
+class BlaeckHostClock
+{
+public:
+  static void set(unsigned long long us);
+  static void advance(unsigned long long us);
+  static unsigned long long now();
+  static void useSystemClock(bool on);
+  static bool isSystemClock();
+};
+
+// The bytes of one loopback connection, in both directions
+struct BlaeckHostPipe
+{
+  std::deque<uint8_t> toDevice;
+  std::deque<uint8_t> toHost;
+  size_t window = (size_t)-1; // bytes toHost may hold before writes come up short
+  bool discard = false;       // count the library's writes but do not keep them
+  unsigned long long bytesToHost = 0;
+  bool hostOpen = true;
+  bool deviceOpen = true;
+};
+
+// Listening ports and the connections waiting for accept(), shared by the
+// NetServer of TelnetPrint.h and BlaeckLoopback::connect()
+void blaeckHostListen(uint16_t port);
+bool blaeckHostIsListening(uint16_t port);
+void blaeckHostQueueConnection(uint16_t port, const std::shared_ptr<BlaeckHostPipe> &pipe);
+std::shared_ptr<BlaeckHostPipe> blaeckHostAccept(uint16_t port);
+
+// The host's end of one connection: what a PC client would hold
+class BlaeckLoopback
+{
+public:
+  // False if nothing listens on the port. The library sees the connection
+  // on its next accept, i.e. the next tick()/read().
+  bool connect(uint16_t port);
+  void close();
+  // False once the library dropped the connection or close() was called
+  bool isConnected() const { return _pipe != nullptr && _pipe->deviceOpen && _pipe->hostOpen; }
+
+  void send(const char *text);
+  void send(const uint8_t *data, size_t length);
+
+  // What the library wrote and the host has not read yet
+  size_t available() const { return _pipe != nullptr ? _pipe->toHost.size() : 0; }
+  size_t read(uint8_t *buffer, size_t size);
+  std::string readAll();
+  void discard();
+
+  // Bytes the library may have queued for the host before its writes come
+  // up short, as with a full socket buffer (default: no limit)
+  void setWindow(size_t bytes);
+  // Count what the library writes but drop it instead of queuing it, for
+  // benchmarks and load tests that only need the byte count
+  void setDiscard(bool on);
+  // Bytes the library wrote on this connection, read or not
+  unsigned long long bytesReceived() const { return _pipe != nullptr ? _pipe->bytesToHost : 0; }
+
+private:
+  std::shared_ptr<BlaeckHostPipe> _pipe;
+};
+
+// A Stream in memory: the library's debug output (Serial) or a serial
+// device behind a bridge. What the library writes is kept while capture is
+// on and printed to stdout while echo is on; feed() gives it bytes to read.
+class BlaeckHostStream : public Stream
+{
+public:
+  void setCapture(bool on) { _capture = on; }
+  void setEcho(bool on) { _echo = on; }
+  std::string &output() { return _output; }
+
+  void feed(const char *text) { feed((const uint8_t *)text, strlen(text)); }
+  void feed(const uint8_t *data, size_t length) { _input.insert(_input.end(), data, data + length); }
+
+  using Print::write;
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override;
+  int availableForWrite() override { return 4096; }
+  int available() override { return (int)_input.size(); }
+  int read() override;
+  int peek() override { return _input.empty() ? -1 : _input.front(); }
+
+private:
+  std::deque<uint8_t> _input;
+  std::string _output;
+  bool _capture = false;
+  bool _echo = false;
+};
+
+extern BlaeckHostStream Serial;
+
+#endif
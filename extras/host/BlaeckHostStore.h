@@ -0,0 +1,62 @@
+/*
+        File: BlaeckHostStore.h
+        Author: Sebastian Strobl
+
+        Host build: BlaeckFrameStore on one plain file, the stand-in for
+        BlaeckFSStore. The file outlives the program, so a second run
+        forwards what the first one stored, as after a reboot.
+
+        BlaeckHostFileStore store("blaeck.log");
+        device.setFrameStore(&store);
+*/
+
+#ifndef BLAECK_HOST_STORE_H
+#define BLAECK_HOST_STORE_H
+
+#include <BlaeckTCP.h>
+#include <stdio.h>
+#include <string>
+
+class BlaeckHostFileStore : public BlaeckFrameStore
+{
+public:
+  explicit BlaeckHostFileStore(const char *path) : _path(path) {}
+
+  bool append(const uint8_t *data, size_t len) override
+  {
+    FILE *file = fopen(_path.c_str(), "ab");
+    if (file == nullptr)
+      return false;
+    size_t written = fwrite(data, 1, len, file);
+    return fclose(file) == 0 && written == len;
+  }
+
+  size_t read(uint32_t offset, uint8_t *data, size_t len) override
+  {
+    FILE *file = fopen(_path.c_str(), "rb");
+    if (file == nullptr)
+      return 0;
+    size_t n = 0;
+    if (fseek(file, (long)offset, SEEK_SET) == 0)
+      n = fread(data, 1, len, file);
+    fclose(file);
+    return n;
+  }
+
+  uint32_t size() override
+  {
+    FILE *file = fopen(_path.c_str(), "rb");
+    if (file == nullptr)
+      return 0;
+    long end = (fseek(file, 0, SEEK_END) == 0) ? ftell(file) : 0;
+    fclose(file);
+    return end > 0 ? (uint32_t)end : 0;
+  }
+
+  void clear() override { remove(_path.c_str()); }
+
+private:
+  std::string _path;
+};
+
+#endif // BLAECK_HOST_STORE_H
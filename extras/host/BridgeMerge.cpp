@@ -0,0 +1,216 @@
+/*
+        File: BridgeMerge.cpp
+        Author: Sebastian Strobl
+
+        Host build example: a bridge with two serial devices behind it. The
+        devices are in-memory streams fed with the frames a device would
+        send; the host asks for the symbol and device list and gets data from
+        both. The host has to see one device: one symbol list with the
+        signals of both, data frames numbered into that list with its schema
+        hash and a valid CRC, and one device list with both entries.
+
+        extras/host/build.sh extras/host/BridgeMerge.cpp && ./BridgeMerge
+*/
+
+#include <BlaeckTCP.h>
+#include <BlaeckHost.h>
+#include "../BlaeckLoad/BlaeckDecoder.h"
+
+BlaeckTCP BlaeckTCP;
+BlaeckLoopback host;
+BlaeckHostStream deviceA; // signals "a" (float), "s" (string)
+BlaeckHostStream deviceB; // signals "x" (long), "y[0]" (byte)
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+  printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok)
+    failures++;
+}
+
+static std::string littleEndian(unsigned long long value, int bytes)
+{
+  std::string s;
+  for (int i = 0; i < bytes; i++)
+    s += (char)(value >> (8 * i));
+  return s;
+}
+
+// CRC16-CCITT as the devices compute their schema hash
+static uint16_t schemaHash(const std::string &namesAndTypes)
+{
+  uint16_t crc = 0;
+  for (unsigned char b : namesAndTypes)
+  {
+    crc ^= (uint16_t)(b << 8);
+    for (int k = 0; k < 8; k++)
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+static void sendFrame(BlaeckHostStream &device, uint8_t key, uint32_t msgId, const std::string &payload, bool crc,
+                      bool damaged = false)
+{
+  std::string frame;
+  frame += (char)key;
+  frame += ':';
+  frame += littleEndian(msgId, 4);
+  frame += ':';
+  frame += payload;
+  if (crc)
+    frame += littleEndian(BlaeckDecoder::crc32((const uint8_t *)frame.data(), frame.size()), 4);
+  if (damaged)
+    frame[frame.size() - 5] ^= 0x01; // a status payload bit
+  frame = "<BLAECK:" + frame + "/BLAECK>\r\n";
+  device.feed((const uint8_t *)frame.data(), frame.size());
+}
+
+static std::string symbol(const char *name, uint8_t type)
+{
+  return std::string("\0\0", 2) + name + '\0' + (char)type;
+}
+
+static std::string deviceEntry(const char *name)
+{
+  std::string s("\x01\x00\x00", 3);
+  const char *fields[] = {name, "hw", "fw", "1.0", "BlaeckSerial", "0", "server", "0", "0", "1", "", ""};
+  for (const char *field : fields)
+    s += std::string(field) + '\0';
+  return s;
+}
+
+// restart(1) : hash(2) : tsMode(1) [timestamp(8)] : values status(1) payload(4)
+static std::string dataPayload(uint16_t hash, bool timestamp, const std::string &values)
+{
+  std::string s("\0:", 2);
+  s += littleEndian(hash, 2) + ":";
+  s += timestamp ? std::string("\x01", 1) + littleEndian(123456, 8) : std::string("\0", 1);
+  s += ":" + values + std::string(5, '\0');
+  return s;
+}
+
+static std::vector<BlaeckDecodedFrame> readFrames(BlaeckDecoder &decoder)
+{
+  std::string bytes = host.readAll();
+  decoder.feed((const uint8_t *)bytes.data(), bytes.size());
+  std::vector<BlaeckDecodedFrame> frames;
+  BlaeckDecodedFrame frame;
+  while (decoder.next(frame))
+    frames.push_back(frame);
+  return frames;
+}
+
+int main()
+{
+  BlaeckTCP.beginBridge(2, &Serial, &deviceA, 23);
+  BlaeckTCP.addBridgeDevice(&deviceB, 2);
+  BlaeckTCP.setBridgeFrameAware(true);
+  deviceA.setCapture(true);
+  deviceB.setCapture(true);
+
+  BlaeckDecoder decoder;
+  host.connect(23);
+  BlaeckTCP.bridgePoll();
+  host.send("<BLAECK.WRITE_SYMBOLS,7,0,0,0>");
+  BlaeckTCP.bridgePoll();
+  check(deviceA.output() == "<BLAECK.WRITE_SYMBOLS,7,0,0,0>" && deviceB.output() == deviceA.output(),
+        "symbol request reaches both devices");
+
+  // The second device answers first; nothing goes out until both have
+  std::string symbolsA = symbol("a", Blaeck_float) + symbol("s", Blaeck_string);
+  std::string symbolsB = symbol("x", Blaeck_long) + symbol("y[0]", Blaeck_byte);
+  sendFrame(deviceB, 0xB0, 7, symbolsB, false);
+  BlaeckTCP.bridgePoll();
+  check(readFrames(decoder).empty(), "symbol list held until every device answered");
+  sendFrame(deviceA, 0xB0, 7, symbolsA, false);
+  BlaeckTCP.bridgePoll();
+  std::vector<BlaeckDecodedFrame> frames = readFrames(decoder);
+  std::vector<BlaeckDecodedSymbol> symbols;
+  check(frames.size() == 1 && frames[0].key == 0xB0 && frames[0].msgId == 7 &&
+            BlaeckDecoder::parseSymbols(frames[0], symbols),
+        "one symbol frame with the request's message id");
+  check(symbols.size() == 4 && symbols[0].name == "a" && symbols[1].name == "s" && symbols[2].name == "x" &&
+            symbols[3].name == "y[0]",
+        "merged symbol list: 4 symbols, device after device");
+
+  std::string merged;
+  for (const BlaeckDecodedSymbol &s : symbols)
+    merged += s.name + (char)s.type;
+  uint16_t hashA = schemaHash(std::string("a") + (char)Blaeck_float + "s" + (char)Blaeck_string);
+  uint16_t hashB = schemaHash(std::string("x") + (char)Blaeck_long + "y[0]" + (char)Blaeck_byte);
+
+  // Each device numbers its signals from 0 under its own hash
+  float a = 1.5f;
+  std::string valuesA = littleEndian(0, 2) + std::string((const char *)&a, 4) + littleEndian(1, 2) + "\x03" "abc";
+  std::string valuesB = littleEndian(0, 2) + littleEndian((unsigned long)-7L, 4) + littleEndian(1, 2) + "\x09";
+  sendFrame(deviceA, 0xD2, 1, dataPayload(hashA, false, valuesA), true);
+  sendFrame(deviceB, 0xD2, 1, dataPayload(hashB, true, valuesB), true);
+  BlaeckTCP.bridgePoll();
+  frames = readFrames(decoder);
+  check(frames.size() == 2 && decoder.crcErrors == 0, "both data frames arrive with a valid CRC32");
+  BlaeckDecodedData dataA = BlaeckDecodedData();
+  BlaeckDecodedData dataB = BlaeckDecodedData();
+  bool parsedA = frames.size() == 2 && BlaeckDecoder::parseData(frames[0], symbols, dataA);
+  bool parsedB = frames.size() == 2 && BlaeckDecoder::parseData(frames[1], symbols, dataB);
+  // The devices take turns, so either may come first; only the second sends a timestamp
+  if (dataA.timestampMode != 0)
+    std::swap(dataA, dataB);
+  check(parsedA && parsedB && dataA.schemaHash == schemaHash(merged) && dataB.schemaHash == schemaHash(merged),
+        "data frames carry the merged list's schema hash");
+  check(parsedA && dataA.values.size() == 2 && dataA.values[0].index == 0 && dataA.values[0].number == 1.5 &&
+            dataA.values[1].index == 1 && dataA.values[1].text == "abc",
+        "first device's indices unchanged");
+  check(parsedB && dataB.values.size() == 2 && dataB.values[0].index == 2 && dataB.values[0].number == -7 &&
+            dataB.values[1].index == 3 && dataB.values[1].number == 9 && dataB.timestamp == 123456,
+        "second device's indices moved up by 2");
+
+  // A frame damaged on the serial line is not passed on with a new CRC
+  uint32_t overflows = BlaeckTCP.getBridgeOverflowsToClients();
+  std::string damaged = dataPayload(hashB, false, valuesB);
+  sendFrame(deviceB, 0xD2, 1, damaged, true, true);
+  BlaeckTCP.bridgePoll();
+  check(readFrames(decoder).empty() && decoder.crcErrors == 0 && BlaeckTCP.getBridgeOverflowsToClients() > overflows,
+        "damaged data frame dropped");
+
+  host.send("<BLAECK.GET_DEVICES,9,0,0,0>");
+  BlaeckTCP.bridgePoll();
+  sendFrame(deviceA, 0xB6, 9, deviceEntry("A"), false);
+  sendFrame(deviceB, 0xB6, 9, deviceEntry("B"), false);
+  BlaeckTCP.bridgePoll();
+  frames = readFrames(decoder);
+  check(frames.size() == 1 && frames[0].key == 0xB6 && frames[0].payload[0] == 2, "one device frame with 2 entries");
+
+  // Asked again: the merged list from the cache, again one frame
+  host.send("<BLAECK.WRITE_SYMBOLS,10,0,0,0>");
+  BlaeckTCP.bridgePoll();
+  frames = readFrames(decoder);
+  check(frames.size() == 1 && frames[0].key == 0xB0 && frames[0].msgId == 10 &&
+            BlaeckDecoder::parseSymbols(frames[0], symbols) && symbols.size() == 4,
+        "repeat request answered from the cache with the merged list");
+
+  // The second device restarts (its cached list is dropped) and then does
+  // not answer: a list without its symbols would not match the indices of
+  // the data, so none is sent
+  std::string restarted = dataPayload(hashB, false, valuesB);
+  restarted[0] = 1;
+  sendFrame(deviceB, 0xD2, 1, restarted, true);
+  BlaeckTCP.bridgePoll();
+  readFrames(decoder);
+  host.send("<BLAECK.WRITE_SYMBOLS,11,0,0,0>");
+  BlaeckTCP.bridgePoll();
+  sendFrame(deviceA, 0xB0, 11, symbolsA, false);
+  BlaeckTCP.bridgePoll();
+  BlaeckHostClock::advance((BLAECK_BRIDGE_REQUEST_TIMEOUT_MS + 1) * 1000ULL);
+  sendFrame(deviceA, 0xB0, 12, symbolsA, false);
+  BlaeckTCP.bridgePoll();
+  frames = readFrames(decoder);
+  check(frames.empty(), "no symbol list while a device's list is missing");
+
+  host.close();
+  BlaeckTCP.bridgePoll();
+  printf("%s\n", failures == 0 ? "all checks passed" : "checks failed");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,62 @@
+/*
+        File: CRC.h
+        Author: Sebastian Strobl
+
+        Host build (extras/host): the CRC32 class of the CRC library, with the
+        setters BlaeckTCP calls. Bitwise, like the library.
+*/
+
+#ifndef BLAECK_HOST_CRC_H
+#define BLAECK_HOST_CRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class CRC32
+{
+public:
+  void setPolynome(uint32_t polynome) { _polynome = polynome; }
+  void setInitial(uint32_t initial) { _initial = initial; }
+  void setXorOut(uint32_t xorOut) { _xorOut = xorOut; }
+  void setReverseIn(bool reverseIn) { _reverseIn = reverseIn; }
+  void setReverseOut(bool reverseOut) { _reverseOut = reverseOut; }
+  void restart() { _crc = _initial; }
+
+  void add(uint8_t value)
+  {
+    if (_reverseIn)
+      value = (uint8_t)_reverse(value, 8);
+    _crc ^= (uint32_t)value << 24;
+    for (byte bit = 0; bit < 8; bit++)
+      _crc = (_crc & 0x80000000UL) ? (_crc << 1) ^ _polynome : (_crc << 1);
+  }
+  void add(const uint8_t *array, size_t length)
+  {
+    while (length--)
+      add(*array++);
+  }
+
+  uint32_t calc() const { return (_reverseOut ? _reverse(_crc, 32) : _crc) ^ _xorOut; }
+
+private:
+  typedef uint8_t byte;
+  static uint32_t _reverse(uint32_t value, byte bits)
+  {
+    uint32_t result = 0;
+    for (byte i = 0; i < bits; i++)
+    {
+      result = (result << 1) | (value & 1);
+      value >>= 1;
+    }
+    return result;
+  }
+
+  uint32_t _polynome = 0x04C11DB7;
+  uint32_t _initial = 0xFFFFFFFF;
+  uint32_t _xorOut = 0xFFFFFFFF;
+  uint32_t _crc = 0xFFFFFFFF;
+  bool _reverseIn = true;
+  bool _reverseOut = true;
+};
+
+#endif
@@ -0,0 +1,75 @@
+/*
+        File: Loopback.cpp
+        Author: Sebastian Strobl
+
+        Host build example: one simulated host connects over the loopback,
+        asks for the device and symbol list, starts timed data and lets a
+        second of fake time pass. Every frame it gets is listed with its key,
+        message id and size.
+
+        extras/host/build.sh extras/host/Loopback.cpp && ./Loopback
+*/
+
+#include <BlaeckTCP.h>
+#include <BlaeckHost.h>
+
+BlaeckTCP BlaeckTCP;
+BlaeckLoopback host;
+
+float temperature = 21.5;
+long counter = 0;
+
+static void printFrames(const char *step)
+{
+  std::string bytes = host.readAll();
+  printf("%s: %u bytes\n", step, (unsigned int)bytes.size());
+
+  size_t pos = 0;
+  while ((pos = bytes.find("<BLAECK:", pos)) != std::string::npos && pos + 14 <= bytes.size())
+  {
+    size_t end = bytes.find("/BLAECK>\r\n", pos);
+    if (end == std::string::npos)
+      break;
+    uint32_t msgId = (uint8_t)bytes[pos + 10] | ((uint8_t)bytes[pos + 11] << 8) |
+                     ((uint8_t)bytes[pos + 12] << 16) | ((uint32_t)(uint8_t)bytes[pos + 13] << 24);
+    printf("  0x%02X  msg id %lu  %u bytes\n", (uint8_t)bytes[pos + 8], (unsigned long)msgId,
+           (unsigned int)(end + 10 - pos));
+    pos = end + 10;
+  }
+}
+
+int main()
+{
+  Serial.setEcho(true);
+
+  BlaeckTCP.begin(2, &Serial, 2, 23);
+  BlaeckTCP.DeviceName = "Host";
+  BlaeckTCP.addSignal("temperature", &temperature);
+  BlaeckTCP.addSignal("counter", &counter);
+
+  host.connect(23);
+  BlaeckTCP.tick();
+  printFrames("connect");
+
+  host.send("<BLAECK.GET_DEVICES,1,0,0,0,Loopback,example>");
+  BlaeckTCP.tick();
+  printFrames("BLAECK.GET_DEVICES");
+
+  host.send("<BLAECK.WRITE_SYMBOLS,2,0,0,0>");
+  BlaeckTCP.tick();
+  printFrames("BLAECK.WRITE_SYMBOLS");
+
+  // 100 ms interval
+  host.send("<BLAECK.ACTIVATE,100,0,0,0>");
+  for (int ms = 0; ms < 1000; ms += 10)
+  {
+    counter++;
+    BlaeckTCP.tick();
+    BlaeckHostClock::advance(10000);
+  }
+  printFrames("1 s of BLAECK.ACTIVATE,100");
+
+  host.close();
+  BlaeckTCP.tick();
+  return 0;
+}
@@ -0,0 +1,128 @@
+/*
+        File: SignalArray.cpp
+        Author: Sebastian Strobl
+
+        Host build example: signals added as arrays. Every element becomes a
+        signal of its own, named "base[element]", between plain signals; an
+        array that does not fit is not added at all. The symbol list and the
+        data frames are decoded and checked for the element names, indices,
+        values, schema hash and CRC.
+
+        extras/host/build.sh extras/host/SignalArray.cpp && ./SignalArray
+*/
+
+#include <BlaeckTCP.h>
+#include <BlaeckHost.h>
+#include "../BlaeckLoad/BlaeckDecoder.h"
+
+BlaeckTCP BlaeckTCP;
+BlaeckLoopback host;
+
+float before = 0.5f;
+short adc[4] = {100, -200, 300, -400};
+float temps[2] = {21.25f, 22.5f};
+long big[3];
+long after = 123456;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+  printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok)
+    failures++;
+}
+
+// CRC16-CCITT of names and type codes, as the library computes its schema hash
+static uint16_t schemaHash(const std::vector<BlaeckDecodedSymbol> &symbols)
+{
+  uint16_t crc = 0;
+  for (const BlaeckDecodedSymbol &s : symbols)
+  {
+    std::string bytes = s.name + (char)s.type;
+    for (unsigned char b : bytes)
+    {
+      crc ^= (uint16_t)(b << 8);
+      for (int k = 0; k < 8; k++)
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+static std::vector<BlaeckDecodedFrame> readFrames(BlaeckDecoder &decoder)
+{
+  std::string bytes = host.readAll();
+  decoder.feed((const uint8_t *)bytes.data(), bytes.size());
+  std::vector<BlaeckDecodedFrame> frames;
+  BlaeckDecodedFrame frame;
+  while (decoder.next(frame))
+    frames.push_back(frame);
+  return frames;
+}
+
+int main()
+{
+  BlaeckTCP.begin(1, &Serial, 8, 23);
+  BlaeckTCP.addSignal("before", &before);
+  int adcFirst = BlaeckTCP.addSignalArray("adc", adc, 4);
+  int tempFirst = BlaeckTCP.addSignalArray(F("temp"), temps, 2);
+  // One slot is left: all of the three elements or none
+  int bigFirst = BlaeckTCP.addSignalArray("big", big, 3);
+  BlaeckTCP.addSignal("after", &after);
+  check(adcFirst == 1 && tempFirst == 5, "addSignalArray returns the index of element 0");
+  check(bigFirst == -1 && BlaeckTCP.hasSignalOverflow() && BlaeckTCP.SignalCount == 8,
+        "an array that does not fit adds nothing");
+
+  BlaeckDecoder decoder;
+  host.connect(23);
+  BlaeckTCP.tick();
+  readFrames(decoder);
+  host.send("<BLAECK.WRITE_SYMBOLS,1,0,0,0>");
+  BlaeckTCP.tick();
+  std::vector<BlaeckDecodedFrame> frames = readFrames(decoder);
+  std::vector<BlaeckDecodedSymbol> symbols;
+  bool parsed = frames.size() == 1 && BlaeckDecoder::parseSymbols(frames[0], symbols);
+  const char *names[] = {"before", "adc[0]", "adc[1]", "adc[2]", "adc[3]", "temp[0]", "temp[1]", "after"};
+  const uint8_t types[] = {Blaeck_float, Blaeck_short, Blaeck_short, Blaeck_short,
+                           Blaeck_short, Blaeck_float, Blaeck_float, Blaeck_long};
+  bool symbolsMatch = parsed && symbols.size() == 8;
+  for (size_t i = 0; symbolsMatch && i < 8; i++)
+    symbolsMatch = symbols[i].name == names[i] && symbols[i].type == types[i];
+  check(symbolsMatch, "symbol list names every element, in order, with its type");
+
+  host.send("<BLAECK.WRITE_DATA,2,0,0,0>");
+  BlaeckTCP.tick();
+  frames = readFrames(decoder);
+  BlaeckDecodedData data = BlaeckDecodedData();
+  parsed = frames.size() == 1 && BlaeckDecoder::parseData(frames[0], symbols, data);
+  check(parsed && frames[0].msgId == 2 && decoder.crcErrors == 0, "one data frame with a valid CRC32");
+  const double values[] = {0.5, 100, -200, 300, -400, 21.25, 22.5, 123456};
+  bool valuesMatch = parsed && data.values.size() == 8;
+  for (size_t i = 0; valuesMatch && i < 8; i++)
+    valuesMatch = data.values[i].index == i && data.values[i].number == values[i];
+  check(valuesMatch, "every element's value at its own index");
+  check(parsed && data.schemaHash == schemaHash(symbols), "schema hash over the element names");
+
+  // Elements are found by their full name
+  BlaeckTCP.update("adc[2]", (short)-5);
+  BlaeckTCP.writeUpdatedData(3);
+  frames = readFrames(decoder);
+  parsed = frames.size() == 1 && BlaeckDecoder::parseData(frames[0], symbols, data);
+  check(parsed && adc[2] == -5 && data.values.size() == 1 && data.values[0].index == 3 &&
+            data.values[0].number == -5,
+        "update(\"adc[2]\") marks only that element");
+  BlaeckTCP.write("temp[1]", 9.75f, 4);
+  frames = readFrames(decoder);
+  parsed = frames.size() == 1 && BlaeckDecoder::parseData(frames[0], symbols, data);
+  check(parsed && data.values.size() == 1 && data.values[0].index == 6 && data.values[0].number == 9.75 &&
+            decoder.crcErrors == 0,
+        "write(\"temp[1]\") sends only that element");
+  BlaeckTCP.write("temp", 1.0f, 5);
+  check(readFrames(decoder).empty(), "the base name alone is no signal");
+
+  host.close();
+  BlaeckTCP.tick();
+  printf("%s\n", failures == 0 ? "all checks passed" : "checks failed");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+/*
+        File: Snapshot.cpp
+        Author: Sebastian Strobl
+
+        Host build example: data frames taken from snapshots. In manual mode
+        frames carry the values of the last snapshot() even after the
+        variables changed; in auto mode every frame takes its own. A write()
+        of one signal sends its live value. The frames are decoded and
+        checked for their indices, values, schema hash and CRC.
+
+        extras/host/build.sh extras/host/Snapshot.cpp && ./Snapshot
+*/
+
+#include <BlaeckTCP.h>
+#include <BlaeckHost.h>
+#include "../BlaeckLoad/BlaeckDecoder.h"
+
+BlaeckTCP BlaeckTCP;
+BlaeckLoopback host;
+
+double position = 1.25;
+long ticks = 10;
+char label[64] = "start";
+float extra = 0.5f;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+  printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok)
+    failures++;
+}
+
+// CRC16-CCITT of names and type codes, as the library computes its schema hash
+static uint16_t schemaHash(const std::vector<BlaeckDecodedSymbol> &symbols)
+{
+  uint16_t crc = 0;
+  for (const BlaeckDecodedSymbol &s : symbols)
+  {
+    std::string bytes = s.name + (char)s.type;
+    for (unsigned char b : bytes)
+    {
+      crc ^= (uint16_t)(b << 8);
+      for (int k = 0; k < 8; k++)
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+static std::vector<BlaeckDecodedFrame> readFrames(BlaeckDecoder &decoder)
+{
+  std::string bytes = host.readAll();
+  decoder.feed((const uint8_t *)bytes.data(), bytes.size());
+  std::vector<BlaeckDecodedFrame> frames;
+  BlaeckDecodedFrame frame;
+  while (decoder.next(frame))
+    frames.push_back(frame);
+  return frames;
+}
+
+static std::vector<BlaeckDecodedSymbol> readSymbols(BlaeckDecoder &decoder)
+{
+  host.send("<BLAECK.WRITE_SYMBOLS,1,0,0,0>");
+  BlaeckTCP.tick();
+  std::vector<BlaeckDecodedFrame> frames = readFrames(decoder);
+  std::vector<BlaeckDecodedSymbol> symbols;
+  if (frames.size() != 1 || !BlaeckDecoder::parseSymbols(frames[0], symbols))
+    symbols.clear();
+  return symbols;
+}
+
+// One frame of all signals, decoded
+static bool readAllData(BlaeckDecoder &decoder, const std::vector<BlaeckDecodedSymbol> &symbols, BlaeckDecodedData &data)
+{
+  BlaeckTCP.writeAllData(2);
+  std::vector<BlaeckDecodedFrame> frames = readFrames(decoder);
+  return frames.size() == 1 && frames[0].msgId == 2 && BlaeckDecoder::parseData(frames[0], symbols, data) &&
+         data.values.size() == symbols.size() && decoder.crcErrors == 0 && data.schemaHash == schemaHash(symbols);
+}
+
+static bool valuesAre(const BlaeckDecodedData &data, double p, long t, const char *l)
+{
+  return data.values[0].index == 0 && data.values[0].number == p && data.values[1].index == 1 &&
+         data.values[1].number == t && data.values[2].index == 2 && data.values[2].text == l;
+}
+
+int main()
+{
+  BlaeckTCP.begin(1, &Serial, 4, 23);
+  BlaeckTCP.addSignal("position", &position);
+  BlaeckTCP.addSignal("ticks", &ticks);
+  BlaeckTCP.addSignal("label", label);
+  check(!BlaeckTCP.snapshot(), "snapshot() does nothing while snapshots are off");
+  check(BlaeckTCP.setSnapshotMode(BLAECK_SNAPSHOT_MANUAL), "manual snapshots allocated");
+
+  BlaeckDecoder decoder;
+  host.connect(23);
+  BlaeckTCP.tick();
+  readFrames(decoder);
+  std::vector<BlaeckDecodedSymbol> symbols = readSymbols(decoder);
+  check(symbols.size() == 3, "symbol list with 3 signals");
+
+  // Before the first snapshot the frames read the variables
+  BlaeckDecodedData data = BlaeckDecodedData();
+  bool parsed = readAllData(decoder, symbols, data);
+  check(parsed && valuesAre(data, 1.25, 10, "start"), "no snapshot yet: the live values");
+
+  check(BlaeckTCP.snapshot(), "snapshot taken");
+  position = -3.5;
+  ticks = 11;
+  strcpy(label, "moved");
+  parsed = readAllData(decoder, symbols, data);
+  check(parsed && valuesAre(data, 1.25, 10, "start"), "changed variables: the snapshot's values");
+  parsed = readAllData(decoder, symbols, data);
+  check(parsed && valuesAre(data, 1.25, 10, "start"), "every frame until the next snapshot");
+
+  // A single write sends the value it is given, not the snapshot
+  BlaeckTCP.write("ticks", 12L, 3);
+  std::vector<BlaeckDecodedFrame> frames = readFrames(decoder);
+  parsed = frames.size() == 1 && BlaeckDecoder::parseData(frames[0], symbols, data);
+  check(parsed && data.values.size() == 1 && data.values[0].index == 1 && data.values[0].number == 12,
+        "write() of one signal sends its live value");
+
+  // Strings are cut to BLAECK_SNAPSHOT_STRING_MAX in the snapshot
+  memset(label, 'x', sizeof(label) - 1);
+  label[sizeof(label) - 1] = '\0';
+  check(BlaeckTCP.snapshot(), "second snapshot taken");
+  parsed = readAllData(decoder, symbols, data);
+  check(parsed && valuesAre(data, -3.5, 12, std::string(BLAECK_SNAPSHOT_STRING_MAX, 'x').c_str()),
+        "next snapshot: the new values, the string cut to BLAECK_SNAPSHOT_STRING_MAX");
+
+  // A new signal outdates the snapshot: live values until the next one
+  strcpy(label, "grown");
+  BlaeckTCP.addSignal("extra", &extra);
+  symbols = readSymbols(decoder);
+  parsed = symbols.size() == 4 && readAllData(decoder, symbols, data);
+  check(parsed && valuesAre(data, -3.5, 12, "grown") && data.values[3].index == 3 && data.values[3].number == 0.5,
+        "after addSignal: the live values of all 4 signals");
+
+  // Auto: every frame takes its own snapshot
+  check(BlaeckTCP.setSnapshotMode(BLAECK_SNAPSHOT_AUTO), "auto snapshots allocated");
+  ticks = 20;
+  parsed = readAllData(decoder, symbols, data);
+  check(parsed && data.values[1].number == 20, "auto: the values at the frame");
+  ticks = 21;
+  parsed = readAllData(decoder, symbols, data);
+  check(parsed && data.values[1].number == 21, "auto: the next frame, the next values");
+
+  host.close();
+  BlaeckTCP.tick();
+  printf("%s\n", failures == 0 ? "all checks passed" : "checks failed");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+/*
+        File: StoreForward.cpp
+        Author: Sebastian Strobl
+
+        Host build example: store-and-forward across a lost connection. The
+        host starts timed data and drops off; for a second the frames (with
+        120 signals each, larger than one store page) go to a file. After the
+        reconnect tick() forwards them oldest first, as fast as the slow host
+        takes them, until the log is drained.
+
+        extras/host/build.sh extras/host/StoreForward.cpp && ./StoreForward
+*/
+
+#include <BlaeckTCP.h>
+#include <BlaeckHost.h>
+#include <BlaeckHostStore.h>
+
+BlaeckTCP BlaeckTCP;
+BlaeckLoopback host;
+BlaeckHostFileStore store("StoreForward.log");
+
+float values[120];
+
+static unsigned int countFrames(const std::string &bytes, uint8_t key)
+{
+  unsigned int frames = 0;
+  size_t pos = 0;
+  while ((pos = bytes.find("<BLAECK:", pos)) != std::string::npos && pos + 8 < bytes.size())
+  {
+    size_t end = bytes.find("/BLAECK>\r\n", pos);
+    if (end == std::string::npos)
+      break;
+    if ((uint8_t)bytes[pos + 8] == key)
+      frames++;
+    pos = end + 10;
+  }
+  return frames;
+}
+
+static void run(unsigned int ms)
+{
+  for (unsigned int t = 0; t < ms; t += 10)
+  {
+    for (unsigned int i = 0; i < 120; i++)
+      values[i] += 0.5f;
+    BlaeckTCP.tick();
+    BlaeckHostClock::advance(10000);
+  }
+}
+
+int main()
+{
+  store.clear();
+
+  BlaeckTCP.begin(2, &Serial, 120, 23);
+  BlaeckTCP.DeviceName = "Host";
+  BlaeckTCP.addSignalArray("value", values, 120);
+  BlaeckTCP.setFrameStore(&store);
+
+  host.connect(23);
+  BlaeckTCP.tick();
+  host.send("<BLAECK.ACTIVATE,100,0,0,0>");
+  run(500);
+  printf("connected: %u data frames\n", countFrames(host.readAll(), 0xD2));
+
+  host.close();
+  run(1000);
+  BlaeckTCP.flushFrameStore();
+  printf("disconnected: %lu bytes stored in %lu bytes of file\n",
+         (unsigned long)BlaeckTCP.getFrameStorePending(), (unsigned long)store.size());
+
+  // A slow host: not much more than one frame fits its socket at a time,
+  // so the log has to wait for room instead of being written past it
+  host.connect(23);
+  host.setWindow(1000);
+  unsigned int forwarded = 0;
+  unsigned int ticks = 0;
+  while (BlaeckTCP.getFrameStorePending() > 0 && ticks < 1000)
+  {
+    BlaeckTCP.tick();
+    forwarded += countFrames(host.readAll(), 0xD2);
+    ticks++;
+  }
+  printf("reconnected: %u data frames in %u ticks\n", forwarded, ticks);
+
+  unsigned long pending = BlaeckTCP.getFrameStorePending();
+  unsigned long lost = BlaeckTCP.getFrameStoreLostCount();
+  printf("pending %lu, lost %lu\n", pending, lost);
+
+  host.close();
+  BlaeckTCP.tick();
+  store.clear();
+  // One second at 100 ms: ten stored frames, all of them delivered
+  return (pending == 0 && lost == 0 && forwarded >= 10) ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+/*
+        File: TelnetPrint.h
+        Author: Sebastian Strobl
+
+        Host build (extras/host): NetServer and NetClient of the TelnetStream
+        library on top of the loopback of BlaeckHost.h.
+*/
+
+#ifndef BLAECK_HOST_TELNETPRINT_H
+#define BLAECK_HOST_TELNETPRINT_H
+
+#include <BlaeckHost.h>
+
+// The library's end of one loopback connection
+class NetClient : public Stream
+{
+public:
+  NetClient() {}
+  explicit NetClient(const std::shared_ptr<BlaeckHostPipe> &pipe) : _pipe(pipe) {}
+
+  using Print::write;
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override
+  {
+    if (!connected() || !_pipe->hostOpen)
+      return 0;
+    size_t room = _pipe->window > _pipe->toHost.size() ? _pipe->window - _pipe->toHost.size() : 0;
+    if (size > room)
+      size = room;
+    _pipe->bytesToHost += size;
+    if (!_pipe->discard)
+      _pipe->toHost.insert(_pipe->toHost.end(), buffer, buffer + size);
+    return size;
+  }
+  int availableForWrite() override
+  {
+    if (!connected())
+      return 0;
+    size_t room = _pipe->window > _pipe->toHost.size() ? _pipe->window - _pipe->toHost.size() : 0;
+    return room > 1460 ? 1460 : (int)room;
+  }
+
+  int available() override { return _pipe != nullptr ? (int)_pipe->toDevice.size() : 0; }
+  int read() override
+  {
+    if (available() == 0)
+      return -1;
+    int c = _pipe->toDevice.front();
+    _pipe->toDevice.pop_front();
+    return c;
+  }
+  int read(uint8_t *buffer, size_t size)
+  {
+    size_t count = 0;
+    while (count < size && available() > 0)
+      buffer[count++] = (uint8_t)read();
+    return (int)count;
+  }
+  int peek() override { return available() > 0 ? _pipe->toDevice.front() : -1; }
+
+  // Like a TCP socket: still connected while unread bytes remain after the
+  // host closed its end
+  uint8_t connected() { return _pipe != nullptr && _pipe->deviceOpen && (_pipe->hostOpen || !_pipe->toDevice.empty()); }
+  void stop()
+  {
+    if (_pipe != nullptr)
+      _pipe->deviceOpen = false;
+    _pipe.reset();
+  }
+  void setNoDelay(bool) {}
+  IPAddress remoteIP() { return IPAddress(127, 0, 0, 1); }
+  uint16_t remotePort() { return 50000; }
+
+  explicit operator bool() const { return _pipe != nullptr; }
+  bool operator==(const NetClient &other) const { return _pipe == other._pipe; }
+  bool operator!=(const NetClient &other) const { return _pipe != other._pipe; }
+
+private:
+  std::shared_ptr<BlaeckHostPipe> _pipe;
+};
+
+class NetServer
+{
+public:
+  explicit NetServer(uint16_t port = 23) : _port(port) {}
+  void begin() { blaeckHostListen(_port); }
+  void setNoDelay(bool) {}
+  NetClient accept() { return NetClient(blaeckHostAccept(_port)); }
+  NetClient available() { return accept(); }
+
+private:
+  uint16_t _port;
+};
+
+extern NetServer TelnetPrint;
+
+#endif
@@ -0,0 +1,20 @@
+/*
+        File: Udp.h
+        Author: Sebastian Strobl
+
+        Host build (extras/host): the UDP interface of the Arduino core.
+*/
+
+#ifndef BLAECK_HOST_UDP_H
+#define BLAECK_HOST_UDP_H
+
+#include <Arduino.h>
+
+class UDP : public Stream
+{
+public:
+  virtual int beginPacket(IPAddress ip, uint16_t port) = 0;
+  virtual int endPacket() = 0;
+};
+
+#endif
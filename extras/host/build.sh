@@ -0,0 +1,34 @@
+#!/bin/sh
+# Builds a program against src/BlaeckTCP.cpp and the host shim in this folder.
+#
+#   extras/host/build.sh extras/host/Loopback.cpp          -> ./Loopback
+#   extras/host/build.sh prog.cpp more.cpp -o prog
+#   CXXFLAGS="-O0 -g -fsanitize=address" extras/host/build.sh prog.cpp
+#
+# Library settings go in CXXFLAGS too (-DBLAECK_ENABLE_TRACE=1, ...); they
+# reach every translation unit.
+set -e
+
+HOST=$(cd "$(dirname "$0")" && pwd)
+SRC=$(cd "$HOST/../../src" && pwd)
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--O2 -g}
+
+out=""
+first=""
+files=""
+while [ $# -gt 0 ]; do
+  case $1 in
+    -o) out=$2; shift 2 ;;
+    *) [ -n "$first" ] || first=$1; files="$files $1"; shift ;;
+  esac
+done
+if [ -z "$first" ]; then
+  echo "usage: $0 program.cpp [more.cpp ...] [-o output]" >&2
+  exit 1
+fi
+[ -n "$out" ] || out=$(basename "$first" .cpp)
+
+# shellcheck disable=SC2086
+$CXX -std=gnu++11 -DBLAECK_HOST $CXXFLAGS -Wall -Wextra -Wno-unused-parameter \
+  -I"$HOST" -I"$SRC" "$SRC/BlaeckTCP.cpp" "$HOST/BlaeckHost.cpp" $files -o "$out"
@@ -4,18 +4,94 @@
 */
 
 #include "BlaeckTCP.h"
+#if BLAECK_ASYNC_TCP
+  #if defined(ESP32)
+    #include <AsyncTCP.h>
+  #else
+    #include <ESPAsyncTCP.h>
+  #endif
+#endif
+#if defined(ESP32)
+  #include <driver/uart.h>
+#endif
+
+#if BLAECK_ENABLE_STATS
+// Adds the time until the end of the enclosing block to a timer
+struct BlaeckTimerScope
+{
+  BlaeckTimer &timer;
+  unsigned long start_us;
+  explicit BlaeckTimerScope(BlaeckTimer &t) : timer(t), start_us(micros()) {}
+  ~BlaeckTimerScope() { timer.add(micros() - start_us); }
+};
+  #define BLAECK_STATS_TIME(timer) BlaeckTimerScope _statsScope(_stats.timer)
+  #define BLAECK_STATS_COUNT(counter) (_stats.counter++)
+#else
+  #define BLAECK_STATS_TIME(timer)
+  #define BLAECK_STATS_COUNT(counter) ((void)0)
+#endif
+
+#if BLAECK_ENABLE_TRACE
+// The fastest free-running counter there is
+static inline uint32_t blaeckTraceClock()
+{
+  #if defined(ESP32) || defined(ESP8266)
+  return ESP.getCycleCount();
+  #elif defined(DWT_CTRL_CYCCNTENA_Msk)
+  return DWT->CYCCNT;
+  #else
+  return micros();
+  #endif
+}
+
+// Records the begin event now and the end event at the end of the enclosing block
+struct BlaeckTraceScope
+{
+  BlaeckTCP *owner;
+  byte point;
+  BlaeckTraceScope(BlaeckTCP *o, byte p) : owner(o), point(p) { owner->_traceRecord(point, false); }
+  ~BlaeckTraceScope() { owner->_traceRecord(point, true); }
+};
+  #define BLAECK_TRACE_SCOPE(point) BlaeckTraceScope _traceScope(this, point)
+  #define BLAECK_TRACE_BEGIN(point) _traceRecord(point, false)
+  #define BLAECK_TRACE_END(point) _traceRecord(point, true)
+#else
+  #define BLAECK_TRACE_SCOPE(point)
+  #define BLAECK_TRACE_BEGIN(point) ((void)0)
+  #define BLAECK_TRACE_END(point) ((void)0)
+#endif
 
 BlaeckTCP::BlaeckTCP()
 {
   validatePlatformSizes();
+#if BLAECK_ENABLE_TRACE && !defined(ESP32) && !defined(ESP8266) && defined(DWT_CTRL_CYCCNTENA_Msk)
+  // The DWT cycle counter is off after reset
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
 }
 
 BlaeckTCP::~BlaeckTCP()
 {
-  delete[] Signals;
-  Signals = nullptr;
-  delete[] Clients;
-  Clients = nullptr;
+#if BLAECK_NETWORK_TASK
+  stopNetworkTask();
+#endif
+#if BLAECK_ASYNC_TCP
+  _asyncEnd();
+#endif
+  _freeSnapshot();
+  _storePage.release();
+  _freeSignalTable();
+  _freeClientTable();
+  delete[] _bridgeCommands;
+  for (byte d = 0; d < BLAECK_BRIDGE_MAX_DEVICES; d++)
+  {
+    delete[] _bridgeDevices[d].cache[0].buf;
+    delete[] _bridgeDevices[d].cache[1].buf;
+    delete[] _bridgeDevices[d].types;
+  }
+  if (_arenaOwned)
+    delete[] _arena;
 }
 
 void BlaeckTCP::_initClientMeta()
@@ -24,10 +100,21 @@ void BlaeckTCP::_initClientMeta()
   {
     Clients[i].name[0] = '\0';
     strcpy(Clients[i].type, "unknown");
+    Clients[i].connectedSince_ms = 0;
+    Clients[i].lastActivity_ms = 0;
+    Clients[i].reportsRoom = false;
+    Clients[i].mostRoom = 0;
+#if BLAECK_ENABLE_STATS
+    Clients[i].bytesSent = 0;
+#endif
   }
+#if BLAECK_ENABLE_STATS
+  // Statistics start over with the client table
+  _stats = BlaeckStats();
+#endif
 }
 
-void BlaeckTCP::_parseClientIdentity(const char *raw)
+void BlaeckTCP::_parseClientIdentity(byte c, const char *raw)
 {
   // Parse identity from: BLAECK.GET_DEVICES,0,0,0,0,Name,Type
   // Skip 5 comma-separated fields (command + 4 msg_id bytes) to reach Name and Type
@@ -49,76 +136,66 @@ void BlaeckTCP::_parseClientIdentity(const char *raw)
     p++;
   }
 
-  if (nameStart == NULL)
+  if (nameStart == NULL || c >= _maxClients)
     return;
 
-  // Find client index for CommandingClient
-  for (byte c = 0; c < _maxClients; c++)
+  // Extract name (up to next comma or end)
+  int len = 0;
+  if (typeStart != NULL)
+    len = (typeStart - 1) - nameStart;
+  else
+    len = strlen(nameStart);
+  if (len > (int)(sizeof(Clients[c].name) - 1))
+    len = sizeof(Clients[c].name) - 1;
+  if (len > 0)
   {
-    if (Clients[c].connection == CommandingClient)
-    {
-      // Extract name (up to next comma or end)
-      int len = 0;
-      if (typeStart != NULL)
-        len = (typeStart - 1) - nameStart;
-      else
-        len = strlen(nameStart);
-      if (len > (int)(sizeof(Clients[c].name) - 1))
-        len = sizeof(Clients[c].name) - 1;
-      if (len > 0)
-      {
-        strncpy(Clients[c].name, nameStart, len);
-        Clients[c].name[len] = '\0';
-      }
+    strncpy(Clients[c].name, nameStart, len);
+    Clients[c].name[len] = '\0';
+  }
 
-      // Extract type
-      if (typeStart != NULL && *typeStart != '\0')
-      {
-        strncpy(Clients[c].type, typeStart, sizeof(Clients[c].type) - 1);
-        Clients[c].type[sizeof(Clients[c].type) - 1] = '\0';
-      }
+  // Extract type
+  if (typeStart != NULL && *typeStart != '\0')
+  {
+    strncpy(Clients[c].type, typeStart, sizeof(Clients[c].type) - 1);
+    Clients[c].type[sizeof(Clients[c].type) - 1] = '\0';
+  }
 
-      // Log identity
-      if (Clients[c].name[0] != '\0')
-      {
-        StreamRef->print("Client #");
-        StreamRef->print(c);
-        StreamRef->print(" identified (");
-        StreamRef->print(Clients[c].type);
-        StreamRef->print(": ");
-        StreamRef->print(Clients[c].name);
-        StreamRef->println(")");
-      }
-      break;
-    }
+  // Log identity
+  if (Clients[c].name[0] != '\0')
+  {
+    char text[64];
+    snprintf(text, sizeof(text), "Client #%u identified (%s: %s)\r\n", c, Clients[c].type, Clients[c].name);
+    _printClientEvent(text);
   }
 }
 
 void BlaeckTCP::begin(Stream *streamRef, unsigned int maximumSignalCount, uint16_t port)
 {
+#if BLAECK_NETWORK_TASK
+  stopNetworkTask();
+#endif
   StreamRef = (Stream *)streamRef;
+  _resetTables();
 
   _maxClients = 1;
 
   _blaeckWriteDataClientMask = 1;
 
   _signalCapacity = maximumSignalCount;
-  if (Signals != nullptr)
-  {
-    delete[] Signals;
-    Signals = nullptr;
-  }
-  Signals = new (std::nothrow) Signal[maximumSignalCount];
+  _freeSnapshot();
+  bool signalTableAllocated = _allocSignalTable(maximumSignalCount);
   _signalIndex = 0;
   SignalCount = 0;
+  _signalGeneration++;
+  _signalNamesInPlace = 0;
   _schemaHash = 0;
   _signalOverflowOccurred = false;
   _signalOverflowCount = 0;
 
-  // Requesting more signals than the board has RAM for leaves Signals null.
+  // Requesting more signals than the board has RAM for leaves the table null.
   // Reported through the same flag addSignal uses, so hasSignalOverflow()
   // catches it even before the first addSignal call.
-  if (Signals == nullptr)
+  if (!signalTableAllocated)
     _signalOverflowOccurred = true;
 
   StreamRef->print("BlaeckTCP Version: ");
@@ -126,12 +203,7 @@ void BlaeckTCP::begin(Stream *streamRef, unsigned int maximumSignalCount, uint16
 
   StreamRef->println("Only one client (= Client 0) can connect simultaneously!");
 
-  if (Clients != nullptr)
-  {
-    delete[] Clients;
-    Clients = nullptr;
-  }
-  Clients = new BlaeckClient[_maxClients];
+  _allocClientTable(_maxClients);
   _initClientMeta();
   _startServer(port);
 }
@@ -145,28 +217,30 @@ void BlaeckTCP::begin(byte maxClients, Stream *streamRef, unsigned int maximumSi
 
 void BlaeckTCP::begin(byte maxClients, Stream *streamRef, unsigned int maximumSignalCount, int blaeckWriteDataClientMask, uint16_t port)
 {
+#if BLAECK_NETWORK_TASK
+  stopNetworkTask();
+#endif
   StreamRef = (Stream *)streamRef;
+  _resetTables();
 
   _maxClients = maxClients;
   _blaeckWriteDataClientMask = blaeckWriteDataClientMask;
 
   _signalCapacity = maximumSignalCount;
-  if (Signals != nullptr)
-  {
-    delete[] Signals;
-    Signals = nullptr;
-  }
-  Signals = new (std::nothrow) Signal[maximumSignalCount];
+  _freeSnapshot();
+  bool signalTableAllocated = _allocSignalTable(maximumSignalCount);
   _signalIndex = 0;
   SignalCount = 0;
+  _signalGeneration++;
+  _signalNamesInPlace = 0;
   _schemaHash = 0;
   _signalOverflowOccurred = false;
   _signalOverflowCount = 0;
 
-  // Requesting more signals than the board has RAM for leaves Signals null.
+  // Requesting more signals than the board has RAM for leaves the table null.
   // Reported through the same flag addSignal uses, so hasSignalOverflow()
   // catches it even before the first addSignal call.
-  if (Signals == nullptr)
+  if (!signalTableAllocated)
     _signalOverflowOccurred = true;
 
   StreamRef->print("BlaeckTCP Version: ");
@@ -200,22 +274,39 @@ void BlaeckTCP::begin(byte maxClients, Stream *streamRef, unsigned int maximumSi
   }
   StreamRef->println();
 
-  if (Clients != nullptr)
-  {
-    delete[] Clients;
-    Clients = nullptr;
-  }
-  Clients = new BlaeckClient[maxClients];
+  _allocClientTable(maxClients);
   _initClientMeta();
   _startServer(port);
 }
 
 void BlaeckTCP::beginBridge(byte maxClients, Stream *streamRef, Stream *bridgeStream, uint16_t port)
 {
+#if BLAECK_NETWORK_TASK
+  stopNetworkTask();
+#endif
   _maxClients = maxClients;
   StreamRef = streamRef;
+  _resetTables();
   _bridgeMode = true;
-  BridgeStreamRef = bridgeStream;
+  // The first device; addBridgeDevice() adds more
+  _bridgeDevices[0].tx.begin(BLAECK_BRIDGE_TX_SIZE);
+  _bridgeDevices[0].rx.begin(BLAECK_BRIDGE_RX_SIZE);
+  _bridgeInitDevice(_bridgeDevices[0], bridgeStream, 0);
+  for (byte d = 1; d < BLAECK_BRIDGE_MAX_DEVICES; d++)
+  {
+    _bridgeDevices[d].tx.end();
+    _bridgeDevices[d].rx.end();
+  }
+  _bridgeDeviceCount = 1;
+  _bridgeNextDevice = 0;
+  _bridgeBytesToDevice = 0;
+  _bridgeBytesToClients = 0;
+  _bridgeOverflowsToDevice = 0;
+  _bridgeOverflowsToClients = 0;
+  _bridgeOutLeft = 0;
+  _bridgeCacheHits = 0;
+  _bridgeSchemaHash = 0;
+  _bridgeBusy_us = 0;
 
   StreamRef->print("BlaeckTCP Version: ");
   StreamRef->println(BLAECKTCP_VERSION);
@@ -224,416 +315,2518 @@ void BlaeckTCP::beginBridge(byte maxClients, Stream *streamRef, Stream *bridgeSt
   StreamRef->print("Max Clients allowed: ");
   StreamRef->println(maxClients);
 
-  if (Clients != nullptr)
-  {
-    delete[] Clients;
-    Clients = nullptr;
-  }
-  Clients = new BlaeckClient[maxClients];
+  _allocClientTable(maxClients);
   _initClientMeta();
+  if (_bridgeFrameAware)
+    _bridgeAllocCommands();
   _startServer(port);
 }
 
 void BlaeckTCP::_startServer(uint16_t port)
 {
+#if BLAECK_ASYNC_TCP
+  _asyncEnd();
+  _asyncSocketCount = _maxClients + 1;
+  _asyncSockets = new BlaeckAsyncSocket[_asyncSocketCount];
+  for (byte i = 0; i < _asyncSocketCount; i++)
+  {
+    _asyncSockets[i].rx.begin(BLAECK_ASYNC_TCP_RX_SIZE);
+    _asyncSockets[i].tx.begin(BLAECK_ASYNC_TCP_TX_SIZE);
+  }
+  _asyncServer = new AsyncServer(port);
+  _asyncServer->setNoDelay(BLAECK_TCP_NO_DELAY_DEFAULT);
+  _asyncServer->onClient(&BlaeckTCP::_asyncOnClient, this);
+  _asyncServer->begin();
+#else
   TelnetPrint = NetServer(port);
   TelnetPrint.begin();
 #if defined(ESP32) || defined(ESP8266)
   TelnetPrint.setNoDelay(BLAECK_TCP_NO_DELAY_DEFAULT);
 #endif
+#endif
 }
 
-void BlaeckTCP::bridgePoll()
+Print &BlaeckTCP::_frameBegin(byte client)
 {
-  // Handle new client connections
-  NetClient newClient = TelnetPrint.accept();
-  if (newClient)
-  {
-    for (byte i = 0; i < _maxClients; i++)
-    {
-      if (!Clients[i].connection)
-      {
-        StreamRef->print("Client #");
-        StreamRef->print(i);
-        StreamRef->print(" connected");
-        IPAddress ip = newClient.remoteIP();
-        if (ip != IPAddress(0, 0, 0, 0))
-        {
-          StreamRef->print(": ");
-          StreamRef->print(ip);
-          StreamRef->print(":");
-          StreamRef->print(newClient.remotePort());
-        }
-        StreamRef->println();
-        newClient.print("Hello, client number: ");
-        newClient.println(i);
-        Clients[i].connection = newClient;
-        Clients[i].name[0] = '\0';
-        strcpy(Clients[i].type, "unknown");
-        if (_clientConnectedCallback != NULL)
-          _clientConnectedCallback(i);
-        break;
-      }
-    }
-  }
-
-  // Handle data from clients to bridge using buffer
-  static uint8_t buffer[BLAECK_BUFFER_SIZE];
-
-  for (byte i = 0; i < _maxClients; i++)
-  {
-    if (Clients[i].connection && Clients[i].connection.connected())
-    {
-      while (Clients[i].connection.available() > 0)
-      {
-        int bytesAvailable = min(Clients[i].connection.available(), BLAECK_BUFFER_SIZE);
-        int bytesRead = Clients[i].connection.read(buffer, bytesAvailable);
-
-        if (bytesRead > 0)
-        {
-          // Write data to bridge in chunks to avoid overwhelming it
-          int written = 0;
-          while (written < bytesRead)
-          {
-            int toWrite = min(64, bytesRead - written); // Write in smaller chunks
-            BridgeStreamRef->write(&buffer[written], toWrite);
-            written += toWrite;
-          }
-        }
-      }
-    }
-  }
-
-  // Handle disconnected clients
-  for (byte i = 0; i < _maxClients; i++)
+#if BLAECK_NETWORK_TASK
+  if (_netTask != nullptr)
   {
-    if (Clients[i].connection && !Clients[i].connection.connected())
-    {
-      Clients[i].connection.stop();
-      StreamRef->print("Client #");
-      StreamRef->print(i);
-      StreamRef->print(" disconnected");
-      if (Clients[i].name[0] != '\0')
-      {
-        StreamRef->print(" (");
-        StreamRef->print(Clients[i].type);
-        StreamRef->print(": ");
-        StreamRef->print(Clients[i].name);
-        StreamRef->print(")");
-      }
-      StreamRef->println();
-      Clients[i].name[0] = '\0';
-      strcpy(Clients[i].type, "unknown");
-      if (_clientDisconnectedCallback != NULL)
-        _clientDisconnectedCallback(i);
-    }
+    _netTx.begin(1UL << client);
+    return _netTx;
   }
+#endif
+  _frameTimerStart(client);
+  return _clientOut(client);
+}
 
-  // Forward data from bridge stream to clients
-  if (BridgeStreamRef->available())
-  {
-    int bytesAvailable = min(BridgeStreamRef->available(), BLAECK_BUFFER_SIZE);
-    int bytesRead = BridgeStreamRef->readBytes(buffer, bytesAvailable);
-
-    if (bytesRead > 0)
-    {
-      // Send to all connected clients
-      for (byte client = 0; client < _maxClients; client++)
-      {
-        if (Clients[client].connection.connected())
-        {
-          int written = 0;
-          while (written < bytesRead)
-          {
-            int toWrite = min(64, bytesRead - written);
-            Clients[client].connection.write(&buffer[written], toWrite);
-            written += toWrite;
-          }
-        }
-      }
-    }
-  }
+Print &BlaeckTCP::_clientOut(byte client)
+{
+#if BLAECK_ENABLE_STATS || BLAECK_ENABLE_TRACE
+  return _clientPrints[client];
+#else
+  return Clients[client].connection;
+#endif
 }
 
-void BlaeckTCP::addSignal(String signalName, bool *value)
+void BlaeckTCP::_frameTimerStart(byte client)
 {
-  if (Signals == nullptr || static_cast<unsigned int>(_signalIndex) >= _signalCapacity)
-  {
-    _signalOverflowOccurred = true;
-    _signalOverflowCount++;
-    return;
-  }
-  setSignalName(_signalIndex, signalName);
-  Signals[_signalIndex].DataType = Blaeck_bool;
-  Signals[_signalIndex].Address = value;
-  _signalIndex++;
-  SignalCount = _signalIndex;
-  _schemaHash = _computeSchemaHash();
+#if BLAECK_ENABLE_STATS
+  _clientPrints[client].frameStart_us = micros();
+#endif
 }
 
-void BlaeckTCP::addSignal(String signalName, byte *value)
+void BlaeckTCP::_frameTimerStop(byte client)
 {
-  if (Signals == nullptr || static_cast<unsigned int>(_signalIndex) >= _signalCapacity)
-  {
-    _signalOverflowOccurred = true;
-    _signalOverflowCount++;
-    return;
-  }
-  setSignalName(_signalIndex, signalName);
-  Signals[_signalIndex].DataType = Blaeck_byte;
-  Signals[_signalIndex].Address = value;
-  _signalIndex++;
-  SignalCount = _signalIndex;
-  _schemaHash = _computeSchemaHash();
+#if BLAECK_ENABLE_STATS
+  _stats.socketWrite.add(micros() - _clientPrints[client].frameStart_us);
+#endif
 }
 
-void BlaeckTCP::addSignal(String signalName, short *value)
+#if BLAECK_ENABLE_STATS || BLAECK_ENABLE_TRACE
+size_t BlaeckTCP::ClientPrint::write(const uint8_t *buffer, size_t size)
 {
-  if (Signals == nullptr || static_cast<unsigned int>(_signalIndex) >= _signalCapacity)
-  {
-    _signalOverflowOccurred = true;
-    _signalOverflowCount++;
-    return;
-  }
-  setSignalName(_signalIndex, signalName);
-  Signals[_signalIndex].DataType = Blaeck_short;
-  Signals[_signalIndex].Address = value;
-  _signalIndex++;
-  SignalCount = _signalIndex;
-  _schemaHash = _computeSchemaHash();
+#if BLAECK_ENABLE_TRACE
+  owner->_traceRecord(BLAECK_TRACE_SOCKET_WRITE, false);
+#endif
+  size_t written = owner->Clients[client].connection.write(buffer, size);
+#if BLAECK_ENABLE_STATS
+  BlaeckStats &stats = owner->_stats;
+  stats.bytesSent += written;
+  owner->Clients[client].bytesSent += written;
+  if (written < size)
+    stats.writeStalls++;
+#endif
+#if BLAECK_ENABLE_TRACE
+  owner->_traceRecord(BLAECK_TRACE_SOCKET_WRITE, true);
+#endif
+  return written;
 }
+#endif
+
+#if BLAECK_ENABLE_STATS
 
-void BlaeckTCP::addSignal(String signalName, unsigned short *value)
+void BlaeckTimer::add(uint32_t us)
 {
-  if (Signals == nullptr || static_cast<unsigned int>(_signalIndex) >= _signalCapacity)
-  {
-    _signalOverflowOccurred = true;
-    _signalOverflowCount++;
-    return;
-  }
-  setSignalName(_signalIndex, signalName);
-  Signals[_signalIndex].DataType = Blaeck_ushort;
-  Signals[_signalIndex].Address = value;
-  _signalIndex++;
-  SignalCount = _signalIndex;
-  _schemaHash = _computeSchemaHash();
+  if (count == 0 || us < min_us)
+    min_us = us;
+  if (us > max_us)
+    max_us = us;
+  total_us += us;
+  count++;
 }
+#endif
 
-void BlaeckTCP::addSignal(String signalName, int *value)
+void BlaeckTCP::_frameEnd(byte client)
 {
-  if (Signals == nullptr || static_cast<unsigned int>(_signalIndex) >= _signalCapacity)
+#if BLAECK_NETWORK_TASK
+  if (_netTask != nullptr)
   {
-    _signalOverflowOccurred = true;
-    _signalOverflowCount++;
+    if (!_netTx.commit())
+      _netTxDropCount++;
     return;
   }
-  setSignalName(_signalIndex, signalName);
-#ifdef __AVR__
-  Signals[_signalIndex].DataType = Blaeck_int; // 2 bytes
-#else
-  Signals[_signalIndex].DataType = Blaeck_long; // Treat as 4-byte long
 #endif
-  Signals[_signalIndex].Address = value;
-  _signalIndex++;
-  SignalCount = _signalIndex;
-  _schemaHash = _computeSchemaHash();
+#if BLAECK_ASYNC_TCP
+  _asyncFlush();
+#endif
+  _frameTimerStop(client);
 }
 
-void BlaeckTCP::addSignal(String signalName, unsigned int *value)
+bool BlaeckTCP::_clientConnected(byte client) const
 {
-  if (Signals == nullptr || static_cast<unsigned int>(_signalIndex) >= _signalCapacity)
-  {
-    _signalOverflowOccurred = true;
-    _signalOverflowCount++;
-    return;
-  }
-  setSignalName(_signalIndex, signalName);
-#ifdef __AVR__
-  Signals[_signalIndex].DataType = Blaeck_uint; // 2 bytes
-#else
-  Signals[_signalIndex].DataType = Blaeck_ulong; // Treat as 4-byte unsigned long
+#if BLAECK_NETWORK_TASK
+  // The sockets belong to the network task; ask its view instead.
+  if (_netTask != nullptr)
+    return bitRead(_netConnectedMask, client) == 1;
 #endif
-  Signals[_signalIndex].Address = value;
-  _signalIndex++;
-  SignalCount = _signalIndex;
-  _schemaHash = _computeSchemaHash();
+  return Clients[client].connection.connected();
 }
 
-void BlaeckTCP::addSignal(String signalName, long *value)
+#if BLAECK_NETWORK_TASK
+bool BlaeckTCP::startNetworkTask(int core, uint32_t stackSize, unsigned int priority)
 {
-  if (Signals == nullptr || static_cast<unsigned int>(_signalIndex) >= _signalCapacity)
+  if (_netTask != nullptr || _bridgeMode || Clients == nullptr)
+    return false;
+  // The task tracks connections in a 32-bit client mask
+  if (_maxClients > 32)
   {
-    _signalOverflowOccurred = true;
-    _signalOverflowCount++;
-    return;
+    StreamRef->println("Network task: more than 32 clients, not started");
+    return false;
   }
-  setSignalName(_signalIndex, signalName);
-  Signals[_signalIndex].DataType = Blaeck_long;
-  Signals[_signalIndex].Address = value;
-  _signalIndex++;
-  SignalCount = _signalIndex;
-  _schemaHash = _computeSchemaHash();
-}
 
-void BlaeckTCP::addSignal(String signalName, unsigned long *value)
-{
-  if (Signals == nullptr || static_cast<unsigned int>(_signalIndex) >= _signalCapacity)
+  if (!_netTx.ring.isAllocated() && !_netTx.ring.begin(BLAECK_NETWORK_TASK_TX_SIZE))
+    return false;
+  if (!_netRx.isAllocated() && !_netRx.begin(BLAECK_NETWORK_TASK_RX_SIZE))
+    return false;
+
+  uint32_t connectedMask = 0;
+  for (byte client = 0; client < _maxClients; client++)
+    if (Clients[client].connection.connected())
+      connectedMask |= (1UL << client);
+  _netConnectedMask = connectedMask;
+  _netTaskStop = false;
+
+  TaskHandle_t handle = nullptr;
+  // _netTask doubles as the "task mode" switch, so it must be set before the
+  // task's first accept can look at it.
+  _netTask = (TaskHandle_t)1;
+  if (xTaskCreatePinnedToCore(_networkTaskEntry, "BlaeckNet", stackSize, this, priority, &handle, core) != pdPASS)
   {
-    _signalOverflowOccurred = true;
-    _signalOverflowCount++;
-    return;
+    _netTask = nullptr;
+    return false;
   }
-  setSignalName(_signalIndex, signalName);
-  Signals[_signalIndex].DataType = Blaeck_ulong;
-  Signals[_signalIndex].Address = value;
-  _signalIndex++;
-  SignalCount = _signalIndex;
-  _schemaHash = _computeSchemaHash();
+  _netTask = handle;
+
+  StreamRef->print("Network task running on core ");
+  StreamRef->println(core);
+  return true;
 }
 
-void BlaeckTCP::addSignal(String signalName, float *value)
+void BlaeckTCP::stopNetworkTask()
 {
-  if (Signals == nullptr || static_cast<unsigned int>(_signalIndex) >= _signalCapacity)
-  {
-    _signalOverflowOccurred = true;
-    _signalOverflowCount++;
+  if (_netTask == nullptr)
     return;
-  }
-  setSignalName(_signalIndex, signalName);
-  Signals[_signalIndex].DataType = Blaeck_float;
-  Signals[_signalIndex].Address = value;
-  _signalIndex++;
-  SignalCount = _signalIndex;
-  _schemaHash = _computeSchemaHash();
+  _netTaskStop = true;
+  // The task deletes itself once it is out of any socket call.
+  while (_netTask != nullptr)
+    delay(1);
 }
 
-void BlaeckTCP::addSignal(String signalName, double *value)
+void BlaeckTCP::_networkTaskEntry(void *arg)
 {
-  if (Signals == nullptr || static_cast<unsigned int>(_signalIndex) >= _signalCapacity)
-  {
-    _signalOverflowOccurred = true;
-    _signalOverflowCount++;
-    return;
-  }
-  setSignalName(_signalIndex, signalName);
-#ifdef __AVR__
-  /*On the Uno and other ATMEGA based boards, the double implementation occupies 4 bytes
-  and is exactly the same as the float, with no gain in precision.*/
-  Signals[_signalIndex].DataType = Blaeck_float;
-#else
-  Signals[_signalIndex].DataType = Blaeck_double;
-#endif
-  Signals[_signalIndex].Address = value;
-  _signalIndex++;
-  SignalCount = _signalIndex;
-  _schemaHash = _computeSchemaHash();
+  ((BlaeckTCP *)arg)->_networkTaskLoop();
 }
 
-void BlaeckTCP::addSignal(String signalName, char *value)
+void BlaeckTCP::_networkTaskLoop()
 {
-  if (Signals == nullptr || static_cast<unsigned int>(_signalIndex) >= _signalCapacity)
+  while (!_netTaskStop)
   {
-    _signalOverflowOccurred = true;
-    _signalOverflowCount++;
-    return;
+    _acceptClients();
+
+    bool busy = false;
+    byte clientNo;
+    while (_receiveCommand(_netRxChars, clientNo))
+    {
+      // Clients[] belongs to this task: set the identity here, before the
+      // slot can be dropped and reused by another client.
+      if (strncmp(_netRxChars, "BLAECK.GET_DEVICES", 18) == 0 && (_netRxChars[18] == ',' || _netRxChars[18] == '\0'))
+        _parseClientIdentity(clientNo, _netRxChars);
+      _netPushEvent(NET_EVENT_COMMAND, clientNo, _netRxChars);
+      busy = true;
+    }
+
+    _pruneClients();
+
+    if (_netDrainTx())
+      busy = true;
+
+    // Nothing moved: yield so lower-priority tasks (and the idle task's
+    // watchdog feed) on this core get to run.
+    if (!busy)
+      vTaskDelay(1);
   }
-  setSignalName(_signalIndex, signalName);
-  Signals[_signalIndex].DataType = Blaeck_string;
-  Signals[_signalIndex].Address = value;
-  _signalIndex++;
-  SignalCount = _signalIndex;
-  _schemaHash = _computeSchemaHash();
-}
 
-void BlaeckTCP::deleteSignals()
-{
-  _signalIndex = 0;
-  SignalCount = _signalIndex;
-  _schemaHash = 0;
-  _signalOverflowOccurred = false;
-  _signalOverflowCount = 0;
+  _netTask = nullptr;
+  vTaskDelete(nullptr);
 }
 
-uint16_t BlaeckTCP::_computeSchemaHash()
+bool BlaeckTCP::_netDrainTx()
 {
-  // CRC16-CCITT (init=0x0000, poly=0x1021) over signal names + datatype codes.
-  // Must match Python: binascii.crc_hqx(data, 0) & 0xFFFF
-  uint16_t crc = 0x0000;
-  for (int j = 0; j < _signalIndex; j++)
+  bool drained = false;
+  byte header[6];
+  while (_netTx.ring.peek(header, sizeof(header)) == sizeof(header))
   {
-    // Feed signal name bytes (UTF-8 / ASCII)
-    const char *name = Signals[j].SignalName.c_str();
-    while (*name)
-    {
-      byte b = (byte)*name++;
-      crc ^= ((uint16_t)b << 8);
-      for (byte k = 0; k < 8; k++)
-      {
-        if (crc & 0x8000)
-          crc = (crc << 1) ^ 0x1021;
-        else
-          crc <<= 1;
-      }
-    }
-    // Feed datatype code byte
-    byte code = (byte)Signals[j].DataType;
-    crc ^= ((uint16_t)code << 8);
-    for (byte k = 0; k < 8; k++)
+    uint32_t clientMask = (uint32_t)header[0] | ((uint32_t)header[1] << 8) | ((uint32_t)header[2] << 16) | ((uint32_t)header[3] << 24);
+    size_t len = (size_t)header[4] | ((size_t)header[5] << 8);
+
+    // A record wraps the ring end at most once: two contiguous pieces.
+    size_t offset = sizeof(header);
+    size_t remaining = len;
+    while (remaining > 0)
     {
-      if (crc & 0x8000)
-        crc = (crc << 1) ^ 0x1021;
-      else
-        crc <<= 1;
+      const uint8_t *chunk;
+      size_t chunkLen = _netTx.ring.readable(&chunk, offset);
+      if (chunkLen > remaining)
+        chunkLen = remaining;
+      for (byte client = 0; client < _maxClients; client++)
+        if (bitRead(clientMask, client) == 1 && Clients[client].connection.connected())
+          Clients[client].connection.write(chunk, chunkLen);
+      offset += chunkLen;
+      remaining -= chunkLen;
     }
+    _netTx.ring.consume(sizeof(header) + len);
+    drained = true;
   }
-  return crc & 0xFFFF;
+  return drained;
 }
 
-void BlaeckTCP::setSignalName(int signalIndex, String signalName)
+void BlaeckTCP::_netPushEvent(byte type, byte clientNo, const char *text)
 {
-  if (Signals == nullptr || signalIndex < 0 || signalIndex >= (int)_signalCapacity)
-    return;
-
-  Signals[signalIndex].SignalName = "";
-  Signals[signalIndex].SignalName.reserve(signalName.length() + 1);
-  Signals[signalIndex].SignalName += signalName;
+  size_t len = strlen(text);
+  if (len > 255)
+    len = 255;
+  byte header[3] = {type, clientNo, (byte)len};
+  _netRx.stageBegin();
+  _netRx.stage(header, sizeof(header));
+  _netRx.stage((const uint8_t *)text, len);
+  // A full RX queue means the loop task is not calling read(); the event is
+  // lost like a command sent while nobody listens.
+  _netRx.stageCommit();
 }
 
-void BlaeckTCP::read()
+bool BlaeckTCP::_netPollEvents()
 {
-
-  if (recvWithStartEndMarkers() == true)
+  byte header[3];
+  while (_netRx.peek(header, sizeof(header)) == sizeof(header))
   {
-    parseData();
-    StreamRef->print("<");
-    StreamRef->print(receivedChars);
-    StreamRef->println(">");
+    byte type = header[0];
+    byte clientNo = header[1];
+    byte len = header[2];
 
-    if (strcmp(COMMAND, "BLAECK.WRITE_SYMBOLS") == 0)
+    if (type == NET_EVENT_CONNECTED)
     {
-      unsigned long msg_id = ((unsigned long)PARAMETER[3] << 24) | ((unsigned long)PARAMETER[2] << 16) | ((unsigned long)PARAMETER[1] << 8) | ((unsigned long)PARAMETER[0]);
-
-      this->writeSymbols(msg_id);
+      _netRx.consume(sizeof(header) + len);
+      if (_clientConnectedCallback != NULL)
+        _clientConnectedCallback(clientNo);
     }
-    else if (strcmp(COMMAND, "BLAECK.WRITE_DATA") == 0)
+    else if (type == NET_EVENT_DISCONNECTED)
     {
-      unsigned long msg_id = ((unsigned long)PARAMETER[3] << 24) | ((unsigned long)PARAMETER[2] << 16) | ((unsigned long)PARAMETER[1] << 8) | ((unsigned long)PARAMETER[0]);
-
-      this->writeAllData(msg_id);
+      _netRx.consume(sizeof(header) + len);
+      if (_clientDisconnectedCallback != NULL)
+        _clientDisconnectedCallback(clientNo);
     }
-    else if (strcmp(COMMAND, "BLAECK.GET_DEVICES") == 0)
+    else if (type == NET_EVENT_TEXT)
     {
-      unsigned long msg_id = ((unsigned long)PARAMETER[3] << 24) | ((unsigned long)PARAMETER[2] << 16) | ((unsigned long)PARAMETER[1] << 8) | ((unsigned long)PARAMETER[0]);
-
-      // Parse optional identity: <BLAECK.GET_DEVICES,0,0,0,0,Name,Type>
-      _parseClientIdentity(receivedChars);
-
-      this->writeDevices(msg_id);
+      uint8_t text[255];
+      _netRx.peek(text, len, sizeof(header));
+      _netRx.consume(sizeof(header) + len);
+      StreamRef->write(text, len);
     }
-#if BLAECK_ENABLE_COMMAND_META
-    else if (strcmp(COMMAND, "BLAECK.WRITE_COMMANDS") == 0)
+    else
     {
-      unsigned long msg_id = ((unsigned long)PARAMETER[3] << 24) | ((unsigned long)PARAMETER[2] << 16) | ((unsigned long)PARAMETER[1] << 8) | ((unsigned long)PARAMETER[0]);
+      // One command per read(), like the direct path.
+      _netRx.peek((uint8_t *)receivedChars, len, sizeof(header));
+      receivedChars[len] = '\0';
+      _netRx.consume(sizeof(header) + len);
+      _commandingClientNo = clientNo;
+      return true;
+    }
+  }
+  return false;
+}
+
+void BlaeckTCP::FrameQueue::begin(uint32_t clientMask)
+{
+  // Header placeholder: clientMask(4) + length(2), length patched on commit.
+  byte header[6] = {(byte)(clientMask & 0xFF), (byte)((clientMask >> 8) & 0xFF),
+                    (byte)((clientMask >> 16) & 0xFF), (byte)((clientMask >> 24) & 0xFF), 0, 0};
+  ring.stageBegin();
+  ring.stage(header, sizeof(header));
+}
+
+bool BlaeckTCP::FrameQueue::commit()
+{
+  size_t len = ring.staged() - 6;
+  if (len == 0)
+    return true; // nothing was written (e.g. no updated signals)
+  if (len > 0xFFFF)
+    return false;
+  byte lenBytes[2] = {(byte)(len & 0xFF), (byte)((len >> 8) & 0xFF)};
+  ring.stagePatch(4, lenBytes, 2);
+  return ring.stageCommit();
+}
+#endif
+
+BlaeckByteRing::~BlaeckByteRing()
+{
+  end();
+}
+
+bool BlaeckByteRing::begin(size_t size)
+{
+  end();
+  _buf = new (std::nothrow) uint8_t[size];
+  if (_buf == nullptr)
+    return false;
+  _size = size;
+  _head = 0;
+  _tail = 0;
+  _stageLen = 0;
+  _stageOverflow = false;
+  return true;
+}
+
+void BlaeckByteRing::end()
+{
+  delete[] _buf;
+  _buf = nullptr;
+  _size = 0;
+  _head = 0;
+  _tail = 0;
+}
+
+size_t BlaeckByteRing::available() const
+{
+  if (_buf == nullptr)
+    return 0;
+  size_t head = _head;
+  size_t tail = _tail;
+  return (head >= tail) ? head - tail : _size - tail + head;
+}
+
+size_t BlaeckByteRing::availableForWrite() const
+{
+  if (_buf == nullptr)
+    return 0;
+  return _size - 1 - available();
+}
+
+size_t BlaeckByteRing::peek(uint8_t *data, size_t len, size_t offset) const
+{
+  size_t avail = available();
+  if (offset >= avail)
+    return 0;
+  if (len > avail - offset)
+    len = avail - offset;
+  size_t pos = (_tail + offset) % _size;
+  for (size_t n = 0; n < len; n++)
+  {
+    data[n] = _buf[pos];
+    if (++pos == _size)
+      pos = 0;
+  }
+  return len;
+}
+
+void BlaeckByteRing::patch(size_t offset, const uint8_t *data, size_t len)
+{
+  size_t avail = available();
+  if (offset >= avail)
+    return;
+  if (len > avail - offset)
+    len = avail - offset;
+  size_t pos = (_tail + offset) % _size;
+  for (size_t n = 0; n < len; n++)
+  {
+    _buf[pos] = data[n];
+    if (++pos == _size)
+      pos = 0;
+  }
+}
+
+size_t BlaeckByteRing::readable(const uint8_t **data, size_t offset) const
+{
+  size_t avail = available();
+  if (offset >= avail)
+    return 0;
+  size_t pos = (_tail + offset) % _size;
+  *data = &_buf[pos];
+  size_t contiguous = _size - pos;
+  return (contiguous < avail - offset) ? contiguous : avail - offset;
+}
+
+void BlaeckByteRing::consume(size_t len)
+{
+  size_t avail = available();
+  if (len > avail)
+    len = avail;
+  // Make sure the reads above are done before the producer may reuse the space.
+  __sync_synchronize();
+  _tail = (_tail + len) % _size;
+}
+
+size_t BlaeckByteRing::write(const uint8_t *data, size_t len)
+{
+  size_t room = availableForWrite();
+  if (len > room)
+    len = room;
+  size_t pos = _head;
+  for (size_t n = 0; n < len; n++)
+  {
+    _buf[pos] = data[n];
+    if (++pos == _size)
+      pos = 0;
+  }
+  // Publish the bytes before the new head.
+  __sync_synchronize();
+  _head = pos;
+  return len;
+}
+
+size_t BlaeckByteRing::writable(uint8_t **data) const
+{
+  if (_buf == nullptr)
+    return 0;
+  size_t room = availableForWrite();
+  size_t contiguous = _size - _head;
+  *data = &_buf[_head];
+  return (contiguous < room) ? contiguous : room;
+}
+
+void BlaeckByteRing::produce(size_t len)
+{
+  if (len > availableForWrite())
+    len = availableForWrite();
+  // Publish the bytes before the new head.
+  __sync_synchronize();
+  _head = (_head + len) % _size;
+}
+
+void BlaeckByteRing::stageBegin()
+{
+  _stageLen = 0;
+  _stageOverflow = (_buf == nullptr);
+}
+
+bool BlaeckByteRing::stage(const uint8_t *data, size_t len)
+{
+  if (_stageOverflow || len > availableForWrite() - _stageLen)
+  {
+    _stageOverflow = true;
+    return false;
+  }
+  size_t pos = (_head + _stageLen) % _size;
+  for (size_t n = 0; n < len; n++)
+  {
+    _buf[pos] = data[n];
+    if (++pos == _size)
+      pos = 0;
+  }
+  _stageLen += len;
+  return true;
+}
+
+void BlaeckByteRing::stagePatch(size_t offset, const uint8_t *data, size_t len)
+{
+  if (_stageOverflow || offset + len > _stageLen)
+    return;
+  size_t pos = (_head + offset) % _size;
+  for (size_t n = 0; n < len; n++)
+  {
+    _buf[pos] = data[n];
+    if (++pos == _size)
+      pos = 0;
+  }
+}
+
+bool BlaeckByteRing::stageCommit()
+{
+  bool ok = !_stageOverflow;
+  if (ok)
+  {
+    __sync_synchronize();
+    _head = (_head + _stageLen) % _size;
+  }
+  _stageLen = 0;
+  _stageOverflow = false;
+  return ok;
+}
+
+#if BLAECK_ASYNC_TCP
+void BlaeckAsyncSocket::commit()
+{
+  if (!txStaging)
+    return;
+  txStaging = false;
+  // A frame that outgrew the ring goes nowhere rather than half-way: the
+  // 0xB0/0xB6/0xF0 frames carry no CRC a host could reject a torn one by.
+  if (!tx.stageCommit())
+    dropped++;
+}
+
+void BlaeckAsyncSocket::push()
+{
+  if (client == nullptr || !open)
+    return;
+  // lwIP copies what it takes; the rest waits in tx for the next push.
+  bool added = false;
+  const uint8_t *data;
+  size_t len;
+  while ((len = tx.readable(&data)) > 0)
+  {
+    size_t room = client->space();
+    if (room == 0)
+      break;
+    if (len > room)
+      len = room;
+    len = client->add((const char *)data, len);
+    if (len == 0)
+      break;
+    tx.consume(len);
+    added = true;
+  }
+  if (added)
+    client->send();
+}
+
+bool BlaeckAsyncSocket::release()
+{
+  // Two parties let go of a closed socket, the loop's stop() and the
+  // disconnect callback; the second one frees it.
+#if defined(ESP32)
+  return __atomic_exchange_n(&released, true, __ATOMIC_ACQ_REL);
+#else
+  // ESP8266 runs the callbacks between loop() calls, never during one.
+  bool second = released;
+  released = true;
+  return second;
+#endif
+}
+
+bool BlaeckAsyncConnection::connected()
+{
+  // Like NetClient: still "connected" while received bytes are unread.
+  return _valid() && (_socket->open || _socket->rx.available() > 0);
+}
+
+int BlaeckAsyncConnection::available()
+{
+  return _valid() ? (int)_socket->rx.available() : 0;
+}
+
+int BlaeckAsyncConnection::read()
+{
+  uint8_t b;
+  return (read(&b, 1) == 1) ? b : -1;
+}
+
+int BlaeckAsyncConnection::read(uint8_t *buf, size_t size)
+{
+  if (!_valid())
+    return -1;
+  size_t n = _socket->rx.peek(buf, size);
+  _socket->rx.consume(n);
+  return (int)n;
+}
+
+int BlaeckAsyncConnection::peek()
+{
+  uint8_t b;
+  return (_valid() && _socket->rx.peek(&b, 1) == 1) ? b : -1;
+}
+
+size_t BlaeckAsyncConnection::write(uint8_t b)
+{
+  return write(&b, 1);
+}
+
+size_t BlaeckAsyncConnection::write(const uint8_t *buf, size_t size)
+{
+  if (!_valid() || !_socket->open)
+    return 0;
+  if (!_socket->txStaging)
+  {
+    _socket->tx.stageBegin();
+    _socket->txStaging = true;
+  }
+  return _socket->tx.stage(buf, size) ? size : 0;
+}
+
+int BlaeckAsyncConnection::availableForWrite()
+{
+  if (!_valid() || !_socket->open)
+    return 0;
+  size_t room = _socket->tx.availableForWrite();
+  if (_socket->txStaging)
+    room = (room > _socket->tx.staged()) ? room - _socket->tx.staged() : 0;
+  return (int)room;
+}
+
+void BlaeckAsyncConnection::flush()
+{
+  if (!_valid())
+    return;
+  _socket->commit();
+  _socket->push();
+}
+
+void BlaeckAsyncConnection::stop()
+{
+  if (!_valid())
+    return;
+  BlaeckAsyncSocket *s = _socket;
+  s->commit();
+  s->push();
+  s->rx.consume(s->rx.available());
+  s->tx.consume(s->tx.available());
+  // From here on only the callbacks and release() touch the socket.
+  s->state = BlaeckAsyncSocket::CLOSING;
+  __sync_synchronize();
+  if (s->client != nullptr)
+  {
+    // Graceful close: lwIP still sends what was queued. The disconnect
+    // callback may be running right now, or fire from inside close().
+    if (s->open)
+      s->client->close();
+    if (s->release())
+    {
+      delete s->client;
+      s->client = nullptr;
+      s->open = false;
+      __sync_synchronize();
+      s->state = BlaeckAsyncSocket::FREE;
+    }
+  }
+  else
+  {
+    s->state = BlaeckAsyncSocket::FREE;
+  }
+}
+
+IPAddress BlaeckAsyncConnection::remoteIP()
+{
+  if (!_valid() || _socket->client == nullptr)
+    return IPAddress(0, 0, 0, 0);
+  return _socket->client->remoteIP();
+}
+
+uint16_t BlaeckAsyncConnection::remotePort()
+{
+  if (!_valid() || _socket->client == nullptr)
+    return 0;
+  return _socket->client->remotePort();
+}
+
+void BlaeckTCP::_asyncOnClient(void *arg, AsyncClient *client)
+{
+  BlaeckTCP *self = (BlaeckTCP *)arg;
+  for (byte i = 0; i < self->_asyncSocketCount; i++)
+  {
+    BlaeckAsyncSocket &s = self->_asyncSockets[i];
+    if (s.state != BlaeckAsyncSocket::FREE)
+      continue;
+    // Nothing of the last connection on this socket reaches the new one
+    // (dropped keeps counting across connections, see getAsyncDropCount())
+    s.rx.consume(s.rx.available());
+    s.tx.consume(s.tx.available());
+    s.txStaging = false;
+    s.client = client;
+    s.open = true;
+    s.released = false;
+    client->onData(&BlaeckTCP::_asyncOnData, &s);
+    client->onDisconnect(&BlaeckTCP::_asyncOnDisconnect, &s);
+    // _acceptClients() picks it up on the next tick.
+    __sync_synchronize();
+    s.state = BlaeckAsyncSocket::PENDING;
+    return;
+  }
+  // Even the spare socket waits for the loop: refuse outright.
+  client->close(true);
+  delete client;
+}
+
+void BlaeckTCP::_asyncOnData(void *arg, AsyncClient *client, void *data, size_t len)
+{
+  BlaeckAsyncSocket *s = (BlaeckAsyncSocket *)arg;
+  // Between the loop's stop() and the disconnect callback: nobody reads it
+  if (s->state == BlaeckAsyncSocket::CLOSING)
+    return;
+  if (s->rx.write((const uint8_t *)data, len) < len)
+    s->dropped++;
+}
+
+void BlaeckTCP::_asyncOnDisconnect(void *arg, AsyncClient *client)
+{
+  // The loop's stop() (after _pruneClients() notices) and this callback both
+  // let go of the socket; the one that comes second deletes the AsyncClient.
+  BlaeckAsyncSocket *s = (BlaeckAsyncSocket *)arg;
+  s->open = false;
+  if (s->release())
+  {
+    delete client;
+    s->client = nullptr;
+    __sync_synchronize();
+    s->state = BlaeckAsyncSocket::FREE;
+  }
+}
+
+BlaeckConnection BlaeckTCP::_asyncAccept()
+{
+  for (byte i = 0; i < _asyncSocketCount; i++)
+  {
+    BlaeckAsyncSocket &s = _asyncSockets[i];
+    if (s.state == BlaeckAsyncSocket::PENDING)
+    {
+      s.generation++;
+      s.state = BlaeckAsyncSocket::IN_USE;
+      return BlaeckConnection(&s);
+    }
+  }
+  return BlaeckConnection();
+}
+
+void BlaeckTCP::_asyncFlush()
+{
+  for (byte i = 0; i < _asyncSocketCount; i++)
+  {
+    BlaeckAsyncSocket &s = _asyncSockets[i];
+    if (s.state == BlaeckAsyncSocket::IN_USE)
+    {
+      s.commit();
+      s.push();
+    }
+  }
+}
+
+void BlaeckTCP::_asyncEnd()
+{
+  if (_asyncServer != nullptr)
+  {
+    _asyncServer->end();
+    delete _asyncServer;
+    _asyncServer = nullptr;
+  }
+  for (byte i = 0; i < _asyncSocketCount; i++)
+  {
+    AsyncClient *client = _asyncSockets[i].client;
+    if (client != nullptr)
+    {
+      // The sockets go away with the array: no callback may reach them.
+      client->onData(nullptr, nullptr);
+      client->onDisconnect(nullptr, nullptr);
+      client->close(true);
+      delete client;
+    }
+  }
+  delete[] _asyncSockets;
+  _asyncSockets = nullptr;
+  _asyncSocketCount = 0;
+  CommandingClient = BlaeckConnection();
+}
+
+uint32_t BlaeckTCP::getAsyncDropCount() const
+{
+  uint32_t dropped = 0;
+  for (byte i = 0; i < _asyncSocketCount; i++)
+    dropped += _asyncSockets[i].dropped;
+  return dropped;
+}
+#endif
+
+void BlaeckTCP::bridgePoll()
+{
+  unsigned long start_us = micros();
+
+  // Handle new client connections
+  _acceptClients();
+
+  // Devices first: their UART FIFOs are the buffers that overflow
+  _bridgeReadDevices();
+  _bridgeFlushToClients();
+
+  if (_bridgeFrameAware)
+    _bridgeReadCommands();
+  else
+    _bridgeReadClients();
+  _bridgeFlushToDevices();
+
+  // Handle disconnected clients
+  _pruneClients();
+
+  // Whatever arrived from the devices meanwhile
+  _bridgeReadDevices();
+  _bridgeFlushToClients();
+
+  _bridgeBusy_us += micros() - start_us;
+}
+
+bool BlaeckTCP::addBridgeDevice(Stream *bridgeStream, byte slaveID)
+{
+  if (!_bridgeMode || bridgeStream == nullptr || _bridgeDeviceCount >= BLAECK_BRIDGE_MAX_DEVICES)
+    return false;
+#if BLAECK_BRIDGE_CACHE_SIZE == 0
+  // Merging the devices' symbol and device lists needs the cache buffers
+  if (StreamRef != nullptr)
+    StreamRef->println("Bridge: BLAECK_BRIDGE_CACHE_SIZE is 0, device not added");
+  return false;
+#endif
+  BridgeDevice &device = _bridgeDevices[_bridgeDeviceCount];
+  if (!device.tx.begin(BLAECK_BRIDGE_TX_SIZE) || !device.rx.begin(BLAECK_BRIDGE_RX_SIZE))
+  {
+    device.tx.end();
+    device.rx.end();
+    if (StreamRef != nullptr)
+      StreamRef->println("Bridge: out of memory, device not added");
+    return false;
+  }
+  _bridgeInitDevice(device, bridgeStream, slaveID);
+  _bridgeDeviceCount++;
+  return true;
+}
+
+void BlaeckTCP::_bridgeInitDevice(BridgeDevice &device, Stream *stream, byte slaveID)
+{
+  device.stream = stream;
+  device.slaveID = slaveID;
+  device.reportsRoom = false;
+  device.scanPos = 0;
+  for (byte slot = 0; slot < 2; slot++)
+  {
+    device.cache[slot].len = 0;
+    device.cache[slot].held = false;
+  }
+  device.dataSeen = false;
+  device.layoutKnown = false;
+#if defined(ESP32)
+  device.uart = -1;
+#endif
+}
+
+#if defined(ESP32)
+bool BlaeckTCP::setBridgeUart(byte device, int uartNum)
+{
+  if (device >= _bridgeDeviceCount)
+    return false;
+  if (uartNum >= 0 && (uartNum >= UART_NUM_MAX || !uart_is_driver_installed((uart_port_t)uartNum)))
+    return false;
+  _bridgeDevices[device].uart = uartNum;
+  return true;
+}
+
+void BlaeckTCP::_bridgeReadUart(BridgeDevice &device)
+{
+  // Straight from the driver's RX buffer into the RX ring: no Stream layer,
+  // no timeout, one copy.
+  uart_port_t port = (uart_port_t)device.uart;
+  size_t pending;
+  while (uart_get_buffered_data_len(port, &pending) == ESP_OK && pending > 0)
+  {
+    uint8_t *dst;
+    size_t room = device.rx.writable(&dst);
+    if (room == 0 && _bridgeFlushToClients() > 0)
+      room = device.rx.writable(&dst);
+    if (room == 0)
+    {
+      uart_flush_input(port);
+      _bridgeOverflowsToClients += pending;
+      return;
+    }
+    int len = uart_read_bytes(port, dst, (pending < room) ? pending : room, 0);
+    if (len <= 0)
+      return;
+    device.rx.produce(len);
+  }
+}
+#endif
+
+void BlaeckTCP::_bridgeReadDevices()
+{
+  // Each UART in turn, emptied as far as it goes without waiting
+  for (byte d = 0; d < _bridgeDeviceCount; d++)
+    _bridgeReadDevice(_bridgeDevices[d]);
+}
+
+void BlaeckTCP::_bridgeReadDevice(BridgeDevice &device)
+{
+#if defined(ESP32)
+  if (device.uart >= 0)
+  {
+    _bridgeReadUart(device);
+    return;
+  }
+#endif
+  // Drain the UART completely; when the ring is full, make room by sending
+  // to the clients, and drop only what they cannot take either.
+  int pending;
+  while ((pending = device.stream->available()) > 0)
+  {
+    uint8_t *dst;
+    size_t room = device.rx.writable(&dst);
+    if (room == 0 && _bridgeFlushToClients() > 0)
+      room = device.rx.writable(&dst);
+    if (room == 0)
+    {
+      while (device.stream->available() > 0 && device.stream->read() >= 0)
+        _bridgeOverflowsToClients++;
+      return;
+    }
+    size_t len = ((size_t)pending < room) ? (size_t)pending : room;
+    len = device.stream->readBytes(dst, len);
+    if (len == 0)
+      return;
+    device.rx.produce(len);
+  }
+}
+
+size_t BlaeckTCP::_bridgeTxRoom() const
+{
+  // Every device gets the same bytes: the fullest TX ring sets the room
+  size_t room = _bridgeDevices[0].tx.availableForWrite();
+  for (byte d = 1; d < _bridgeDeviceCount; d++)
+    if (_bridgeDevices[d].tx.availableForWrite() < room)
+      room = _bridgeDevices[d].tx.availableForWrite();
+  return room;
+}
+
+void BlaeckTCP::_bridgeReadClients()
+{
+  BlaeckByteRing &tx = _bridgeDevices[0].tx;
+  for (byte i = 0; i < _maxClients; i++)
+  {
+    if (!_clientConnected(i))
+      continue;
+    int pending;
+    while ((pending = Clients[i].connection.available()) > 0)
+    {
+      uint8_t *dst;
+      size_t room = tx.writable(&dst);
+      if (room > _bridgeTxRoom())
+        room = _bridgeTxRoom();
+      if (room == 0 && _bridgeFlushToDevices() > 0)
+      {
+        room = tx.writable(&dst);
+        if (room > _bridgeTxRoom())
+          room = _bridgeTxRoom();
+      }
+      if (room == 0)
+      {
+        // The rest stays in the TCP stack until the device catches up
+        _bridgeOverflowsToDevice++;
+        return;
+      }
+      size_t len = ((size_t)pending < room) ? (size_t)pending : room;
+      int bytesRead = Clients[i].connection.read(dst, len);
+      if (bytesRead <= 0)
+        break;
+      // Read into the first device's ring in place, copied to the others
+      for (byte d = 1; d < _bridgeDeviceCount; d++)
+        _bridgeDevices[d].tx.write(dst, bytesRead);
+      tx.produce(bytesRead);
+      Clients[i].lastActivity_ms = millis();
+    }
+  }
+}
+
+size_t BlaeckTCP::_bridgeFlushToDevices()
+{
+  size_t moved = 0;
+  for (byte d = 0; d < _bridgeDeviceCount; d++)
+    moved += _bridgeFlushToDevice(_bridgeDevices[d]);
+  return moved;
+}
+
+size_t BlaeckTCP::_bridgeFlushToDevice(BridgeDevice &device)
+{
+  size_t moved = 0;
+  const uint8_t *data;
+  size_t len;
+  while ((len = device.tx.readable(&data)) > 0)
+  {
+    // Only as much as the device's TX buffer takes without blocking. A stream
+    // that never reports room (availableForWrite() not implemented) gets
+    // everything, blocking like a plain write().
+    int room = device.stream->availableForWrite();
+    if (room > 0)
+      device.reportsRoom = true;
+    if (device.reportsRoom && (size_t)room < len)
+      len = room;
+    if (len == 0)
+      break;
+    len = device.stream->write(data, len);
+    if (len == 0)
+      break;
+    device.tx.consume(len);
+    _bridgeBytesToDevice += len;
+    moved += len;
+  }
+  return moved;
+}
+
+size_t BlaeckTCP::_bridgeFlushToClients()
+{
+  size_t moved = 0;
+  if (!_bridgeFrameAware && _bridgeDeviceCount == 1)
+  {
+    uint32_t everyone = 0xFFFFFFFFUL;
+    moved = _bridgeSendToClients(0, everyone, (size_t)-1, false);
+  }
+  else
+  {
+    // One unit (a frame, or the bytes between frames) at a time, each to its
+    // own receivers; a unit a client cannot take yet is continued next time.
+    // Several devices take turns unit by unit, so their frames never mix.
+    for (;;)
+    {
+      if (_bridgeOutLeft == 0 && !_bridgeNextUnit())
+        break;
+      if (_bridgeOutFrame && !_bridgeOutStarted && !_bridgeFrameRoom())
+        break;
+      size_t sent = _bridgeSendToClients(_bridgeOutDevice, _bridgeOutMask, _bridgeOutLeft, _bridgeOutFrame);
+      if (sent > 0)
+        _bridgeOutStarted = true;
+      _bridgeOutLeft -= sent;
+      moved += sent;
+      if (_bridgeOutLeft > 0)
+        break;
+    }
+  }
+#if BLAECK_ASYNC_TCP
+  if (moved > 0)
+    _asyncFlush();
+#endif
+  return moved;
+}
+
+// Before the first byte of a frame: wait until every receiver that reports
+// room can take all of it, so it goes out in one write per client. A frame
+// larger than the most room a client ever reported is not waited for, nor is
+// any once the device's RX ring is full (waiting would only lose the bytes
+// behind it); those are paced out at the speed of the slowest receiver.
+bool BlaeckTCP::_bridgeFrameRoom()
+{
+  BlaeckByteRing &rx = _bridgeDevices[_bridgeOutDevice].rx;
+  bool shortOfRoom = false;
+  for (byte client = 0; client < _maxClients; client++)
+  {
+    if (bitRead(_bridgeOutMask, client) == 0 || !_clientConnected(client))
+      continue;
+    int clientRoom = Clients[client].connection.availableForWrite();
+    if (clientRoom > 0)
+      Clients[client].reportsRoom = true;
+    if (clientRoom > Clients[client].mostRoom)
+      Clients[client].mostRoom = clientRoom;
+    if (Clients[client].reportsRoom && (size_t)clientRoom < _bridgeOutLeft &&
+        (size_t)Clients[client].mostRoom >= _bridgeOutLeft)
+      shortOfRoom = true;
+  }
+  return !shortOfRoom || rx.available() >= rx.capacity();
+}
+
+size_t BlaeckTCP::_bridgeSendToClients(byte device, uint32_t &clientMask, size_t maxLen, bool frame)
+{
+  BlaeckByteRing &rx = _bridgeDevices[device].rx;
+  size_t moved = 0;
+  const uint8_t *data;
+  size_t len;
+  while (moved < maxLen && (len = rx.readable(&data)) > 0)
+  {
+    if (len > maxLen - moved)
+      len = maxLen - moved;
+    // All receivers get the same bytes, so the slowest one sets the pace.
+    // A client that never reports room (availableForWrite() not implemented)
+    // gets everything, as in _bridgeFlushToDevice(); once it has reported
+    // room, 0 means full.
+    bool anyClient = false;
+    size_t room = len;
+    for (byte client = 0; client < _maxClients; client++)
+    {
+      if (bitRead(clientMask, client) == 0 || !_clientConnected(client))
+        continue;
+      anyClient = true;
+      int clientRoom = Clients[client].connection.availableForWrite();
+      if (clientRoom > 0)
+        Clients[client].reportsRoom = true;
+      if (Clients[client].reportsRoom && (size_t)clientRoom < room)
+        room = clientRoom;
+    }
+    if (anyClient)
+    {
+      // What a client does not take is lost for it. Of a frame it loses the
+      // rest too: a tail without its head would only garble the next frame.
+      for (byte client = 0; client < _maxClients; client++)
+      {
+        if (bitRead(clientMask, client) == 0 || !_clientConnected(client))
+          continue;
+        size_t written = _clientOut(client).write(data, room);
+        if (written < room && frame)
+        {
+          bitClear(clientMask, client);
+          _bridgeOverflowsToClients += maxLen - moved - written;
+        }
+        else
+        {
+          _bridgeOverflowsToClients += room - written;
+        }
+      }
+      _bridgeBytesToClients += room;
+    }
+    // Without receivers the bytes have nowhere to go
+    rx.consume(room);
+    moved += room;
+    if (room < len)
+      break;
+  }
+  return moved;
+}
+
+void BlaeckTCP::setBridgeFrameAware(bool enable)
+{
+  _bridgeFrameAware = enable;
+  _bridgeOutLeft = 0;
+  for (byte d = 0; d < BLAECK_BRIDGE_MAX_DEVICES; d++)
+    _bridgeDevices[d].scanPos = 0;
+  for (byte i = 0; i < BLAECK_BRIDGE_MAX_REQUESTS; i++)
+  {
+    _bridgeRequests[i].responsePending = 0;
+    _bridgeRequests[i].ackPending = 0;
+  }
+  if (enable && _bridgeMode)
+    _bridgeAllocCommands();
+}
+
+void BlaeckTCP::_bridgeAllocCommands()
+{
+  delete[] _bridgeCommands;
+  _bridgeCommands = nullptr;
+  // Responses are routed by a 32-bit client mask
+  if (_maxClients > 32)
+  {
+    if (StreamRef != nullptr)
+      StreamRef->println("Frame-aware bridge: more than 32 clients, bridging raw bytes");
+    _bridgeFrameAware = false;
+    return;
+  }
+  _bridgeCommands = new (std::nothrow) BridgeCommand[_maxClients];
+  if (_bridgeCommands == nullptr)
+  {
+    if (StreamRef != nullptr)
+      StreamRef->println("Frame-aware bridge: out of memory, bridging raw bytes");
+    _bridgeFrameAware = false;
+    return;
+  }
+  for (byte i = 0; i < _maxClients; i++)
+  {
+    _bridgeCommands[i].len = 0;
+    _bridgeCommands[i].complete = false;
+  }
+}
+
+// Key of the frame the device answers a command with (0: none)
+static byte bridgeResponseKey(const char *text)
+{
+  if (strncmp(text, "BLAECK.WRITE_SYMBOLS", 20) == 0 && (text[20] == ',' || text[20] == '\0'))
+    return 0xB0;
+  if (strncmp(text, "BLAECK.GET_DEVICES", 18) == 0 && (text[18] == ',' || text[18] == '\0'))
+    return 0xB6;
+  if (strncmp(text, "BLAECK.WRITE_DATA", 17) == 0 && (text[17] == ',' || text[17] == '\0'))
+    return 0xD2;
+  if (strncmp(text, "BLAECK.WRITE_COMMANDS", 21) == 0 && (text[21] == ',' || text[21] == '\0'))
+    return 0xE0;
+  return 0;
+}
+
+// Message id: the first four parameters are its bytes, little-endian
+static uint16_t crc16Add(uint16_t crc, byte b);
+
+static void bridgeClearRestart(uint8_t *buf, size_t len)
+{
+  // The device reports a restart once, to the first GET_DEVICES after it;
+  // asked again it would say 0. Fields after the device count and the two
+  // id bytes: name, HW, FW, library version, library name, restarted.
+  size_t pos = 18;
+  for (byte field = 0; field < 5 && pos < len; field++)
+  {
+    while (pos < len && buf[pos] != '\0')
+      pos++;
+    pos++;
+  }
+  if (pos + 1 < len && buf[pos] == '1' && buf[pos + 1] == '\0')
+    buf[pos] = '0';
+}
+
+static size_t bridgeDeviceEntriesEnd(const uint8_t *buf, size_t len)
+{
+  // Device count, then per device msConfig(1) slaveID(1) and 8 fields
+  size_t end = len - 10;
+  size_t pos = 16;
+  for (byte e = 0; e < buf[15] && pos < end; e++)
+  {
+    pos += 2;
+    for (byte field = 0; field < 8 && pos < end; field++)
+    {
+      while (pos < end && buf[pos] != '\0')
+        pos++;
+      pos++;
+    }
+  }
+  return (pos < end) ? pos : end;
+}
+
+static uint32_t bridgeMessageId(const char *text)
+{
+  uint32_t msgId = 0;
+  const char *param = strchr(text, ',');
+  for (byte b = 0; b < 4 && param != nullptr; b++)
+  {
+    msgId |= (uint32_t)(byte)atoi(param + 1) << (8 * b);
+    param = strchr(param + 1, ',');
+  }
+  return msgId;
+}
+
+void BlaeckTCP::_bridgeReadCommands()
+{
+  for (byte i = 0; i < _maxClients; i++)
+  {
+    BridgeCommand &command = _bridgeCommands[i];
+    if (!_clientConnected(i))
+    {
+      command.len = 0;
+      command.complete = false;
+      continue;
+    }
+    for (;;)
+    {
+      if (command.complete)
+      {
+        // The device hashes the text between the markers for its ack
+        command.buf[command.len - 1] = '\0';
+        const char *text = command.buf + 1;
+        byte key = bridgeResponseKey(text);
+        uint32_t msgId = bridgeMessageId(text);
+
+        if (_bridgeCacheComplete(key))
+        {
+          // Not while this client is in the middle of another frame
+          if (_bridgeOutLeft > 0 && bitRead(_bridgeOutMask, i) == 1)
+            break;
+          _bridgeCacheServe(i, key, msgId);
+        }
+        else
+        {
+          // Whole commands only, to every device: wait until all TX rings
+          // have room for all of it
+          if (_bridgeTxRoom() < command.len)
+            _bridgeFlushToDevices();
+          if (_bridgeTxRoom() < command.len)
+          {
+            _bridgeOverflowsToDevice++;
+            break;
+          }
+          for (byte d = 0; d < _bridgeDeviceCount; d++)
+          {
+            _bridgeDevices[d].tx.write((const uint8_t *)command.buf, command.len - 1);
+            _bridgeDevices[d].tx.write((const uint8_t *)">", 1);
+          }
+          // BLAECK.* commands are answered by their frames, not acked
+          _bridgeTrackRequest(i, key, msgId, _fnv1a32(text), strncmp(text, "BLAECK.", 7) != 0);
+        }
+        command.len = 0;
+        command.complete = false;
+      }
+
+      int c = Clients[i].connection.read();
+      if (c < 0)
+        break;
+      Clients[i].lastActivity_ms = millis();
+      if (c == '<')
+      {
+        command.len = 0;
+        command.buf[command.len++] = '<';
+      }
+      else if (command.len == 0)
+      {
+        // Outside a command: nothing the device would act on
+      }
+      else if (c != '>' && command.len > BLAECK_COMMAND_MAX_CHARS_DEFAULT)
+      {
+        command.len = 0;
+        if (StreamRef != nullptr)
+          StreamRef->println("Bridge: command too long, dropped");
+      }
+      else
+      {
+        command.buf[command.len++] = (char)c;
+        command.complete = (c == '>');
+      }
+    }
+  }
+}
+
+void BlaeckTCP::_bridgeTrackRequest(byte client, byte key, uint32_t msgId, uint32_t hash, bool acked)
+{
+  unsigned long now = millis();
+  byte slot = 0;
+  for (byte i = 0; i < BLAECK_BRIDGE_MAX_REQUESTS; i++)
+  {
+    BridgeRequest &r = _bridgeRequests[i];
+    bool inUse = (r.responsePending != 0 || r.ackPending != 0) && now - r.sent_ms < BLAECK_BRIDGE_REQUEST_TIMEOUT_MS;
+    if (!inUse)
+    {
+      slot = i;
+      break;
+    }
+    if ((long)(r.sent_ms - _bridgeRequests[slot].sent_ms) < 0)
+      slot = i;
+  }
+  BridgeRequest &r = _bridgeRequests[slot];
+  r.client = client;
+  // Every device answers for itself
+  byte allDevices = (byte)((1U << _bridgeDeviceCount) - 1);
+  r.responseKey = key;
+  r.responsePending = (key != 0) ? allDevices : 0;
+  r.ackPending = acked ? allDevices : 0;
+  r.msgId = msgId;
+  r.hash = hash;
+  r.sent_ms = now;
+}
+
+bool BlaeckTCP::_bridgeNextUnit()
+{
+  // Round robin: the device after the one that sent last goes first
+  for (byte n = 0; n < _bridgeDeviceCount; n++)
+  {
+    byte d = (_bridgeNextDevice + n) % _bridgeDeviceCount;
+    if (_bridgeNextUnitFrom(d))
+    {
+      _bridgeOutDevice = d;
+      _bridgeNextDevice = (d + 1) % _bridgeDeviceCount;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool BlaeckTCP::_bridgeNextUnitFrom(byte d)
+{
+  BridgeDevice &device = _bridgeDevices[d];
+  BlaeckByteRing &rx = device.rx;
+  static const char frameStart[] = "<BLAECK:";
+  static const char frameEnd[] = "/BLAECK>\r\n";
+  const size_t startLen = 8;
+  const size_t endLen = 10;
+
+  size_t avail = rx.available();
+  if (avail == 0)
+    return false;
+
+  // Header: start marker, key, ':', msgid(4), ':', first payload bytes
+  uint8_t head[19];
+  size_t n = rx.peek(head, sizeof(head));
+  size_t matched = 0;
+  while (matched < n && matched < startLen && head[matched] == (uint8_t)frameStart[matched])
+    matched++;
+
+  if (matched < startLen && matched < n)
+  {
+    // Bytes outside a frame (e.g. debug text) go to everyone, up to the next '<'
+    size_t len = 1;
+    uint8_t c;
+    while (len < avail && rx.peek(&c, 1, len) == 1 && c != '<')
+      len++;
+    _bridgeOutMask = 0xFFFFFFFFUL;
+    _bridgeOutLeft = len;
+    _bridgeOutFrame = false;
+    return true;
+  }
+
+  // A frame: find its end marker
+  size_t pos = (device.scanPos > startLen) ? device.scanPos : startLen;
+  bool found = false;
+  for (; pos + endLen <= avail; pos++)
+  {
+    uint8_t tail[10];
+    if (rx.peek(tail, 1, pos) == 1 && tail[0] == '/' &&
+        rx.peek(tail, endLen, pos) == endLen && memcmp(tail, frameEnd, endLen) == 0)
+    {
+      found = true;
+      break;
+    }
+  }
+  if (!found)
+  {
+    if (avail < rx.capacity())
+    {
+      device.scanPos = pos;
+      return false; // wait for the rest
+    }
+    // Larger than the ring: pass it through to everyone
+    device.scanPos = 0;
+    _bridgeOutMask = 0xFFFFFFFFUL;
+    _bridgeOutLeft = avail;
+    _bridgeOutFrame = false;
+    return true;
+  }
+
+  device.scanPos = 0;
+  size_t frameLen = pos + endLen;
+  uint32_t msgId = 0;
+  uint32_t ackHash = 0;
+  if (n >= 14)
+    msgId = (uint32_t)head[10] | ((uint32_t)head[11] << 8) | ((uint32_t)head[12] << 16) | ((uint32_t)head[13] << 24);
+  if (n >= 19)
+    ackHash = (uint32_t)head[15] | ((uint32_t)head[16] << 8) | ((uint32_t)head[17] << 16) | ((uint32_t)head[18] << 24);
+  byte key = (n > startLen) ? head[startLen] : 0;
+  if (_bridgeDeviceCount > 1 && (key == 0xB0 || key == 0xB6))
+    return _bridgeHoldAnswer(d, key, msgId, frameLen);
+  _bridgeOutMask = (_bridgeFrameAware && key != 0) ? _bridgeRouteFrame(d, key, msgId, ackHash) : 0xFFFFFFFFUL;
+  _bridgeOutLeft = frameLen;
+  _bridgeOutFrame = true;
+  _bridgeOutStarted = false;
+  if (key == 0xB0 || key == 0xB6)
+  {
+    _bridgeTagFrame(device, key, frameLen);
+    _bridgeCacheStore(device, key, frameLen);
+  }
+  else if (key == 0xD2 && n >= 19)
+  {
+    _bridgeCacheCheckData(device, head[15], (uint16_t)head[17] | ((uint16_t)head[18] << 8));
+    if (_bridgeDeviceCount > 1 && !_bridgeRemapData(d, frameLen))
+    {
+      // The clients could not tell whose values these are
+      rx.consume(frameLen);
+      _bridgeOverflowsToClients += frameLen;
+      _bridgeOutLeft = 0;
+    }
+  }
+  return true;
+}
+
+uint32_t BlaeckTCP::_bridgeRouteFrame(byte device, byte key, uint32_t msgId, uint32_t ackHash)
+{
+  // The oldest open request this frame answers
+  unsigned long now = millis();
+  int match = -1;
+  for (byte i = 0; i < BLAECK_BRIDGE_MAX_REQUESTS; i++)
+  {
+    BridgeRequest &r = _bridgeRequests[i];
+    if (now - r.sent_ms >= BLAECK_BRIDGE_REQUEST_TIMEOUT_MS)
+    {
+      r.responsePending = 0;
+      r.ackPending = 0;
+      continue;
+    }
+    bool answers = (key == 0xF0) ? (bitRead(r.ackPending, device) == 1 && r.hash == ackHash)
+                                 : (bitRead(r.responsePending, device) == 1 && r.responseKey == key && r.msgId == msgId);
+    if (answers && (match < 0 || (long)(r.sent_ms - _bridgeRequests[match].sent_ms) < 0))
+      match = i;
+  }
+  if (match < 0)
+    return 0xFFFFFFFFUL; // unsolicited: timed data, messages, ...
+
+  BridgeRequest &r = _bridgeRequests[match];
+  if (key == 0xF0)
+    bitClear(r.ackPending, device);
+  else
+    bitClear(r.responsePending, device);
+  return 1UL << r.client;
+}
+
+void BlaeckTCP::setBridgeCache(bool enable)
+{
+  _bridgeCacheEnabled = enable;
+  if (!enable)
+    clearBridgeCache();
+}
+
+void BlaeckTCP::clearBridgeCache()
+{
+  for (byte d = 0; d < BLAECK_BRIDGE_MAX_DEVICES; d++)
+  {
+    for (byte slot = 0; slot < 2; slot++)
+    {
+      _bridgeDevices[d].cache[slot].len = 0;
+      _bridgeDevices[d].cache[slot].held = false;
+    }
+  }
+}
+
+void BlaeckTCP::_bridgeTagFrame(BridgeDevice &device, byte key, size_t frameLen)
+{
+  // slaveID 0 leaves the device's frames as they are
+  if (device.slaveID == 0)
+    return;
+  size_t end = frameLen - 10; // before "/BLAECK>\r\n"
+  if (key == 0xB6)
+  {
+    // Device count, then msConfig(1) slaveID(1) of the (only) entry
+    uint8_t count;
+    if (end > 17 && device.rx.peek(&count, 1, 15) == 1 && count == 1)
+      device.rx.patch(17, &device.slaveID, 1);
+    return;
+  }
+  // Symbol entries: msConfig(1) slaveID(1) name\0 type(1)
+  size_t pos = 15;
+  while (pos + 4 <= end)
+  {
+    device.rx.patch(pos + 1, &device.slaveID, 1);
+    pos += 2;
+    uint8_t c;
+    while (pos < end && device.rx.peek(&c, 1, pos) == 1 && c != '\0')
+      pos++;
+    pos += 2; // NUL, type
+  }
+}
+
+BlaeckTCP::BridgeCacheEntry *BlaeckTCP::_bridgeCacheFor(BridgeDevice &device, byte key)
+{
+  // Several devices' answers are merged in the cache buffers, cache or not
+  if ((!_bridgeCacheEnabled && _bridgeDeviceCount < 2) || BLAECK_BRIDGE_CACHE_SIZE == 0)
+    return nullptr;
+  if (key == 0xB0)
+    return &device.cache[0];
+  if (key == 0xB6)
+    return &device.cache[1];
+  return nullptr;
+}
+
+bool BlaeckTCP::_bridgeCacheComplete(byte key)
+{
+  // Only if every device's answer is at hand
+  if (!_bridgeCacheEnabled)
+    return false;
+  for (byte d = 0; d < _bridgeDeviceCount; d++)
+  {
+    BridgeCacheEntry *entry = _bridgeCacheFor(_bridgeDevices[d], key);
+    if (entry == nullptr || entry->len == 0 || entry->held)
+      return false;
+  }
+  return _bridgeDeviceCount > 0;
+}
+
+void BlaeckTCP::_bridgeCacheStore(BridgeDevice &device, byte key, size_t frameLen)
+{
+  BridgeCacheEntry *entry = _bridgeCacheFor(device, key);
+  if (entry == nullptr)
+    return;
+  entry->len = 0;
+  // At least the header, ':' and the end marker
+  if (frameLen < 25 || frameLen > BLAECK_BRIDGE_CACHE_SIZE)
+    return;
+  if (entry->buf == nullptr)
+  {
+    entry->buf = new (std::nothrow) uint8_t[BLAECK_BRIDGE_CACHE_SIZE];
+    if (entry->buf == nullptr)
+      return;
+  }
+  // Still at the front of the RX ring, nothing of it sent yet
+  if (device.rx.peek(entry->buf, frameLen) != frameLen)
+    return;
+  // Several devices: the answer goes out merged first, as received
+  if (key == 0xB6 && _bridgeDeviceCount < 2)
+    bridgeClearRestart(entry->buf, frameLen);
+  entry->len = frameLen;
+}
+
+void BlaeckTCP::_bridgeCacheCheckData(BridgeDevice &device, byte restartFlag, uint16_t schemaHash)
+{
+  // A restarted device or another signal set: what is cached may be stale.
+  // An answer still held for merging is newer than that.
+  if (restartFlag != 0 || (device.dataSeen && schemaHash != device.dataHash))
+  {
+    for (byte slot = 0; slot < 2; slot++)
+      if (!device.cache[slot].held)
+        device.cache[slot].len = 0;
+  }
+  device.dataSeen = true;
+  device.dataHash = schemaHash;
+}
+
+void BlaeckTCP::_bridgeCacheServe(byte client, byte key, uint32_t msgId)
+{
+  _bridgeWriteMerged(client, key, msgId);
+  _bridgeCacheHits++;
+}
+
+bool BlaeckTCP::_bridgeHoldAnswer(byte d, byte key, uint32_t msgId, size_t frameLen)
+{
+  BridgeDevice &device = _bridgeDevices[d];
+  BridgeCacheEntry &entry = device.cache[(key == 0xB0) ? 0 : 1];
+  if (entry.held)
+  {
+    // Its previous answer still waits for the other devices'
+    _bridgeReleaseAnswers(key);
+    if (entry.held)
+      return false;
+  }
+  uint32_t mask = _bridgeFrameAware ? _bridgeRouteFrame(d, key, msgId, 0) : 0xFFFFFFFFUL;
+  _bridgeTagFrame(device, key, frameLen);
+  _bridgeCacheStore(device, key, frameLen);
+  if (entry.len > 0)
+  {
+    entry.held = true;
+    entry.msgId = msgId;
+    entry.mask = mask;
+    entry.held_ms = millis();
+    if (key == 0xB0)
+      _bridgeLearnLayout(device, entry);
+  }
+  else
+  {
+    if (StreamRef != nullptr)
+      StreamRef->println("Bridge: frame larger than BLAECK_BRIDGE_CACHE_SIZE, dropped");
+    _bridgeOverflowsToClients += frameLen;
+    if (key == 0xB0)
+    {
+      device.layoutKnown = false;
+      _bridgeUpdateSchemaHash();
+    }
+  }
+  device.rx.consume(frameLen);
+  _bridgeOutLeft = 0;
+  _bridgeReleaseAnswers(key);
+  return true;
+}
+
+void BlaeckTCP::_bridgeReleaseAnswers(byte key)
+{
+  // Once every device has answered, or the first answer is too old to wait
+  // any longer: one frame to the receivers of any of them
+  byte slot = (key == 0xB0) ? 0 : 1;
+  unsigned long now = millis();
+  bool all = true;
+  bool expired = false;
+  bool any = false;
+  uint32_t mask = 0;
+  uint32_t msgId = 0;
+  for (byte d = 0; d < _bridgeDeviceCount; d++)
+  {
+    const BridgeCacheEntry &entry = _bridgeDevices[d].cache[slot];
+    if (!entry.held)
+    {
+      all = false;
+      continue;
+    }
+    if (!any)
+      msgId = entry.msgId;
+    any = true;
+    mask |= entry.mask;
+    if (now - entry.held_ms >= BLAECK_BRIDGE_REQUEST_TIMEOUT_MS)
+      expired = true;
+  }
+  if (!any || (!all && !expired))
+    return;
+
+  // A device that has never sent its symbol list holds the symbol answer
+  // back (see _bridgeWriteMerged()); the request is dropped
+  if (!all && key == 0xB0 && StreamRef != nullptr)
+    for (byte d = 0; d < _bridgeDeviceCount; d++)
+      if (_bridgeDevices[d].cache[0].len == 0)
+      {
+        StreamRef->println("Bridge: a device sent no symbol list, answer dropped");
+        break;
+      }
+  for (byte client = 0; client < _maxClients; client++)
+    if (bitRead(mask, client) == 1 && _clientConnected(client))
+      _bridgeWriteMerged(client, key, msgId);
+  for (byte d = 0; d < _bridgeDeviceCount; d++)
+  {
+    BridgeCacheEntry &entry = _bridgeDevices[d].cache[slot];
+    if (!entry.held)
+      continue;
+    entry.held = false;
+    if (key == 0xB6)
+      bridgeClearRestart(entry.buf, entry.len);
+  }
+}
+
+void BlaeckTCP::_bridgeWriteMerged(byte client, byte key, uint32_t msgId)
+{
+  // The first device's header with the requester's message id (offsets
+  // 10..13), then every device's entries. The symbol list only with every
+  // device's: data frames are numbered as if all were listed. A device list
+  // may lack one, its entries carry no indices.
+  byte slot = (key == 0xB0) ? 0 : 1;
+  const BridgeCacheEntry *first = nullptr;
+  for (byte d = 0; d < _bridgeDeviceCount; d++)
+  {
+    if (_bridgeDevices[d].cache[slot].len == 0)
+    {
+      if (key == 0xB0)
+        return;
+    }
+    else if (first == nullptr)
+      first = &_bridgeDevices[d].cache[slot];
+  }
+  if (first == nullptr)
+    return;
+
+  Print &out = _frameBegin(client);
+  out.write(first->buf, 10);
+  ulngCvt.val = msgId;
+  out.write(ulngCvt.bval, 4);
+  out.write(first->buf[14]);
+  if (key == 0xB0)
+  {
+    for (byte d = 0; d < _bridgeDeviceCount; d++)
+    {
+      const BridgeCacheEntry &entry = _bridgeDevices[d].cache[slot];
+      out.write(entry.buf + 15, entry.len - 25);
+    }
+  }
+  else
+  {
+    // Device count, the entries, then the client fields of the first
+    byte count = 0;
+    for (byte d = 0; d < _bridgeDeviceCount; d++)
+      if (_bridgeDevices[d].cache[slot].len > 0)
+        count += _bridgeDevices[d].cache[slot].buf[15];
+    out.write(count);
+    for (byte d = 0; d < _bridgeDeviceCount; d++)
+    {
+      const BridgeCacheEntry &entry = _bridgeDevices[d].cache[slot];
+      if (entry.len > 0)
+        out.write(entry.buf + 16, bridgeDeviceEntriesEnd(entry.buf, entry.len) - 16);
+    }
+    size_t trailer = bridgeDeviceEntriesEnd(first->buf, first->len);
+    out.write(first->buf + trailer, first->len - 10 - trailer);
+  }
+  out.write(first->buf + first->len - 10, 10);
+  _frameEnd(client);
+}
+
+void BlaeckTCP::_bridgeLearnLayout(BridgeDevice &device, const BridgeCacheEntry &symbols)
+{
+  // Symbol entries: msConfig(1) slaveID(1) name\0 type(1)
+  const uint8_t *buf = symbols.buf;
+  size_t end = symbols.len - 10;
+  device.layoutKnown = false;
+  uint16_t count = 0;
+  size_t pos = 15;
+  while (pos < end)
+  {
+    pos += 2;
+    while (pos < end && buf[pos] != '\0')
+      pos++;
+    if (pos + 1 >= end || buf[pos + 1] > Blaeck_string)
+    {
+      _bridgeUpdateSchemaHash();
+      return;
+    }
+    pos += 2;
+    count++;
+  }
+  if (count != device.signalCount || device.types == nullptr)
+  {
+    delete[] device.types;
+    device.types = (count > 0) ? new (std::nothrow) byte[count] : nullptr;
+    device.signalCount = (device.types != nullptr) ? count : 0;
+    if (device.types == nullptr && count > 0)
+    {
+      _bridgeUpdateSchemaHash();
+      return;
+    }
+  }
+
+  // Its schema hash, as the device computes it: names and type codes
+  uint16_t crc = 0;
+  size_t bytes = 0;
+  pos = 15;
+  for (uint16_t i = 0; i < count; i++)
+  {
+    pos += 2;
+    for (; buf[pos] != '\0'; pos++, bytes++)
+      crc = crc16Add(crc, buf[pos]);
+    device.types[i] = buf[pos + 1];
+    crc = crc16Add(crc, buf[pos + 1]);
+    bytes++;
+    pos += 2;
+  }
+  device.symbolHash = crc;
+  device.symbolBytes = bytes;
+  device.layoutKnown = true;
+  _bridgeUpdateSchemaHash();
+}
+
+void BlaeckTCP::_bridgeForgetLayout(BridgeDevice &device)
+{
+  // Its cached symbol list no longer describes its data either
+  device.layoutKnown = false;
+  if (!device.cache[0].held)
+    device.cache[0].len = 0;
+  _bridgeUpdateSchemaHash();
+}
+
+void BlaeckTCP::_bridgeUpdateSchemaHash()
+{
+  // CRC16 is linear: the hash of the merged list is each device's hash with
+  // the ones before it run on over that device's bytes as if they were 0
+  uint16_t crc = 0;
+  for (byte d = 0; d < _bridgeDeviceCount && _bridgeDevices[d].layoutKnown; d++)
+  {
+    for (size_t i = 0; i < _bridgeDevices[d].symbolBytes; i++)
+      crc = crc16Add(crc, 0);
+    crc ^= _bridgeDevices[d].symbolHash;
+  }
+  _bridgeSchemaHash = crc;
+}
+
+bool BlaeckTCP::_bridgeRemapData(byte d, size_t frameLen)
+{
+  // restart(1) : hash(2) : tsMode(1) [timestamp(8)] : values status(1)
+  // statusPayload(4) crc(4), after the 15 header bytes
+  // Only once every device's symbol list is known: the merged list and its
+  // hash cover all of them
+  BridgeDevice &device = _bridgeDevices[d];
+  BlaeckByteRing &rx = device.rx;
+  uint16_t offset = 0;
+  for (byte e = 0; e < _bridgeDeviceCount; e++)
+  {
+    if (!_bridgeDevices[e].layoutKnown)
+      return false;
+    if (e < d)
+      offset += _bridgeDevices[e].signalCount;
+  }
+  uint8_t head[22];
+  if (frameLen < sizeof(head) + 19 || rx.peek(head, sizeof(head)) != sizeof(head))
+    return false;
+  if (((uint16_t)head[17] | ((uint16_t)head[18] << 8)) != device.symbolHash)
+  {
+    // Another signal set than its last symbol list
+    _bridgeForgetLayout(device);
+    return false;
+  }
+  // Not to be passed on with a new CRC if it arrived damaged
+  size_t crcPos = frameLen - 14;
+  uint8_t crcBytes[4];
+  ulngCvt.val = _bridgeFrameCrc(rx, frameLen);
+  if (rx.peek(crcBytes, 4, crcPos) != 4 || memcmp(crcBytes, ulngCvt.bval, 4) != 0)
+    return false;
+
+  // The mode byte is sent without a timestamp when there is no callback
+  size_t end = crcPos - 5;
+  size_t start;
+  uint8_t colon;
+  if (head[20] != 0 && rx.peek(&colon, 1, 29) == 1 && colon == ':' && _bridgeWalkData(device, 30, end, 0))
+    start = 30;
+  else if (head[21] == ':' && _bridgeWalkData(device, 22, end, 0))
+    start = 22;
+  else
+  {
+    _bridgeForgetLayout(device);
+    return false;
+  }
+  if (offset != 0)
+    _bridgeWalkData(device, start, end, offset);
+  uint8_t hash[2] = {(uint8_t)_bridgeSchemaHash, (uint8_t)(_bridgeSchemaHash >> 8)};
+  rx.patch(17, hash, 2);
+  ulngCvt.val = _bridgeFrameCrc(rx, frameLen);
+  rx.patch(crcPos, ulngCvt.bval, 4);
+  return true;
+}
+
+bool BlaeckTCP::_bridgeWalkData(BridgeDevice &device, size_t pos, size_t end, uint16_t offset)
+{
+  // index(2) value, up to the status byte; an offset renumbers the indices
+  BlaeckByteRing &rx = device.rx;
+  while (pos < end)
+  {
+    uint8_t field[3]; // index, string length
+    if (pos + 3 > end || rx.peek(field, 3, pos) != 3)
+      return false;
+    uint16_t index = (uint16_t)field[0] | ((uint16_t)field[1] << 8);
+    if (index >= device.signalCount)
+      return false;
+    if (offset != 0)
+    {
+      uint8_t renumbered[2] = {(uint8_t)(index + offset), (uint8_t)((index + offset) >> 8)};
+      rx.patch(pos, renumbered, 2);
+    }
+    byte type = device.types[index];
+    pos += 2 + ((type == Blaeck_string) ? 1 + field[2] : _dataTypeSize((dataType)type));
+  }
+  return pos == end;
+}
+
+uint32_t BlaeckTCP::_bridgeFrameCrc(BlaeckByteRing &rx, size_t frameLen)
+{
+  // As the device computes it: from the key up to the CRC
+  CRC32 crc;
+  crc.setPolynome(0x04C11DB7);
+  crc.setInitial(0xFFFFFFFF);
+  crc.setXorOut(0xFFFFFFFF);
+  crc.setReverseIn(true);
+  crc.setReverseOut(true);
+  crc.restart();
+  uint8_t chunk[32];
+  for (size_t pos = 8, end = frameLen - 14; pos < end;)
+  {
+    size_t n = (end - pos < sizeof(chunk)) ? end - pos : sizeof(chunk);
+    rx.peek(chunk, n, pos);
+    crc.add(chunk, n);
+    pos += n;
+  }
+  return crc.calc();
+}
+
+BlaeckSignal<bool> BlaeckTCP::addSignal(String signalName, bool *value)
+{
+  return BlaeckSignal<bool>(this, _addSignal(signalName.c_str(), false, Blaeck_bool, value), value);
+}
+
+BlaeckSignal<byte> BlaeckTCP::addSignal(String signalName, byte *value)
+{
+  return BlaeckSignal<byte>(this, _addSignal(signalName.c_str(), false, Blaeck_byte, value), value);
+}
+
+BlaeckSignal<short> BlaeckTCP::addSignal(String signalName, short *value)
+{
+  return BlaeckSignal<short>(this, _addSignal(signalName.c_str(), false, Blaeck_short, value), value);
+}
+
+BlaeckSignal<unsigned short> BlaeckTCP::addSignal(String signalName, unsigned short *value)
+{
+  return BlaeckSignal<unsigned short>(this, _addSignal(signalName.c_str(), false, Blaeck_ushort, value), value);
+}
+
+BlaeckSignal<int> BlaeckTCP::addSignal(String signalName, int *value)
+{
+  return BlaeckSignal<int>(this, _addSignal(signalName.c_str(), false, BLAECK_TYPE_INT, value), value);
+}
+
+BlaeckSignal<unsigned int> BlaeckTCP::addSignal(String signalName, unsigned int *value)
+{
+  return BlaeckSignal<unsigned int>(this, _addSignal(signalName.c_str(), false, BLAECK_TYPE_UINT, value), value);
+}
+
+BlaeckSignal<long> BlaeckTCP::addSignal(String signalName, long *value)
+{
+  return BlaeckSignal<long>(this, _addSignal(signalName.c_str(), false, Blaeck_long, value), value);
+}
+
+BlaeckSignal<unsigned long> BlaeckTCP::addSignal(String signalName, unsigned long *value)
+{
+  return BlaeckSignal<unsigned long>(this, _addSignal(signalName.c_str(), false, Blaeck_ulong, value), value);
+}
+
+BlaeckSignal<float> BlaeckTCP::addSignal(String signalName, float *value)
+{
+  return BlaeckSignal<float>(this, _addSignal(signalName.c_str(), false, Blaeck_float, value), value);
+}
+
+BlaeckSignal<double> BlaeckTCP::addSignal(String signalName, double *value)
+{
+  return BlaeckSignal<double>(this, _addSignal(signalName.c_str(), false, BLAECK_TYPE_DOUBLE, value), value);
+}
+
+BlaeckSignal<char> BlaeckTCP::addSignal(String signalName, char *value)
+{
+  return BlaeckSignal<char>(this, _addSignal(signalName.c_str(), false, Blaeck_string, value), value);
+}
+
+BlaeckSignal<bool> BlaeckTCP::addSignal(const __FlashStringHelper *signalName, bool *value)
+{
+  return BlaeckSignal<bool>(this, _addSignal(reinterpret_cast<const char *>(signalName), true, Blaeck_bool, value), value);
+}
+
+BlaeckSignal<byte> BlaeckTCP::addSignal(const __FlashStringHelper *signalName, byte *value)
+{
+  return BlaeckSignal<byte>(this, _addSignal(reinterpret_cast<const char *>(signalName), true, Blaeck_byte, value), value);
+}
+
+BlaeckSignal<short> BlaeckTCP::addSignal(const __FlashStringHelper *signalName, short *value)
+{
+  return BlaeckSignal<short>(this, _addSignal(reinterpret_cast<const char *>(signalName), true, Blaeck_short, value), value);
+}
+
+BlaeckSignal<unsigned short> BlaeckTCP::addSignal(const __FlashStringHelper *signalName, unsigned short *value)
+{
+  return BlaeckSignal<unsigned short>(this, _addSignal(reinterpret_cast<const char *>(signalName), true, Blaeck_ushort, value), value);
+}
+
+BlaeckSignal<int> BlaeckTCP::addSignal(const __FlashStringHelper *signalName, int *value)
+{
+  return BlaeckSignal<int>(this, _addSignal(reinterpret_cast<const char *>(signalName), true, BLAECK_TYPE_INT, value), value);
+}
+
+BlaeckSignal<unsigned int> BlaeckTCP::addSignal(const __FlashStringHelper *signalName, unsigned int *value)
+{
+  return BlaeckSignal<unsigned int>(this, _addSignal(reinterpret_cast<const char *>(signalName), true, BLAECK_TYPE_UINT, value), value);
+}
+
+BlaeckSignal<long> BlaeckTCP::addSignal(const __FlashStringHelper *signalName, long *value)
+{
+  return BlaeckSignal<long>(this, _addSignal(reinterpret_cast<const char *>(signalName), true, Blaeck_long, value), value);
+}
+
+BlaeckSignal<unsigned long> BlaeckTCP::addSignal(const __FlashStringHelper *signalName, unsigned long *value)
+{
+  return BlaeckSignal<unsigned long>(this, _addSignal(reinterpret_cast<const char *>(signalName), true, Blaeck_ulong, value), value);
+}
+
+BlaeckSignal<float> BlaeckTCP::addSignal(const __FlashStringHelper *signalName, float *value)
+{
+  return BlaeckSignal<float>(this, _addSignal(reinterpret_cast<const char *>(signalName), true, Blaeck_float, value), value);
+}
+
+BlaeckSignal<double> BlaeckTCP::addSignal(const __FlashStringHelper *signalName, double *value)
+{
+  return BlaeckSignal<double>(this, _addSignal(reinterpret_cast<const char *>(signalName), true, BLAECK_TYPE_DOUBLE, value), value);
+}
+
+BlaeckSignal<char> BlaeckTCP::addSignal(const __FlashStringHelper *signalName, char *value)
+{
+  return BlaeckSignal<char>(this, _addSignal(reinterpret_cast<const char *>(signalName), true, Blaeck_string, value), value);
+}
+
+int BlaeckTCP::_addSignal(const char *signalName, bool nameInFlash, byte type, void *address)
+{
+  _staticSchema = nullptr;
+  if (_signalAddress == nullptr || static_cast<unsigned int>(_signalIndex) >= _signalCapacity ||
+      !_setSignalName(_signalIndex, signalName, nameInFlash))
+  {
+    _signalOverflowOccurred = true;
+    _signalOverflowCount++;
+    return -1;
+  }
+  _signalType[_signalIndex] = type;
+  _signalAddress[_signalIndex] = address;
+  _signalIndex++;
+  SignalCount = _signalIndex;
+  _schemaHash = _schemaHashAdd(_schemaHash, _signalIndex - 1, _signalIndex);
+  _snapshotStale = true;
+  return _signalIndex - 1;
+}
+
+int BlaeckTCP::_addSignalArray(const char *baseName, bool nameInFlash, byte type, void *values, size_t elementSize, unsigned int count)
+{
+  _staticSchema = nullptr;
+  int first = _signalIndex;
+  // Element numbers are kept from the first array on; tables without arrays
+  // never allocate them.
+  if (_signalAddress != nullptr && _signalArrayElement == nullptr)
+    _signalArrayElement = (uint16_t *)_tableAlloc(_signalCapacity * sizeof(uint16_t));
+  if (count == 0 || _signalArrayElement == nullptr || first + count > _signalCapacity ||
+      !_setSignalName(first, baseName, nameInFlash))
+  {
+    _signalOverflowOccurred = true;
+    _signalOverflowCount++;
+    return -1;
+  }
+  // Every element shares the base name and is numbered once, here.
+  for (unsigned int k = 0; k < count; k++)
+  {
+    int i = first + k;
+    byte mask = (byte)(1 << (i & 7));
+    _signalNameRef[i] = _signalNameRef[first];
+    _signalArrayElement[i] = (uint16_t)k;
+    if (nameInFlash)
+      _signalNameInFlash[i >> 3] |= mask;
+    else
+      _signalNameInFlash[i >> 3] &= (byte)~mask;
+    _signalInArray[i >> 3] |= mask;
+    _signalType[i] = type;
+    _signalAddress[i] = (uint8_t *)values + k * elementSize;
+  }
+  _signalIndex += count;
+  SignalCount = _signalIndex;
+  _schemaHash = _schemaHashAdd(_schemaHash, first, _signalIndex);
+  _snapshotStale = true;
+  return first;
+}
+
+bool BlaeckTCP::setSchema(BlaeckSchema &schema)
+{
+  deleteSignals();
+  if (_signalAddress == nullptr)
+    return false;
+  // The schema's names are string constants: they are referenced where they
+  // are, not copied into the name pool.
+  unsigned int fit = schema.signalCount() < _signalCapacity ? schema.signalCount() : _signalCapacity;
+  for (unsigned int i = 0; i < fit; i++)
+  {
+    byte mask = (byte)(1 << (i & 7));
+    _signalNameRef[i] = (uintptr_t)schema.signalName(i);
+    _signalNameInFlash[i >> 3] &= (byte)~mask;
+    _signalInArray[i >> 3] &= (byte)~mask;
+    _signalType[i] = schema.signalType(i);
+    _signalAddress[i] = schema.signalAddress(i);
+  }
+  _signalIndex = (int)fit;
+  _signalNamesInPlace = (int)fit;
+  SignalCount = _signalIndex;
+  if (fit < schema.signalCount())
+  {
+    _signalOverflowOccurred = true;
+    _signalOverflowCount = (uint16_t)(schema.signalCount() - fit);
+    _schemaHash = _schemaHashAdd(0, 0, _signalIndex);
+    if (StreamRef != nullptr)
+      StreamRef->println("Schema does not fit maximumSignalCount");
+    return false;
+  }
+  _schemaHash = schema.hash();
+  _staticSchema = &schema;
+  return true;
+}
+
+void BlaeckTCP::deleteSignals()
+{
+  abortBatch();
+  _staticSchema = nullptr;
+  clearAllUpdateFlags();
+  _signalIndex = 0;
+  _signalGeneration++;
+  _signalNamesUsed = 0;
+  _signalNamesInPlace = 0;
+  SignalCount = _signalIndex;
+  _schemaHash = 0;
+  _signalOverflowOccurred = false;
+  _signalOverflowCount = 0;
+  _snapshotStale = true;
+}
+
+static uint16_t crc16Add(uint16_t crc, byte b)
+{
+  crc ^= ((uint16_t)b << 8);
+  for (byte k = 0; k < 8; k++)
+  {
+    if (crc & 0x8000)
+      crc = (crc << 1) ^ 0x1021;
+    else
+      crc <<= 1;
+  }
+  return crc;
+}
+
+uint16_t BlaeckTCP::_schemaHashAdd(uint16_t crc, int first, int end) const
+{
+  // CRC16-CCITT (init=0x0000, poly=0x1021) over signal names + datatype codes.
+  // Must match Python: binascii.crc_hqx(data, 0) & 0xFFFF
+  // It runs over the signals in order, so adding signals [first, end) only
+  // extends the hash of the ones before.
+  for (int j = first; j < end; j++)
+  {
+    // Feed signal name bytes (UTF-8 / ASCII), from RAM or flash
+    const char *name = _signalName(j);
+    bool inFlash = _isSignalNameInFlash(j);
+    for (;;)
+    {
+      byte b = inFlash ? pgm_read_byte(name++) : (byte)*name++;
+      if (b == 0)
+        break;
+      crc = crc16Add(crc, b);
+    }
+    // Array elements: the "[element]" suffix, as writeSymbols() sends it
+    if (_isSignalInArray(j))
+    {
+      char suffix[8];
+      snprintf(suffix, sizeof(suffix), "[%u]", _signalElement(j));
+      for (const char *c = suffix; *c != '\0'; c++)
+        crc = crc16Add(crc, (byte)*c);
+    }
+    // Feed datatype code byte
+    crc = crc16Add(crc, _signalType[j]);
+  }
+  return crc & 0xFFFF;
+}
+
+bool BlaeckTCP::_setSignalName(int signalIndex, const char *signalName, bool inFlash)
+{
+  if (_signalAddress == nullptr || signalIndex < 0 || signalIndex >= (int)_signalCapacity)
+    return false;
+
+  byte mask = (byte)(1 << (signalIndex & 7));
+  _signalInArray[signalIndex >> 3] &= (byte)~mask;
+  if (inFlash)
+  {
+    // Flash names are streamed from PROGMEM: only the pointer is kept.
+    _signalNameRef[signalIndex] = (uintptr_t)signalName;
+    _signalNameInFlash[signalIndex >> 3] |= mask;
+    return true;
+  }
+
+  // Names are appended to the pool; renaming leaves the old bytes unused
+  // until deleteSignals().
+  size_t len = strlen(signalName) + 1;
+  if (_signalNamesUsed + len > 0xFFFF)
+    return false;
+  if (_signalNamesUsed + len > _signalNamesSize)
+  {
+    // The pool is the arena's last block: just extend it.
+    if (_signalNames != nullptr && _inArena(_signalNames) &&
+        (uint8_t *)_signalNames + _signalNamesSize == _arena + _arenaUsed &&
+        _arenaUsed + len <= _arenaSize)
+    {
+      _arenaUsed += len;
+      if (_arenaUsed > _arenaHighWater)
+        _arenaHighWater = _arenaUsed;
+      _signalNamesSize += len;
+    }
+    else
+    {
+      // The array element table, allocated on the first array, would land
+      // after an arena pool and stop it from growing: reserve it first.
+      size_t elementTable = _signalCapacity * sizeof(uint16_t);
+      if (_signalNames == nullptr && _signalArrayElement == nullptr && _arenaFits(elementTable))
+        _signalArrayElement = (uint16_t *)_tableAlloc(elementTable);
+      // A pool that will be the arena's last block is allocated at the size
+      // needed and grows in place from then on. Anywhere else (heap, or an
+      // arena with too little room left) the first pool has room for names
+      // of about 8 characters and later ones double.
+      unsigned long size = 0;
+      if (!_arenaFits(_signalNamesUsed + len))
+        size = (_signalNames == nullptr) ? (unsigned long)_signalCapacity * 8 + 1 : (unsigned long)_signalNamesSize * 2;
+      if (size < _signalNamesUsed + len)
+        size = _signalNamesUsed + len;
+      if (size > 0xFFFF)
+        size = 0xFFFF;
+      char *names = (char *)_tableAlloc(size);
+      if (names == nullptr)
+        return false;
+      if (_signalNamesUsed > 0)
+        memcpy(names, _signalNames, _signalNamesUsed);
+      _tableFree(_signalNames);
+      _signalNames = names;
+      _signalNamesSize = size;
+    }
+  }
+  memcpy(_signalNames + _signalNamesUsed, signalName, len);
+  _signalNameRef[signalIndex] = _signalNamesUsed;
+  _signalNameInFlash[signalIndex >> 3] &= (byte)~mask;
+  _signalNamesUsed += len;
+  return true;
+}
+
+bool BlaeckTCP::_signalNameEquals(int i, const char *name) const
+{
+  // Compare the stored name as a prefix, then the "[element]" suffix
+  PGM_P p = _signalName(i);
+  bool inFlash = _isSignalNameInFlash(i);
+  char c;
+  while ((c = inFlash ? (char)pgm_read_byte(p++) : *p++) != '\0')
+  {
+    if (c != *name)
+      return false;
+    name++;
+  }
+  if (!_isSignalInArray(i))
+    return *name == '\0';
+  char suffix[8];
+  snprintf(suffix, sizeof(suffix), "[%u]", _signalElement(i));
+  return strcmp(name, suffix) == 0;
+}
+
+size_t BlaeckTCP::_signalStringLimit(int i) const
+{
+  // A char[N] struct member may lack its terminator: read at most N bytes of
+  // it, as long as the signal still points there.
+  if (_staticSchema != nullptr && _signalAddress[i] == _staticSchema->signalAddress(i))
+    return _staticSchema->stringLimit(i);
+  return 255;
+}
+
+void BlaeckTCP::_printSignalName(Print &out, int i) const
+{
+  if (_isSignalNameInFlash(i))
+    out.print(reinterpret_cast<const __FlashStringHelper *>(_signalName(i)));
+  else
+    out.print(_signalName(i));
+  if (_isSignalInArray(i))
+  {
+    out.print('[');
+    out.print(_signalElement(i));
+    out.print(']');
+  }
+}
+
+bool BlaeckTCP::_allocSignalTable(unsigned int capacity)
+{
+  _freeSignalTable();
+  _signalCapacity = capacity;
+
+  size_t bits = (capacity + 7) / 8 + 1;
+  _signalAddress = (void **)_tableAlloc(capacity * sizeof(void *));
+  _signalType = (byte *)_tableAlloc(capacity);
+  _signalUpdated = (byte *)_tableAlloc(bits);
+  _signalBatched = (byte *)_tableAlloc(bits);
+  _signalNameRef = (uintptr_t *)_tableAlloc(capacity * sizeof(uintptr_t));
+  _signalNameInFlash = (byte *)_tableAlloc(bits);
+  _signalInArray = (byte *)_tableAlloc(bits);
+  if (_signalAddress == nullptr || _signalType == nullptr || _signalUpdated == nullptr ||
+      _signalBatched == nullptr || _signalNameRef == nullptr || _signalNameInFlash == nullptr ||
+      _signalInArray == nullptr)
+  {
+    _freeSignalTable();
+    return false;
+  }
+  memset(_signalUpdated, 0, bits);
+  memset(_signalBatched, 0, bits);
+  memset(_signalNameInFlash, 0, bits);
+  memset(_signalInArray, 0, bits);
+  _batchActive = false;
+  // The name pool is created by the first RAM name (_setSignalName()), so a
+  // table of F() names never allocates one.
+  return true;
+}
+
+void BlaeckTCP::_freeSignalTable()
+{
+  _tableFree(_signalAddress);
+  _signalAddress = nullptr;
+  _tableFree(_signalType);
+  _signalType = nullptr;
+  _tableFree(_signalUpdated);
+  _signalUpdated = nullptr;
+  _tableFree(_signalBatched);
+  _signalBatched = nullptr;
+  _tableFree(_signalNameRef);
+  _signalNameRef = nullptr;
+  _tableFree(_signalNameInFlash);
+  _signalNameInFlash = nullptr;
+  _tableFree(_signalInArray);
+  _signalInArray = nullptr;
+  _tableFree(_signalArrayElement);
+  _signalArrayElement = nullptr;
+  _tableFree(_signalNames);
+  _signalNames = nullptr;
+  _signalNamesSize = 0;
+  _signalNamesUsed = 0;
+}
+
+void BlaeckTCP::_allocClientTable(byte count)
+{
+  _freeClientTable();
+  Clients = (BlaeckClient *)_tableAlloc(count * sizeof(BlaeckClient));
+  if (Clients == nullptr)
+    return;
+#if BLAECK_ENABLE_STATS || BLAECK_ENABLE_TRACE
+  _clientPrints = (ClientPrint *)_tableAlloc(count * sizeof(ClientPrint));
+  if (_clientPrints == nullptr)
+  {
+    _tableFree(Clients);
+    Clients = nullptr;
+    return;
+  }
+  for (byte i = 0; i < count; i++)
+  {
+    new (&_clientPrints[i]) ClientPrint();
+    _clientPrints[i].owner = this;
+    _clientPrints[i].client = i;
+  }
+#endif
+  for (byte i = 0; i < count; i++)
+    new (&Clients[i]) BlaeckClient();
+  _clientTableSize = count;
+}
+
+void BlaeckTCP::_freeClientTable()
+{
+  if (Clients == nullptr)
+    return;
+#if BLAECK_ENABLE_STATS || BLAECK_ENABLE_TRACE
+  for (byte i = 0; i < _clientTableSize; i++)
+    _clientPrints[i].~ClientPrint();
+  _tableFree(_clientPrints);
+  _clientPrints = nullptr;
+#endif
+  for (byte i = 0; i < _clientTableSize; i++)
+    Clients[i].~BlaeckClient();
+  _tableFree(Clients);
+  Clients = nullptr;
+  _clientTableSize = 0;
+}
+
+void BlaeckTCP::_resetTables()
+{
+  // Everything carved from the arena goes at once; begin() rebuilds it.
+  _freeSnapshot();
+  _freeClientTable();
+  _freeSignalTable();
+  _arenaUsed = 0;
+}
+
+bool BlaeckTCP::setArena(void *buffer, size_t size)
+{
+  _resetTables();
+  if (_arenaOwned)
+    delete[] _arena;
+  _arena = (uint8_t *)buffer;
+  _arenaSize = (buffer != nullptr) ? size : 0;
+  _arenaOwned = false;
+  _arenaHighWater = 0;
+  return true;
+}
+
+bool BlaeckTCP::setArena(size_t size)
+{
+  uint8_t *block = new (std::nothrow) uint8_t[size];
+  if (block == nullptr)
+    return false;
+  setArena(block, size);
+  _arenaOwned = true;
+  return true;
+}
+
+void *BlaeckTCP::_tableAlloc(size_t size)
+{
+  if (_arenaFits(size))
+  {
+    // Pointer-aligned, enough for every table (and BlaeckClient).
+    const size_t align = sizeof(void *);
+    size_t start = (_arenaUsed + align - 1) & ~(align - 1);
+    _arenaUsed = start + size;
+    if (_arenaUsed > _arenaHighWater)
+      _arenaHighWater = _arenaUsed;
+    return _arena + start;
+  }
+  if (_arena != nullptr && StreamRef != nullptr)
+    StreamRef->println("Arena full, falling back to the heap");
+  return ::operator new(size, std::nothrow);
+}
+
+// Whether _tableAlloc(size) would still come from the arena.
+bool BlaeckTCP::_arenaFits(size_t size) const
+{
+  const size_t align = sizeof(void *);
+  return _arena != nullptr && ((_arenaUsed + align - 1) & ~(align - 1)) + size <= _arenaSize;
+}
+
+void BlaeckTCP::_tableFree(void *block)
+{
+  // Arena blocks are only released as a whole, by _resetTables().
+  if (block == nullptr || _inArena(block))
+    return;
+  ::operator delete(block);
+}
+
+void BlaeckTCP::read()
+{
+#if BLAECK_ENABLE_STATS
+  unsigned long start_us = micros();
+#endif
+#if BLAECK_ASYNC_TCP
+  // Frames still queued from earlier calls go out as lwIP frees room.
+  _asyncFlush();
+#endif
+  bool newData;
+#if BLAECK_NETWORK_TASK
+  if (_netTask != nullptr)
+    newData = _netPollEvents();
+  else
+#endif
+    newData = recvWithStartEndMarkers();
+
+  if (newData == true)
+  {
+    BLAECK_STATS_COUNT(commandsParsed);
+    BLAECK_TRACE_BEGIN(BLAECK_TRACE_PARSE);
+    parseData();
+    BLAECK_TRACE_END(BLAECK_TRACE_PARSE);
+    StreamRef->print("<");
+    StreamRef->print(receivedChars);
+    StreamRef->println(">");
+
+    BLAECK_TRACE_BEGIN(BLAECK_TRACE_DISPATCH);
+    if (strcmp(COMMAND, "BLAECK.WRITE_SYMBOLS") == 0)
+    {
+      unsigned long msg_id = ((unsigned long)PARAMETER[3] << 24) | ((unsigned long)PARAMETER[2] << 16) | ((unsigned long)PARAMETER[1] << 8) | ((unsigned long)PARAMETER[0]);
+
+      this->writeSymbols(msg_id);
+    }
+    else if (strcmp(COMMAND, "BLAECK.WRITE_DATA") == 0)
+    {
+      unsigned long msg_id = ((unsigned long)PARAMETER[3] << 24) | ((unsigned long)PARAMETER[2] << 16) | ((unsigned long)PARAMETER[1] << 8) | ((unsigned long)PARAMETER[0]);
+
+      this->writeAllData(msg_id);
+    }
+    else if (strcmp(COMMAND, "BLAECK.GET_DEVICES") == 0)
+    {
+      unsigned long msg_id = ((unsigned long)PARAMETER[3] << 24) | ((unsigned long)PARAMETER[2] << 16) | ((unsigned long)PARAMETER[1] << 8) | ((unsigned long)PARAMETER[0]);
+
+      // Parse optional identity: <BLAECK.GET_DEVICES,0,0,0,0,Name,Type>
+      // With the network task running, the task already did, on the slot it
+      // received the command on.
+#if BLAECK_NETWORK_TASK
+      if (_netTask == nullptr)
+#endif
+        _parseClientIdentity(_commandingClientNo, receivedChars);
+
+      this->writeDevices(msg_id);
+    }
+#if BLAECK_ENABLE_COMMAND_META
+    else if (strcmp(COMMAND, "BLAECK.WRITE_COMMANDS") == 0)
+    {
+      unsigned long msg_id = ((unsigned long)PARAMETER[3] << 24) | ((unsigned long)PARAMETER[2] << 16) | ((unsigned long)PARAMETER[1] << 8) | ((unsigned long)PARAMETER[0]);
 
       this->writeCommands(msg_id);
     }
@@ -653,8 +2846,39 @@ void BlaeckTCP::read()
         this->_setTimedDataState(false, _timedInterval_ms);
       }
     }
+    else if (strcmp(COMMAND, "BLAECK.REPLAY") == 0)
+    {
+      unsigned long long since = 0;
+      for (int k = 7; k >= 0; k--)
+        since = (since << 8) | (byte)PARAMETER[k];
+      this->_replayHistory(since);
+    }
+#if BLAECK_ENABLE_STATS
+    else if (strcmp(COMMAND, "BLAECK.GET_STATS") == 0)
+    {
+      unsigned long msg_id = ((unsigned long)PARAMETER[3] << 24) | ((unsigned long)PARAMETER[2] << 16) | ((unsigned long)PARAMETER[1] << 8) | ((unsigned long)PARAMETER[0]);
+
+      this->writeStats(msg_id);
+    }
+#endif
+#if BLAECK_ENABLE_TRACE
+    else if (strcmp(COMMAND, "BLAECK.GET_TRACE") == 0)
+    {
+      unsigned long msg_id = ((unsigned long)PARAMETER[3] << 24) | ((unsigned long)PARAMETER[2] << 16) | ((unsigned long)PARAMETER[1] << 8) | ((unsigned long)PARAMETER[0]);
+
+      this->writeTrace(msg_id);
+    }
+#endif
 
     _dispatchRegisteredHandlers();
+    BLAECK_TRACE_END(BLAECK_TRACE_DISPATCH);
+#if BLAECK_ASYNC_TCP
+    // Send what the handlers printed to CommandingClient.
+    _asyncFlush();
+#endif
+#if BLAECK_ENABLE_STATS
+    _stats.read.add(micros() - start_us);
+#endif
   }
 }
 
@@ -1071,26 +3295,30 @@ uint32_t BlaeckTCP::_fnv1a32(const char *s)
 
 void BlaeckTCP::_writeCommandAck(const char *rawCommand, byte status, byte reasonCode)
 {
-  if (!CommandingClient || !CommandingClient.connected())
+  if (status != 0)
+    BLAECK_STATS_COUNT(commandsRejected);
+  if (_commandingClientNo >= _maxClients || !_clientConnected(_commandingClientNo))
     return;
 
-  CommandingClient.write("<BLAECK:");
+  Print &out = _frameBegin(_commandingClientNo);
+  out.write("<BLAECK:");
   byte msg_key = 0xF0;
-  CommandingClient.write(msg_key);
-  CommandingClient.write(":");
+  out.write(msg_key);
+  out.write(":");
   ulngCvt.val = _commandAckMsgId++;
-  CommandingClient.write(ulngCvt.bval, 4);
-  CommandingClient.write(":");
+  out.write(ulngCvt.bval, 4);
+  out.write(":");
 
   // Payload: command hash (4 bytes, little-endian) + status (1) + reason (1).
   ulngCvt.val = _fnv1a32(rawCommand);
-  CommandingClient.write(ulngCvt.bval, 4);
-  CommandingClient.write(status);
-  CommandingClient.write(reasonCode);
+  out.write(ulngCvt.bval, 4);
+  out.write(status);
+  out.write(reasonCode);
 
   // No CRC32 tail: acks mirror the descriptive 0xE0 frame format.
-  CommandingClient.write("/BLAECK>");
-  CommandingClient.write("\r\n");
+  out.write("/BLAECK>");
+  out.write("\r\n");
+  _frameEnd(_commandingClientNo);
 }
 
 #if BLAECK_ENABLE_COMMAND_META
@@ -1206,56 +3434,436 @@ byte BlaeckTCP::_validateTypedCommand(byte handlerIndex)
 
 bool BlaeckTCP::recvWithStartEndMarkers()
 {
-  bool newData = false;
-  static boolean recvInProgress = false;
-  static byte ndx = 0;
-  char startMarker = '<';
-  char endMarker = '>';
+  _acceptClients();
+
+  byte clientNo = 0xFF;
+  BLAECK_TRACE_BEGIN(BLAECK_TRACE_RECEIVE);
+  bool newData = _receiveCommand(receivedChars, clientNo);
+  BLAECK_TRACE_END(BLAECK_TRACE_RECEIVE);
+  if (newData)
+  {
+    _commandingClientNo = clientNo;
+    CommandingClient = Clients[clientNo].connection;
+  }
+
+  // stop any clients which disconnect
+  _pruneClients();
+
+  return newData;
+}
 
+void BlaeckTCP::_acceptClients()
+{
+  // At most one connection per call, so a reconnect storm costs each loop a
+  // single accept. Everything written here is one write() of a preformatted
+  // buffer: a slow debug stream or client must not stall sampling.
+  BLAECK_TRACE_SCOPE(BLAECK_TRACE_ACCEPT);
+#if BLAECK_ASYNC_TCP
+  BlaeckConnection newClient = _asyncAccept();
+#else
   NetClient newClient = TelnetPrint.accept();
+#endif
+
+  if (!newClient)
+    return;
 
-  if (newClient)
+  char peer[32] = "";
+  IPAddress ip = newClient.remoteIP();
+  if (ip != IPAddress(0, 0, 0, 0))
   {
+    snprintf(peer, sizeof(peer), ": %u.%u.%u.%u:%u",
+             ip[0], ip[1], ip[2], ip[3], (unsigned int)newClient.remotePort());
+  }
 
-    for (byte i = 0; i < _maxClients; i++)
+  for (byte i = 0; i < _maxClients; i++)
+  {
+    if (!Clients[i].connection)
     {
-      if (!Clients[i].connection)
-      {
-        StreamRef->print("Client #");
-        StreamRef->print(i);
-        StreamRef->print(" connected");
-        IPAddress ip = newClient.remoteIP();
-        if (ip != IPAddress(0, 0, 0, 0))
-        {
-          StreamRef->print(": ");
-          StreamRef->print(ip);
-          StreamRef->print(":");
-          StreamRef->print(newClient.remotePort());
-        }
-        StreamRef->println();
-        newClient.print("Hello, client number: ");
-        newClient.println(i);
-        bool blaeckDataEnabled= bitRead(_blaeckWriteDataClientMask, i);
-        if (blaeckDataEnabled)
-        {
-          newClient.println("You are enabled to receive data messages.");
-        }
-        else
-        {
-          newClient.println("Receiving data messages was disabled for you.");
-        }
-        // Once we "accept", the client is no longer tracked by the server
-        // so we must store it into our list of clients
-        Clients[i].connection = newClient;
-        Clients[i].name[0] = '\0';
-        strcpy(Clients[i].type, "unknown");
-        if (_clientConnectedCallback != NULL)
-          _clientConnectedCallback(i);
+      char text[96];
+      snprintf(text, sizeof(text), "Client #%u connected%s\r\n", i, peer);
+      _printClientEvent(text);
 
-        break;
+      int len = snprintf(text, sizeof(text), "Hello, client number: %u\r\n", i);
+      if (!_bridgeMode)
+      {
+        bool blaeckDataEnabled = bitRead(_blaeckWriteDataClientMask, i);
+        len += snprintf(text + len, sizeof(text) - len, "%s\r\n",
+                        blaeckDataEnabled ? "You are enabled to receive data messages."
+                                          : "Receiving data messages was disabled for you.");
       }
+      newClient.write((const uint8_t *)text, len);
+#if BLAECK_ASYNC_TCP
+      newClient.flush();
+#endif
+
+      // Once we "accept", the client is no longer tracked by the server
+      // so we must store it into our list of clients
+      Clients[i].connection = newClient;
+      Clients[i].name[0] = '\0';
+      strcpy(Clients[i].type, "unknown");
+      Clients[i].connectedSince_ms = millis();
+      Clients[i].lastActivity_ms = Clients[i].connectedSince_ms;
+      Clients[i].reportsRoom = false;
+      Clients[i].mostRoom = 0;
+#if BLAECK_ENABLE_STATS
+      Clients[i].bytesSent = 0;
+#endif
+      _notifyClientConnected(i);
+      return;
+    }
+  }
+
+  // All slots taken: tell the host why instead of leaving it half-open
+  // (msg id 0, outside the writeMessage() sequence), then close.
+  char text[96];
+  int len = snprintf(text, sizeof(text), "Client rejected, server full%s\r\n", peer);
+  StreamRef->write((const uint8_t *)text, len);
+  _writeMessageFrame(newClient, "BLAECK", "Server full", 0);
+  newClient.stop();
+}
+
+void BlaeckTCP::_pruneClients()
+{
+  unsigned long now = millis();
+  for (byte i = 0; i < _maxClients; i++)
+  {
+    if (!Clients[i].connection)
+      continue;
+
+    if (!Clients[i].connection.connected())
+    {
+      _dropClient(i, "disconnected");
+    }
+    else if (_clientTimeout_ms > 0 && now - Clients[i].lastActivity_ms >= _clientTimeout_ms)
+    {
+      _dropClient(i, "timed out");
+    }
+  }
+}
+
+void BlaeckTCP::_dropClient(byte clientNo, const char *reason)
+{
+  BlaeckClient &client = Clients[clientNo];
+  client.connection.stop();
+
+  char text[64];
+  int len = snprintf(text, sizeof(text), "Client #%u %s", clientNo, reason);
+  if (client.name[0] != '\0')
+  {
+    len += snprintf(text + len, sizeof(text) - len, " (%s: %s)", client.type, client.name);
+  }
+  if (len > (int)sizeof(text) - 3)
+    len = sizeof(text) - 3;
+  text[len++] = '\r';
+  text[len++] = '\n';
+  text[len] = '\0';
+  _printClientEvent(text);
+
+  client.name[0] = '\0';
+  strcpy(client.type, "unknown");
+  _notifyClientDisconnected(clientNo);
+}
+
+unsigned long BlaeckTCP::getClientConnectionAge(byte clientNo) const
+{
+  if (clientNo >= _maxClients || Clients == nullptr || !_clientConnected(clientNo))
+    return 0;
+  return millis() - Clients[clientNo].connectedSince_ms;
+}
+
+unsigned long BlaeckTCP::getClientIdleTime(byte clientNo) const
+{
+  if (clientNo >= _maxClients || Clients == nullptr || !_clientConnected(clientNo))
+    return 0;
+  return millis() - Clients[clientNo].lastActivity_ms;
+}
+
+#if BLAECK_ENABLE_STATS
+void BlaeckTCP::resetStats()
+{
+  _stats = BlaeckStats();
+  for (byte i = 0; i < _maxClients && Clients != nullptr; i++)
+    Clients[i].bytesSent = 0;
+}
+
+uint32_t BlaeckTCP::getClientBytesSent(byte clientNo) const
+{
+  if (clientNo >= _maxClients || Clients == nullptr || !_clientConnected(clientNo))
+    return 0;
+  return Clients[clientNo].bytesSent;
+}
+
+void BlaeckTCP::writeStats()
+{
+  this->writeStats(1);
+}
+
+void BlaeckTCP::writeStats(unsigned long msg_id)
+{
+  for (byte client = 0; client < _maxClients; client++)
+  {
+    if (_clientConnected(client))
+    {
+      this->writeStats(msg_id, client);
+    }
+  }
+}
+
+void BlaeckTCP::writeStats(unsigned long msg_id, byte i)
+{
+  // The values as they were before this frame's own bytes were counted
+  BlaeckStats stats = _stats;
+
+  Print &out = _frameBegin(i);
+  out.write("<BLAECK:");
+  byte msg_key = 0xC0;
+  out.write(msg_key);
+  out.write(":");
+  ulngCvt.val = msg_id;
+  out.write(ulngCvt.bval, 4);
+  out.write(":");
+
+  // Counters, 4 bytes each, little-endian
+  const uint32_t counters[] = {stats.dataFrames, stats.bytesSent, stats.writeStalls,
+                               stats.commandsParsed, stats.commandsRejected};
+  for (byte k = 0; k < 5; k++)
+  {
+    ulngCvt.val = counters[k];
+    out.write(ulngCvt.bval, 4);
+  }
+
+  // Timer count, then count, min, max and mean (us) of each
+  const BlaeckTimer *timers[] = {&stats.tick, &stats.read, &stats.writeData, &stats.socketWrite};
+  out.write((byte)4);
+  for (byte k = 0; k < 4; k++)
+  {
+    const uint32_t values[] = {timers[k]->count, timers[k]->min_us, timers[k]->max_us, timers[k]->mean_us()};
+    for (byte v = 0; v < 4; v++)
+    {
+      ulngCvt.val = values[v];
+      out.write(ulngCvt.bval, 4);
+    }
+  }
+
+  // Client count, then the bytes sent to each (0: not connected)
+  out.write(_maxClients);
+  for (byte client = 0; client < _maxClients; client++)
+  {
+    ulngCvt.val = getClientBytesSent(client);
+    out.write(ulngCvt.bval, 4);
+  }
+
+  // No CRC32 tail, like the other descriptive frames
+  out.write("/BLAECK>");
+  out.write("\r\n");
+  _frameEnd(i);
+}
+#endif
+
+#if BLAECK_ENABLE_TRACE
+static const char *const traceNames[BLAECK_TRACE_POINT_COUNT] = {
+    "tick", "accept", "receive", "parse", "dispatch",
+    "before_write", "serialize", "crc", "socket_write"};
+
+void BlaeckTCP::_traceRecord(byte point, bool end)
+{
+  if (_tracePaused || bitRead(_traceMask, point) == 0)
+    return;
+  BlaeckTraceEvent &event = _trace[_traceHead];
+  event.cycles = blaeckTraceClock();
+  event.point = point;
+  event.end = end;
+  _traceHead = (_traceHead + 1) % BLAECK_TRACE_SIZE;
+  if (_traceCount < BLAECK_TRACE_SIZE)
+    _traceCount++;
+}
+
+void BlaeckTCP::clearTrace()
+{
+  _traceHead = 0;
+  _traceCount = 0;
+}
+
+bool BlaeckTCP::getTraceEvent(unsigned int index, BlaeckTraceEvent &event) const
+{
+  if (index >= _traceCount)
+    return false;
+  event = _trace[(_traceHead + BLAECK_TRACE_SIZE - _traceCount + index) % BLAECK_TRACE_SIZE];
+  return true;
+}
+
+uint32_t BlaeckTCP::getTraceClockHz() const
+{
+#if defined(ESP32) || defined(ESP8266)
+  return ESP.getCpuFreqMHz() * 1000000UL;
+#elif defined(DWT_CTRL_CYCCNTENA_Msk)
+  return SystemCoreClock;
+#else
+  return 1000000UL;
+#endif
+}
+
+void BlaeckTCP::dumpTrace()
+{
+  if (StreamRef != nullptr)
+    this->dumpTrace(*StreamRef);
+}
+
+void BlaeckTCP::dumpTrace(Print &out)
+{
+  _tracePaused = true;
+
+  char line[80];
+  int len = snprintf(line, sizeof(line), "Trace: %u events, %lu Hz\r\n",
+                     _traceCount, (unsigned long)getTraceClockHz());
+  out.write((const uint8_t *)line, len);
+
+  // Phases still open at this event: indentation, and the start of each
+  // so end events can show a duration. Deeper nesting is not indented.
+  byte openPoint[8];
+  uint32_t openCycles[8];
+  byte depth = 0;
+
+  BlaeckTraceEvent first;
+  BlaeckTraceEvent event;
+  getTraceEvent(0, first);
+  for (unsigned int k = 0; k < _traceCount; k++)
+  {
+    getTraceEvent(k, event);
+
+    // An end whose begin fell out of the ring has no duration
+    int open = -1;
+    if (event.end)
+    {
+      for (int d = depth - 1; d >= 0 && open < 0; d--)
+        if (openPoint[d] == event.point)
+          open = d;
+      if (open >= 0)
+        depth = open;
+    }
+
+    len = snprintf(line, sizeof(line), "%10lu %*s%s %c",
+                   (unsigned long)(event.cycles - first.cycles), depth * 2, "",
+                   traceNames[event.point], event.end ? '}' : '{');
+    if (open >= 0)
+      len += snprintf(line + len, sizeof(line) - len, " %lu", (unsigned long)(event.cycles - openCycles[open]));
+    line[len++] = '\r';
+    line[len++] = '\n';
+    out.write((const uint8_t *)line, len);
+
+    if (!event.end && depth < 8)
+    {
+      openPoint[depth] = event.point;
+      openCycles[depth] = event.cycles;
+      depth++;
+    }
+  }
+
+  _tracePaused = false;
+}
+
+void BlaeckTCP::writeTrace()
+{
+  this->writeTrace(1);
+}
+
+void BlaeckTCP::writeTrace(unsigned long msg_id)
+{
+  // The frame's own socket writes would overwrite the events it carries
+  _tracePaused = true;
+  for (byte client = 0; client < _maxClients; client++)
+  {
+    if (_clientConnected(client))
+    {
+      this->writeTrace(msg_id, client);
     }
   }
+  _tracePaused = false;
+}
+
+void BlaeckTCP::writeTrace(unsigned long msg_id, byte i)
+{
+  Print &out = _frameBegin(i);
+  out.write("<BLAECK:");
+  byte msg_key = 0xC1;
+  out.write(msg_key);
+  out.write(":");
+  ulngCvt.val = msg_id;
+  out.write(ulngCvt.bval, 4);
+  out.write(":");
+
+  // Clock (Hz, 4 bytes) and event count (2 bytes), little-endian
+  ulngCvt.val = getTraceClockHz();
+  out.write(ulngCvt.bval, 4);
+  out.write((byte)(_traceCount & 0xFF));
+  out.write((byte)(_traceCount >> 8));
+
+  // Oldest first: timestamp (4 bytes), then the point with bit 7 set on end events
+  BlaeckTraceEvent event;
+  for (unsigned int k = 0; k < _traceCount; k++)
+  {
+    getTraceEvent(k, event);
+    ulngCvt.val = event.cycles;
+    out.write(ulngCvt.bval, 4);
+    out.write((byte)(event.point | (event.end ? 0x80 : 0)));
+  }
+
+  // No CRC32 tail, like the other descriptive frames
+  out.write("/BLAECK>");
+  out.write("\r\n");
+  _frameEnd(i);
+}
+#endif
+
+void BlaeckTCP::_notifyClientConnected(byte clientNo)
+{
+#if BLAECK_NETWORK_TASK
+  if (_netTask != nullptr)
+  {
+    // Running in the network task: hand the callback over to the loop task.
+    _netConnectedMask |= (1UL << clientNo);
+    _netPushEvent(NET_EVENT_CONNECTED, clientNo, "");
+    return;
+  }
+#endif
+  if (_clientConnectedCallback != NULL)
+    _clientConnectedCallback(clientNo);
+}
+
+void BlaeckTCP::_notifyClientDisconnected(byte clientNo)
+{
+#if BLAECK_NETWORK_TASK
+  if (_netTask != nullptr)
+  {
+    _netConnectedMask &= ~(1UL << clientNo);
+    _netPushEvent(NET_EVENT_DISCONNECTED, clientNo, "");
+    return;
+  }
+#endif
+  if (_clientDisconnectedCallback != NULL)
+    _clientDisconnectedCallback(clientNo);
+}
+
+void BlaeckTCP::_printClientEvent(const char *text)
+{
+#if BLAECK_NETWORK_TASK
+  if (_netTask != nullptr)
+  {
+    // Running in the network task: only the loop task writes to StreamRef.
+    _netPushEvent(NET_EVENT_TEXT, 0, text);
+    return;
+  }
+#endif
+  StreamRef->write((const uint8_t *)text, strlen(text));
+}
+
+bool BlaeckTCP::_receiveCommand(char *dest, byte &clientNo)
+{
+  bool newData = false;
+  static boolean recvInProgress = false;
+  static byte ndx = 0;
+  char startMarker = '<';
+  char endMarker = '>';
 
   // Use a buffer
   static char tempBuffer[BLAECK_BUFFER_SIZE];
@@ -1269,6 +3877,8 @@ bool BlaeckTCP::recvWithStartEndMarkers()
         // Read data in chunks
         int bytesToRead = min(Clients[i].connection.available(), BLAECK_BUFFER_SIZE);
         int bytesRead = Clients[i].connection.read((uint8_t *)tempBuffer, bytesToRead);
+        if (bytesRead > 0)
+          Clients[i].lastActivity_ms = millis();
 
         // Process each character in the buffer
         for (int j = 0; j < bytesRead && !newData; j++)
@@ -1281,17 +3891,17 @@ bool BlaeckTCP::recvWithStartEndMarkers()
             {
               if (ndx < MAXIMUM_CHAR_COUNT - 1)
               {
-                receivedChars[ndx] = rc;
+                dest[ndx] = rc;
                 ndx++;
               }
             }
             else
             {
-              receivedChars[ndx] = '\0';
+              dest[ndx] = '\0';
               recvInProgress = false;
               ndx = 0;
               newData = true;
-              CommandingClient = Clients[i].connection;
+              clientNo = i;
             }
           }
           else if (rc == startMarker)
@@ -1303,31 +3913,6 @@ bool BlaeckTCP::recvWithStartEndMarkers()
     }
   }
 
-  // stop any clients which disconnect
-  for (byte i = 0; i < _maxClients; i++)
-  {
-    if (Clients[i].connection && !Clients[i].connection.connected())
-    {
-      Clients[i].connection.stop();
-      StreamRef->print("Client #");
-      StreamRef->print(i);
-      StreamRef->print(" disconnected");
-      if (Clients[i].name[0] != '\0')
-      {
-        StreamRef->print(" (");
-        StreamRef->print(Clients[i].type);
-        StreamRef->print(": ");
-        StreamRef->print(Clients[i].name);
-        StreamRef->print(")");
-      }
-      StreamRef->println();
-      Clients[i].name[0] = '\0';
-      strcpy(Clients[i].type, "unknown");
-      if (_clientDisconnectedCallback != NULL)
-        _clientDisconnectedCallback(i);
-    }
-  }
-
   return newData;
 }
 
@@ -1443,7 +4028,7 @@ void BlaeckTCP::writeSymbols()
 {
   for (byte client = 0; client < _maxClients; client++)
   {
-    if (Clients[client].connection.connected())
+    if (_clientConnected(client))
     {
       this->writeSymbols(1, client);
     }
@@ -1454,7 +4039,7 @@ void BlaeckTCP::writeSymbols(unsigned long msg_id)
 {
   for (byte client = 0; client < _maxClients; client++)
   {
-    if (Clients[client].connection.connected())
+    if (_clientConnected(client))
     {
       this->writeSymbols(msg_id, client);
     }
@@ -1463,85 +4048,28 @@ void BlaeckTCP::writeSymbols(unsigned long msg_id)
 
 void BlaeckTCP::writeSymbols(unsigned long msg_id, byte i)
 {
-  Clients[i].connection.write("<BLAECK:");
+  Print &out = _frameBegin(i);
+  out.write("<BLAECK:");
   byte msg_key = 0xB0;
-  Clients[i].connection.write(msg_key);
-  Clients[i].connection.write(":");
+  out.write(msg_key);
+  out.write(":");
   ulngCvt.val = msg_id;
-  Clients[i].connection.write(ulngCvt.bval, 4);
-  Clients[i].connection.write(":");
+  out.write(ulngCvt.bval, 4);
+  out.write(":");
 
   for (int j = 0; j < _signalIndex; j++)
   {
-    Clients[i].connection.write((byte)0);
-    Clients[i].connection.write((byte)0);
+    out.write((byte)0);
+    out.write((byte)0);
 
-    Signal signal = Signals[j];
-    Clients[i].connection.print(signal.SignalName);
-    Clients[i].connection.print('\0');
-
-    switch (signal.DataType)
-    {
-    case (Blaeck_bool):
-    {
-      Clients[i].connection.write((byte)0x0);
-      break;
-    }
-    case (Blaeck_byte):
-    {
-      Clients[i].connection.write(0x1);
-      break;
-    }
-    case (Blaeck_short):
-    {
-      Clients[i].connection.write(0x2);
-      break;
-    }
-    case (Blaeck_ushort):
-    {
-      Clients[i].connection.write(0x3);
-      break;
-    }
-    case (Blaeck_int):
-    {
-      Clients[i].connection.write(0x4);
-      break;
-    }
-    case (Blaeck_uint):
-    {
-      Clients[i].connection.write(0x5);
-      break;
-    }
-    case (Blaeck_long):
-    {
-      Clients[i].connection.write(0x6);
-      break;
-    }
-    case (Blaeck_ulong):
-    {
-      Clients[i].connection.write(0x7);
-      break;
-    }
-    case (Blaeck_float):
-    {
-      Clients[i].connection.write(0x8);
-      break;
-    }
-    case (Blaeck_double):
-    {
-      Clients[i].connection.write(0x9);
-      break;
-    }
-    case (Blaeck_string):
-    {
-      Clients[i].connection.write(0xA);
-      break;
-    }
-    }
+    _printSignalName(out, j);
+    out.print('\0');
+    out.write(_signalType[j]);
   }
 
-  Clients[i].connection.write("/BLAECK>");
-  Clients[i].connection.write("\r\n");
+  out.write("/BLAECK>");
+  out.write("\r\n");
+  _frameEnd(i);
 }
 
 #if BLAECK_ENABLE_COMMAND_META
@@ -1554,7 +4082,7 @@ void BlaeckTCP::writeCommands(unsigned long msg_id)
 {
   for (byte client = 0; client < _maxClients; client++)
   {
-    if (Clients[client].connection.connected())
+    if (_clientConnected(client))
     {
       this->writeCommands(msg_id, client);
     }
@@ -1563,6 +4091,7 @@ void BlaeckTCP::writeCommands(unsigned long msg_id)
 
 void BlaeckTCP::writeCommands(unsigned long msg_id, byte i)
 {
+  Print &out = _frameBegin(i);
   // 0xE0 "Command List" frame. Per discovered command entry:
   //   msConfig(1) slaveID(1) name\0 kind(1) flags(1)
   //   [min(4) max(4) step(4)]  if flags.hasRange   (LE float)
@@ -1576,13 +4105,13 @@ void BlaeckTCP::writeCommands(unsigned long msg_id, byte i)
   // no Home Assistant entity, but are listed so a host can build a full command
   // palette / autocomplete of every command the device accepts.
   // TCP is always a single server device: msConfig and slaveID are hardcoded 0.
-  Clients[i].connection.write("<BLAECK:");
+  out.write("<BLAECK:");
   byte msg_key = 0xE0;
-  Clients[i].connection.write(msg_key);
-  Clients[i].connection.write(":");
+  out.write(msg_key);
+  out.write(":");
   ulngCvt.val = msg_id;
-  Clients[i].connection.write(ulngCvt.bval, 4);
-  Clients[i].connection.write(":");
+  out.write(ulngCvt.bval, 4);
+  out.write(":");
 
   for (byte j = 0; j < MAX_COMMAND_HANDLERS; j++)
   {
@@ -1602,47 +4131,48 @@ void BlaeckTCP::writeCommands(unsigned long msg_id, byte i)
     if (e.kind == BLAECK_CMD_TEXT)
       flags |= 0x10;
 
-    Clients[i].connection.write((byte)0); // msConfig
-    Clients[i].connection.write((byte)0); // slaveID
-    Clients[i].connection.print(e.command);
-    Clients[i].connection.write((byte)0);
-    Clients[i].connection.write(e.kind);
-    Clients[i].connection.write(flags);
+    out.write((byte)0); // msConfig
+    out.write((byte)0); // slaveID
+    out.print(e.command);
+    out.write((byte)0);
+    out.write(e.kind);
+    out.write(flags);
 
     if (flags & 0x01)
     {
       fltCvt.val = e.meta_min;
-      Clients[i].connection.write(fltCvt.bval, 4);
+      out.write(fltCvt.bval, 4);
       fltCvt.val = e.meta_max;
-      Clients[i].connection.write(fltCvt.bval, 4);
+      out.write(fltCvt.bval, 4);
       fltCvt.val = e.meta_step;
-      Clients[i].connection.write(fltCvt.bval, 4);
+      out.write(fltCvt.bval, 4);
     }
     if (flags & 0x02)
     {
-      Clients[i].connection.print(e.unit);
-      Clients[i].connection.write((byte)0);
+      out.print(e.unit);
+      out.write((byte)0);
     }
     if (flags & 0x04)
     {
-      Clients[i].connection.print(e.options);
-      Clients[i].connection.write((byte)0);
+      out.print(e.options);
+      out.write((byte)0);
     }
     if (flags & 0x08)
     {
-      Clients[i].connection.print(e.stateSignal);
-      Clients[i].connection.write((byte)0);
+      out.print(e.stateSignal);
+      out.write((byte)0);
     }
     if (flags & 0x10)
     {
       uint16_t maxLen = (uint16_t)e.meta_max;
-      Clients[i].connection.write((byte)(maxLen & 0xFF));
-      Clients[i].connection.write((byte)((maxLen >> 8) & 0xFF));
+      out.write((byte)(maxLen & 0xFF));
+      out.write((byte)((maxLen >> 8) & 0xFF));
     }
   }
 
-  Clients[i].connection.write("/BLAECK>");
-  Clients[i].connection.write("\r\n");
+  out.write("/BLAECK>");
+  out.write("\r\n");
+  _frameEnd(i);
 }
 #endif
 
@@ -1655,7 +4185,7 @@ void BlaeckTCP::writeMessage(const char *channelName, const char *text, unsigned
 {
   for (byte client = 0; client < _maxClients; client++)
   {
-    if (Clients[client].connection.connected())
+    if (_clientConnected(client))
     {
       this->writeMessage(channelName, text, messageID, client);
     }
@@ -1663,6 +4193,12 @@ void BlaeckTCP::writeMessage(const char *channelName, const char *text, unsigned
 }
 
 void BlaeckTCP::writeMessage(const char *channelName, const char *text, unsigned long messageID, byte i)
+{
+  _writeMessageFrame(_frameBegin(i), channelName, text, messageID);
+  _frameEnd(i);
+}
+
+void BlaeckTCP::_writeMessageFrame(Print &out, const char *channelName, const char *text, unsigned long messageID)
 {
   // 0x90 "Message" frame: a named free-text status/log channel, device -> host.
   //   name\0  length(2, LE uint16)  text[length]
@@ -1680,168 +4216,83 @@ void BlaeckTCP::writeMessage(const char *channelName, const char *text, unsigned
   uint32_t rawLen = (uint32_t)strlen(text);
   uint16_t len = (rawLen > 0xFFFFu) ? (uint16_t)0xFFFFu : (uint16_t)rawLen;
 
-  Clients[i].connection.write("<BLAECK:");
+  out.write("<BLAECK:");
   byte msg_key = 0x90;
-  Clients[i].connection.write(msg_key);
-  Clients[i].connection.write(":");
+  out.write(msg_key);
+  out.write(":");
   ulngCvt.val = messageID;
-  Clients[i].connection.write(ulngCvt.bval, 4);
-  Clients[i].connection.write(":");
+  out.write(ulngCvt.bval, 4);
+  out.write(":");
 
   // Channel name (NUL-terminated), then the UTF-8 text length-prefixed (LE uint16).
-  Clients[i].connection.print(channelName);
-  Clients[i].connection.write((byte)0);
-  Clients[i].connection.write((byte)(len & 0xFF));
-  Clients[i].connection.write((byte)((len >> 8) & 0xFF));
-  Clients[i].connection.write((const uint8_t *)text, len);
+  out.print(channelName);
+  out.write((byte)0);
+  out.write((byte)(len & 0xFF));
+  out.write((byte)((len >> 8) & 0xFF));
+  out.write((const uint8_t *)text, len);
 
-  Clients[i].connection.write("/BLAECK>");
-  Clients[i].connection.write("\r\n");
+  out.write("/BLAECK>");
+  out.write("\r\n");
 }
 
 void BlaeckTCP::update(int signalIndex, bool value)
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-    if (Signals[signalIndex].DataType == Blaeck_bool)
-    {
-      *((bool *)Signals[signalIndex].Address) = value;
-      Signals[signalIndex].Updated = true;
-    }
-  }
+  if (_storeSignalValue(signalIndex, BlaeckWire<bool>::code, &value, BlaeckWire<bool>::size))
+    _setSignalUpdated(signalIndex);
 }
 
 void BlaeckTCP::update(int signalIndex, byte value)
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-    if (Signals[signalIndex].DataType == Blaeck_byte)
-    {
-      *((byte *)Signals[signalIndex].Address) = value;
-      Signals[signalIndex].Updated = true;
-    }
-  }
+  if (_storeSignalValue(signalIndex, BlaeckWire<byte>::code, &value, BlaeckWire<byte>::size))
+    _setSignalUpdated(signalIndex);
 }
 
 void BlaeckTCP::update(int signalIndex, short value)
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-    if (Signals[signalIndex].DataType == Blaeck_short)
-    {
-      *((short *)Signals[signalIndex].Address) = value;
-      Signals[signalIndex].Updated = true;
-    }
-  }
+  if (_storeSignalValue(signalIndex, BlaeckWire<short>::code, &value, BlaeckWire<short>::size))
+    _setSignalUpdated(signalIndex);
 }
 
 void BlaeckTCP::update(int signalIndex, unsigned short value)
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-    if (Signals[signalIndex].DataType == Blaeck_ushort)
-    {
-      *((unsigned short *)Signals[signalIndex].Address) = value;
-      Signals[signalIndex].Updated = true;
-    }
-  }
+  if (_storeSignalValue(signalIndex, BlaeckWire<unsigned short>::code, &value, BlaeckWire<unsigned short>::size))
+    _setSignalUpdated(signalIndex);
 }
 
 void BlaeckTCP::update(int signalIndex, int value)
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-#ifdef __AVR__
-    if (Signals[signalIndex].DataType == Blaeck_int)
-    {
-      *((int *)Signals[signalIndex].Address) = value;
-      Signals[signalIndex].Updated = true;
-    }
-#else
-    if (Signals[signalIndex].DataType == Blaeck_long)
-    {
-      *((int *)Signals[signalIndex].Address) = value;
-      Signals[signalIndex].Updated = true;
-    }
-#endif
-  }
+  if (_storeSignalValue(signalIndex, BlaeckWire<int>::code, &value, BlaeckWire<int>::size))
+    _setSignalUpdated(signalIndex);
 }
 
 void BlaeckTCP::update(int signalIndex, unsigned int value)
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-#ifdef __AVR__
-    if (Signals[signalIndex].DataType == Blaeck_uint)
-    {
-      *((unsigned int *)Signals[signalIndex].Address) = value;
-      Signals[signalIndex].Updated = true;
-    }
-#else
-    if (Signals[signalIndex].DataType == Blaeck_ulong)
-    {
-      *((unsigned int *)Signals[signalIndex].Address) = value;
-      Signals[signalIndex].Updated = true;
-    }
-#endif
-  }
+  if (_storeSignalValue(signalIndex, BlaeckWire<unsigned int>::code, &value, BlaeckWire<unsigned int>::size))
+    _setSignalUpdated(signalIndex);
 }
 
 void BlaeckTCP::update(int signalIndex, long value)
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-    if (Signals[signalIndex].DataType == Blaeck_long)
-    {
-      *((long *)Signals[signalIndex].Address) = value;
-      Signals[signalIndex].Updated = true;
-    }
-  }
+  if (_storeSignalValue(signalIndex, BlaeckWire<long>::code, &value, BlaeckWire<long>::size))
+    _setSignalUpdated(signalIndex);
 }
 
 void BlaeckTCP::update(int signalIndex, unsigned long value)
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-    if (Signals[signalIndex].DataType == Blaeck_ulong)
-    {
-      *((unsigned long *)Signals[signalIndex].Address) = value;
-      Signals[signalIndex].Updated = true;
-    }
-  }
+  if (_storeSignalValue(signalIndex, BlaeckWire<unsigned long>::code, &value, BlaeckWire<unsigned long>::size))
+    _setSignalUpdated(signalIndex);
 }
 
 void BlaeckTCP::update(int signalIndex, float value)
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-    if (Signals[signalIndex].DataType == Blaeck_float)
-    {
-      *((float *)Signals[signalIndex].Address) = value;
-      Signals[signalIndex].Updated = true;
-    }
-  }
+  if (_storeSignalValue(signalIndex, BlaeckWire<float>::code, &value, BlaeckWire<float>::size))
+    _setSignalUpdated(signalIndex);
 }
 
 void BlaeckTCP::update(int signalIndex, double value)
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-#ifdef __AVR__
-    // On AVR, double is same as float
-    if (Signals[signalIndex].DataType == Blaeck_float)
-    {
-      *((float *)Signals[signalIndex].Address) = (float)value;
-      Signals[signalIndex].Updated = true;
-    }
-#else
-    if (Signals[signalIndex].DataType == Blaeck_double)
-    {
-      *((double *)Signals[signalIndex].Address) = value;
-      Signals[signalIndex].Updated = true;
-    }
-#endif
-  }
+  if (_storeSignalValue(signalIndex, BlaeckWire<double>::code, &value, BlaeckWire<double>::size))
+    _setSignalUpdated(signalIndex);
 }
 
 void BlaeckTCP::update(String signalName, bool value)
@@ -2113,415 +4564,800 @@ void BlaeckTCP::write(int signalIndex, unsigned short value)
 {
   this->write(signalIndex, value, 1);
 }
-void BlaeckTCP::write(int signalIndex, int value)
+void BlaeckTCP::write(int signalIndex, int value)
+{
+  this->write(signalIndex, value, 1);
+}
+void BlaeckTCP::write(int signalIndex, unsigned int value)
+{
+  this->write(signalIndex, value, 1);
+}
+void BlaeckTCP::write(int signalIndex, long value)
+{
+  this->write(signalIndex, value, 1);
+}
+void BlaeckTCP::write(int signalIndex, unsigned long value)
+{
+  this->write(signalIndex, value, 1);
+}
+void BlaeckTCP::write(int signalIndex, float value)
+{
+  this->write(signalIndex, value, 1);
+}
+void BlaeckTCP::write(int signalIndex, double value)
+{
+  this->write(signalIndex, value, 1);
+}
+
+void BlaeckTCP::write(int signalIndex, bool value, unsigned long messageID)
+{
+  this->write(signalIndex, value, messageID, getTimeStamp());
+}
+
+void BlaeckTCP::write(int signalIndex, byte value, unsigned long messageID)
+{
+  this->write(signalIndex, value, messageID, getTimeStamp());
+}
+
+void BlaeckTCP::write(int signalIndex, short value, unsigned long messageID)
+{
+  this->write(signalIndex, value, messageID, getTimeStamp());
+}
+
+void BlaeckTCP::write(int signalIndex, unsigned short value, unsigned long messageID)
+{
+  this->write(signalIndex, value, messageID, getTimeStamp());
+}
+
+void BlaeckTCP::write(int signalIndex, int value, unsigned long messageID)
+{
+  this->write(signalIndex, value, messageID, getTimeStamp());
+}
+
+void BlaeckTCP::write(int signalIndex, unsigned int value, unsigned long messageID)
+{
+  this->write(signalIndex, value, messageID, getTimeStamp());
+}
+
+void BlaeckTCP::write(int signalIndex, long value, unsigned long messageID)
+{
+  this->write(signalIndex, value, messageID, getTimeStamp());
+}
+
+void BlaeckTCP::write(int signalIndex, unsigned long value, unsigned long messageID)
+{
+  this->write(signalIndex, value, messageID, getTimeStamp());
+}
+
+void BlaeckTCP::write(int signalIndex, float value, unsigned long messageID)
+{
+  this->write(signalIndex, value, messageID, getTimeStamp());
+}
+
+void BlaeckTCP::write(int signalIndex, double value, unsigned long messageID)
+{
+  this->write(signalIndex, value, messageID, getTimeStamp());
+}
+
+void BlaeckTCP::write(int signalIndex, bool value, unsigned long messageID, unsigned long long timestamp)
+{
+  if (_storeSignalValue(signalIndex, BlaeckWire<bool>::code, &value, BlaeckWire<bool>::size))
+    _writeSignal(signalIndex, messageID, timestamp);
+}
+
+void BlaeckTCP::write(int signalIndex, byte value, unsigned long messageID, unsigned long long timestamp)
+{
+  if (_storeSignalValue(signalIndex, BlaeckWire<byte>::code, &value, BlaeckWire<byte>::size))
+    _writeSignal(signalIndex, messageID, timestamp);
+}
+
+void BlaeckTCP::write(int signalIndex, short value, unsigned long messageID, unsigned long long timestamp)
+{
+  if (_storeSignalValue(signalIndex, BlaeckWire<short>::code, &value, BlaeckWire<short>::size))
+    _writeSignal(signalIndex, messageID, timestamp);
+}
+
+void BlaeckTCP::write(int signalIndex, unsigned short value, unsigned long messageID, unsigned long long timestamp)
+{
+  if (_storeSignalValue(signalIndex, BlaeckWire<unsigned short>::code, &value, BlaeckWire<unsigned short>::size))
+    _writeSignal(signalIndex, messageID, timestamp);
+}
+
+void BlaeckTCP::write(int signalIndex, int value, unsigned long messageID, unsigned long long timestamp)
+{
+  if (_storeSignalValue(signalIndex, BlaeckWire<int>::code, &value, BlaeckWire<int>::size))
+    _writeSignal(signalIndex, messageID, timestamp);
+}
+
+void BlaeckTCP::write(int signalIndex, unsigned int value, unsigned long messageID, unsigned long long timestamp)
+{
+  if (_storeSignalValue(signalIndex, BlaeckWire<unsigned int>::code, &value, BlaeckWire<unsigned int>::size))
+    _writeSignal(signalIndex, messageID, timestamp);
+}
+
+void BlaeckTCP::write(int signalIndex, long value, unsigned long messageID, unsigned long long timestamp)
+{
+  if (_storeSignalValue(signalIndex, BlaeckWire<long>::code, &value, BlaeckWire<long>::size))
+    _writeSignal(signalIndex, messageID, timestamp);
+}
+
+void BlaeckTCP::write(int signalIndex, unsigned long value, unsigned long messageID, unsigned long long timestamp)
+{
+  if (_storeSignalValue(signalIndex, BlaeckWire<unsigned long>::code, &value, BlaeckWire<unsigned long>::size))
+    _writeSignal(signalIndex, messageID, timestamp);
+}
+
+void BlaeckTCP::write(int signalIndex, float value, unsigned long messageID, unsigned long long timestamp)
+{
+  if (_storeSignalValue(signalIndex, BlaeckWire<float>::code, &value, BlaeckWire<float>::size))
+    _writeSignal(signalIndex, messageID, timestamp);
+}
+
+void BlaeckTCP::write(int signalIndex, double value, unsigned long messageID, unsigned long long timestamp)
+{
+  if (_storeSignalValue(signalIndex, BlaeckWire<double>::code, &value, BlaeckWire<double>::size))
+    _writeSignal(signalIndex, messageID, timestamp);
+}
+
+// --- String signal (char*) overloads ---
+void BlaeckTCP::write(String signalName, char *value)
+{
+  this->write(signalName, value, 1);
+}
+void BlaeckTCP::write(String signalName, char *value, unsigned long messageID)
+{
+  this->write(signalName, value, messageID, getTimeStamp());
+}
+void BlaeckTCP::write(String signalName, char *value, unsigned long messageID, unsigned long long timestamp)
+{
+  int index = findSignalIndex(signalName);
+  if (index >= 0)
+  {
+    this->write(index, value, messageID, timestamp);
+  }
+}
+
+void BlaeckTCP::write(int signalIndex, char *value)
 {
   this->write(signalIndex, value, 1);
 }
-void BlaeckTCP::write(int signalIndex, unsigned int value)
+void BlaeckTCP::write(int signalIndex, char *value, unsigned long messageID)
 {
-  this->write(signalIndex, value, 1);
+  this->write(signalIndex, value, messageID, getTimeStamp());
 }
-void BlaeckTCP::write(int signalIndex, long value)
+void BlaeckTCP::write(int signalIndex, char *value, unsigned long messageID, unsigned long long timestamp)
 {
-  this->write(signalIndex, value, 1);
+  if (signalIndex >= 0 && signalIndex < _signalIndex)
+  {
+    if (_signalType[signalIndex] == Blaeck_string)
+    {
+      // String values live in a user-owned buffer; repoint Address like addSignal(char*).
+      _signalAddress[signalIndex] = value;
+      _writeSignal(signalIndex, messageID, timestamp);
+    }
+  }
 }
-void BlaeckTCP::write(int signalIndex, unsigned long value)
+
+bool BlaeckTCP::_storeSignalValue(int signalIndex, byte type, const void *value, size_t size)
 {
-  this->write(signalIndex, value, 1);
+  // One body for every update()/write() overload: the type code and the size
+  // are compile-time constants of the overload, BlaeckWire<T>::code and
+  // ::size. The wire size, not sizeof(T): int and long share a type code, and
+  // a long must not overrun an int signal where long is 8 bytes.
+  if (signalIndex < 0 || signalIndex >= _signalIndex || _signalType[signalIndex] != type)
+    return false;
+  memcpy(_signalAddress[signalIndex], value, size);
+  return true;
 }
-void BlaeckTCP::write(int signalIndex, float value)
+
+void BlaeckTCP::_writeSignal(int signalIndex, unsigned long messageID, unsigned long long timestamp)
 {
-  this->write(signalIndex, value, 1);
+  if (signalIndex < 0 || signalIndex >= _signalIndex)
+    return;
+  if (_batchActive)
+  {
+    _signalBatched[signalIndex >> 3] |= (byte)(1 << (signalIndex & 7));
+    return;
+  }
+  this->_writeDataToClients(messageID, signalIndex, signalIndex, false, timestamp, false);
+  _sendRestartFlag = false;
 }
-void BlaeckTCP::write(int signalIndex, double value)
+
+int BlaeckTCP::findSignalIndex(String signalName)
 {
-  this->write(signalIndex, value, 1);
+  for (int i = 0; i < _signalIndex; i++)
+  {
+    if (_signalNameEquals(i, signalName.c_str()))
+    {
+      return i;
+    }
+  }
+  return -1; // Not found
 }
 
-void BlaeckTCP::write(int signalIndex, bool value, unsigned long messageID)
+void BlaeckTCP::writeAllData()
 {
-  this->write(signalIndex, value, messageID, getTimeStamp());
+  this->writeAllData(1);
 }
 
-void BlaeckTCP::write(int signalIndex, byte value, unsigned long messageID)
+void BlaeckTCP::writeAllData(unsigned long msg_id)
 {
-  this->write(signalIndex, value, messageID, getTimeStamp());
+  this->writeAllData(msg_id, getTimeStamp());
 }
 
-void BlaeckTCP::write(int signalIndex, short value, unsigned long messageID)
+void BlaeckTCP::writeAllData(unsigned long msg_id, unsigned long long timestamp)
 {
-  this->write(signalIndex, value, messageID, getTimeStamp());
+  bool dataSent = this->_writeDataToClients(msg_id, 0, _signalIndex - 1, false, timestamp);
+  if (dataSent)
+    _sendRestartFlag = false;
 }
 
-void BlaeckTCP::write(int signalIndex, unsigned short value, unsigned long messageID)
+void BlaeckTCP::writeUpdatedData()
 {
-  this->write(signalIndex, value, messageID, getTimeStamp());
+  this->writeUpdatedData(1);
 }
 
-void BlaeckTCP::write(int signalIndex, int value, unsigned long messageID)
+void BlaeckTCP::writeUpdatedData(unsigned long msg_id)
 {
-  this->write(signalIndex, value, messageID, getTimeStamp());
+  this->writeUpdatedData(msg_id, getTimeStamp());
 }
 
-void BlaeckTCP::write(int signalIndex, unsigned int value, unsigned long messageID)
+void BlaeckTCP::writeUpdatedData(unsigned long messageID, unsigned long long timestamp)
 {
-  this->write(signalIndex, value, messageID, getTimeStamp());
+  bool dataSent = this->_writeDataToClients(messageID, 0, _signalIndex - 1, true, timestamp);
+  if (dataSent)
+  {
+    _sendRestartFlag = false;
+    clearAllUpdateFlags();
+  }
 }
 
-void BlaeckTCP::write(int signalIndex, long value, unsigned long messageID)
+void BlaeckTCP::beginBatch()
 {
-  this->write(signalIndex, value, messageID, getTimeStamp());
+  if (_signalBatched == nullptr)
+    return;
+  memset(_signalBatched, 0, (_signalIndex + 7) / 8);
+  _batchActive = true;
 }
 
-void BlaeckTCP::write(int signalIndex, unsigned long value, unsigned long messageID)
+void BlaeckTCP::commitBatch()
 {
-  this->write(signalIndex, value, messageID, getTimeStamp());
+  this->commitBatch(1);
 }
 
-void BlaeckTCP::write(int signalIndex, float value, unsigned long messageID)
+void BlaeckTCP::commitBatch(unsigned long messageID)
 {
-  this->write(signalIndex, value, messageID, getTimeStamp());
+  this->commitBatch(messageID, getTimeStamp());
 }
 
-void BlaeckTCP::write(int signalIndex, double value, unsigned long messageID)
+void BlaeckTCP::commitBatch(unsigned long messageID, unsigned long long timestamp)
 {
-  this->write(signalIndex, value, messageID, getTimeStamp());
+  if (!_batchActive)
+    return;
+  _batchActive = false;
+
+  // The "only updated" frame, fed with the batch bits instead of the update
+  // flags: one frame, the written values as stored (no snapshot), like write().
+  byte *updated = _signalUpdated;
+  _signalUpdated = _signalBatched;
+  bool dataSent = this->_writeDataToClients(messageID, 0, _signalIndex - 1, true, timestamp, false);
+  _signalUpdated = updated;
+  if (dataSent)
+    _sendRestartFlag = false;
 }
 
-void BlaeckTCP::write(int signalIndex, bool value, unsigned long messageID, unsigned long long timestamp)
+void BlaeckTCP::abortBatch()
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-    if (Signals[signalIndex].DataType == Blaeck_bool)
-    {
-      *((bool *)Signals[signalIndex].Address) = value;
+  _batchActive = false;
+}
 
-      for (byte client = 0; client < _maxClients; client++)
-        if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
-        {
-          this->writeData(messageID, client, signalIndex, signalIndex, false, timestamp);
-        }
-      _sendRestartFlag = false;
-    }
-  }
+bool BlaeckTCP::beginHistory(size_t bytes)
+{
+  _historyFrames = 0;
+  _replayClient = 0xFF;
+  _history.lost = 0;
+  return _history.ring.begin(bytes);
 }
 
-void BlaeckTCP::write(int signalIndex, byte value, unsigned long messageID, unsigned long long timestamp)
+void BlaeckTCP::endHistory()
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-    if (Signals[signalIndex].DataType == Blaeck_byte)
-    {
-      *((byte *)Signals[signalIndex].Address) = value;
+  _history.ring.end();
+  _historyFrames = 0;
+  _replayClient = 0xFF;
+}
 
-      for (byte client = 0; client < _maxClients; client++)
-        if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
-        {
-          this->writeData(messageID, client, signalIndex, signalIndex, false, timestamp);
-        }
-      _sendRestartFlag = false;
-    }
-  }
+void BlaeckTCP::HistoryRing::begin(unsigned long long timestamp)
+{
+  // Header placeholder: length(2) patched on commit, then the timestamp.
+  byte header[HISTORY_HEADER_SIZE] = {0, 0};
+  for (byte k = 0; k < 8; k++)
+    header[2 + k] = (byte)(timestamp >> (8 * k));
+  ring.stageBegin();
+  ring.stage(header, sizeof(header));
+  frameLen = 0;
 }
 
-void BlaeckTCP::write(int signalIndex, short value, unsigned long messageID, unsigned long long timestamp)
+bool BlaeckTCP::HistoryRing::commit()
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
+  if (frameLen == 0)
+    return false;
+  // A record which can never fit must not make every later one flush the ring.
+  size_t recordLen = frameLen + HISTORY_HEADER_SIZE;
+  if (recordLen > reserve && recordLen < ring.capacity())
+    reserve = recordLen;
+  byte lenBytes[2] = {(byte)(frameLen & 0xFF), (byte)((frameLen >> 8) & 0xFF)};
+  ring.stagePatch(0, lenBytes, 2);
+  if (frameLen > 0xFFFF || !ring.stageCommit())
   {
-    if (Signals[signalIndex].DataType == Blaeck_short)
-    {
-      *((short *)Signals[signalIndex].Address) = value;
-
-      for (byte client = 0; client < _maxClients; client++)
-        if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
-        {
-          this->writeData(messageID, client, signalIndex, signalIndex, false, timestamp);
-        }
-      _sendRestartFlag = false;
-    }
+    lost++;
+    return false;
   }
+  return true;
 }
 
-void BlaeckTCP::write(int signalIndex, unsigned short value, unsigned long messageID, unsigned long long timestamp)
+void BlaeckTCP::_dropOldestHistoryFrame()
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
+  byte lenBytes[2];
+  _history.ring.peek(lenBytes, 2);
+  size_t recordLen = HISTORY_HEADER_SIZE + (lenBytes[0] | (lenBytes[1] << 8));
+  _history.ring.consume(recordLen);
+  _historyFrames--;
+  if (_replayClient != 0xFF)
   {
-    if (Signals[signalIndex].DataType == Blaeck_ushort)
-    {
-      *((unsigned short *)Signals[signalIndex].Address) = value;
-
-      for (byte client = 0; client < _maxClients; client++)
-        if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
-        {
-          this->writeData(messageID, client, signalIndex, signalIndex, false, timestamp);
-        }
-      _sendRestartFlag = false;
-    }
+    // A frame not replayed yet is simply gone.
+    _replayOffset = (_replayOffset > recordLen) ? _replayOffset - recordLen : 0;
+    _replayEnd = (_replayEnd > recordLen) ? _replayEnd - recordLen : 0;
   }
 }
 
-void BlaeckTCP::write(int signalIndex, int value, unsigned long messageID, unsigned long long timestamp)
+void BlaeckTCP::_replayHistory(unsigned long long since)
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-#ifdef __AVR__
-    // On AVR, int stays as Blaeck_int (2 bytes)
-    if (Signals[signalIndex].DataType == Blaeck_int)
-    {
-      *((int *)Signals[signalIndex].Address) = value;
-
-      for (byte client = 0; client < _maxClients; client++)
-        if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
-        {
-          this->writeData(messageID, client, signalIndex, signalIndex, false, timestamp);
-        }
-      _sendRestartFlag = false;
-    }
-#else
-    // On 32-bit platforms, int is mapped to Blaeck_long (4 bytes)
-    if (Signals[signalIndex].DataType == Blaeck_long)
-    {
-      *((int *)Signals[signalIndex].Address) = value;
+  if (!_history.ring.isAllocated() || _commandingClientNo >= _maxClients)
+    return;
 
-      for (byte client = 0; client < _maxClients; client++)
-        if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
-        {
-          this->writeData(messageID, client, signalIndex, signalIndex, false, timestamp);
-        }
-      _sendRestartFlag = false;
-    }
-#endif
-  }
+  // Frames recorded from now on reach the client live.
+  _replayClient = _commandingClientNo;
+  _replaySince = since;
+  _replayOffset = 0;
+  _replayEnd = _history.ring.available();
 }
 
-void BlaeckTCP::write(int signalIndex, unsigned int value, unsigned long messageID, unsigned long long timestamp)
+void BlaeckTCP::_continueReplay()
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
+  if (_replayClient == 0xFF)
+    return;
+  if (!_history.ring.isAllocated() || !_clientConnected(_replayClient))
   {
-#ifdef __AVR__
-    // On AVR, int stays as Blaeck_int (2 bytes)
-    if (Signals[signalIndex].DataType == Blaeck_uint)
-    {
-      *((unsigned int *)Signals[signalIndex].Address) = value;
+    _replayClient = 0xFF;
+    return;
+  }
 
-      for (byte client = 0; client < _maxClients; client++)
-        if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
-        {
-          this->writeData(messageID, client, signalIndex, signalIndex, false, timestamp);
-        }
-      _sendRestartFlag = false;
-    }
-#else
-    // On 32-bit platforms, int is mapped to Blaeck_long (4 bytes)
-    if (Signals[signalIndex].DataType == Blaeck_ulong)
+  size_t replayed = 0;
+  while (_replayOffset < _replayEnd && replayed < BLAECK_HISTORY_REPLAY_BYTES)
+  {
+    byte header[HISTORY_HEADER_SIZE];
+    _history.ring.peek(header, HISTORY_HEADER_SIZE, _replayOffset);
+    size_t len = header[0] | (header[1] << 8);
+    unsigned long long timestamp = 0;
+    for (int k = 7; k >= 0; k--)
+      timestamp = (timestamp << 8) | header[2 + k];
+
+    if (_replaySince == 0 || timestamp > _replaySince)
     {
-      *((unsigned int *)Signals[signalIndex].Address) = value;
-
-      for (byte client = 0; client < _maxClients; client++)
-        if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
-        {
-          this->writeData(messageID, client, signalIndex, signalIndex, false, timestamp);
-        }
-      _sendRestartFlag = false;
-    }
+#if BLAECK_NETWORK_TASK
+      // Wait for the task to drain the queue rather than overrun it; a frame
+      // the queue can never hold is skipped.
+      if (_netTask != nullptr && len + 6 <= _netTx.ring.capacity() && _netTx.ring.availableForWrite() < len + 6)
+        break;
+#endif
+#if BLAECK_ASYNC_TCP
+      if (len <= BLAECK_ASYNC_TCP_TX_SIZE && (size_t)Clients[_replayClient].connection.availableForWrite() < len)
+        break;
 #endif
+      // The record may wrap around the end of the ring: copy it span by span.
+      size_t offset = _replayOffset + HISTORY_HEADER_SIZE;
+      Print &out = _frameBegin(_replayClient);
+      size_t sent = 0;
+      while (sent < len)
+      {
+        const uint8_t *span;
+        size_t n = _history.ring.readable(&span, offset + sent);
+        if (n == 0)
+          break;
+        if (n > len - sent)
+          n = len - sent;
+        out.write(span, n);
+        sent += n;
+      }
+      _frameEnd(_replayClient);
+      replayed += len;
+    }
+    _replayOffset += HISTORY_HEADER_SIZE + len;
   }
+
+  if (_replayOffset >= _replayEnd)
+    _replayClient = 0xFF;
 }
 
-void BlaeckTCP::write(int signalIndex, long value, unsigned long messageID, unsigned long long timestamp)
+#if defined(ESP32) || defined(ESP8266)
+bool BlaeckFSStore::append(const uint8_t *data, size_t len)
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-    if (Signals[signalIndex].DataType == Blaeck_long)
-    {
-      *((long *)Signals[signalIndex].Address) = value;
+  File file = _fs.open(_path, "a");
+  if (!file)
+    return false;
+  size_t written = file.write(data, len);
+  file.close();
+  return written == len;
+}
 
-      for (byte client = 0; client < _maxClients; client++)
-        if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
-        {
-          this->writeData(messageID, client, signalIndex, signalIndex, false, timestamp);
-        }
-      _sendRestartFlag = false;
-    }
-  }
+size_t BlaeckFSStore::read(uint32_t offset, uint8_t *data, size_t len)
+{
+  File file = _fs.open(_path, "r");
+  if (!file)
+    return 0;
+  size_t n = file.seek(offset) ? file.read(data, len) : 0;
+  file.close();
+  return n;
 }
 
-void BlaeckTCP::write(int signalIndex, unsigned long value, unsigned long messageID, unsigned long long timestamp)
+uint32_t BlaeckFSStore::size()
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-    if (Signals[signalIndex].DataType == Blaeck_ulong)
-    {
-      *((unsigned long *)Signals[signalIndex].Address) = value;
+  File file = _fs.open(_path, "r");
+  if (!file)
+    return 0;
+  uint32_t n = file.size();
+  file.close();
+  return n;
+}
 
-      for (byte client = 0; client < _maxClients; client++)
-        if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
-        {
-          this->writeData(messageID, client, signalIndex, signalIndex, false, timestamp);
-        }
-      _sendRestartFlag = false;
-    }
-  }
+void BlaeckFSStore::clear()
+{
+  _fs.remove(_path);
 }
+#endif
 
-void BlaeckTCP::write(int signalIndex, float value, unsigned long messageID, unsigned long long timestamp)
+bool BlaeckTCP::setFrameStore(BlaeckFrameStore *store)
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
+  if (_frameStore != nullptr)
+    flushFrameStore();
+  _frameStore = nullptr;
+  _storeSize = 0;
+  _storeCursor = 0;
+  _storeClient = 0xFF;
+  if (store == nullptr)
   {
-    if (Signals[signalIndex].DataType == Blaeck_float)
-    {
-      *((float *)Signals[signalIndex].Address) = value;
+    _storePage.release();
+    return true;
+  }
 
-      for (byte client = 0; client < _maxClients; client++)
-        if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
-        {
-          this->writeData(messageID, client, signalIndex, signalIndex, false, timestamp);
-        }
-      _sendRestartFlag = false;
-    }
+  if (_storePage.buf == nullptr && !_storePage.allocate(BLAECK_STORE_PAGE_SIZE))
+  {
+    if (StreamRef != nullptr)
+      StreamRef->println("Not enough memory for the frame store page");
+    return false;
   }
+  _storePage.len = 0;
+  _storePage.frames = 0;
+  _frameStore = store;
+  _storeSize = store->size();
+  return true;
 }
 
-void BlaeckTCP::write(int signalIndex, double value, unsigned long messageID, unsigned long long timestamp)
+void BlaeckTCP::flushFrameStore()
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
-  {
-#ifdef __AVR__
-    // On AVR, double is same as float
-    if (Signals[signalIndex].DataType == Blaeck_float)
-    {
-      *((float *)Signals[signalIndex].Address) = (float)value;
-
-      for (byte client = 0; client < _maxClients; client++)
-        if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
-        {
-          this->writeData(messageID, client, signalIndex, signalIndex, false, timestamp);
-        }
-      _sendRestartFlag = false;
-    }
-#else
-    if (Signals[signalIndex].DataType == Blaeck_double)
-    {
-      *((double *)Signals[signalIndex].Address) = value;
+  if (_frameStore == nullptr || _storePage.len == 0)
+    return;
+  if (_frameStore->append(_storePage.buf, _storePage.len))
+    _storeSize += _storePage.len;
+  else
+    _storeLostCount += _storePage.frames;
+  _storePage.len = 0;
+  _storePage.frames = 0;
+}
 
-      for (byte client = 0; client < _maxClients; client++)
-        if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
-        {
-          this->writeData(messageID, client, signalIndex, signalIndex, false, timestamp);
-        }
-      _sendRestartFlag = false;
-    }
-#endif
-  }
+uint32_t BlaeckTCP::getFrameStorePending() const
+{
+  if (_frameStore == nullptr)
+    return 0;
+  return _storeSize - _storeCursor + _storePage.len;
 }
 
-// --- String signal (char*) overloads ---
-void BlaeckTCP::write(String signalName, char *value)
+bool BlaeckTCP::StorePage::allocate(size_t size)
 {
-  this->write(signalName, value, 1);
+  // Keeps what the page holds; the old buffer goes once the copy is made.
+  uint8_t *bigger = new (std::nothrow) uint8_t[size];
+  if (bigger == nullptr)
+    return false;
+  if (len > 0)
+    memcpy(bigger, buf, len);
+  delete[] buf;
+  buf = bigger;
+  capacity = size;
+  return true;
 }
-void BlaeckTCP::write(String signalName, char *value, unsigned long messageID)
+
+void BlaeckTCP::StorePage::release()
 {
-  this->write(signalName, value, messageID, getTimeStamp());
+  delete[] buf;
+  buf = nullptr;
+  capacity = 0;
+  len = 0;
+  frames = 0;
 }
-void BlaeckTCP::write(String signalName, char *value, unsigned long messageID, unsigned long long timestamp)
+
+void BlaeckTCP::StorePage::begin()
 {
-  int index = findSignalIndex(signalName);
-  if (index >= 0)
-  {
-    this->write(index, value, messageID, timestamp);
-  }
+  // Length placeholder, patched on commit.
+  frameStart = len;
+  frameLen = 0;
+  overflow = (len + 2 > capacity && !allocate(len + 2));
+  if (!overflow)
+    len += 2;
 }
 
-void BlaeckTCP::write(int signalIndex, char *value)
+size_t BlaeckTCP::StorePage::write(const uint8_t *buffer, size_t size)
 {
-  this->write(signalIndex, value, 1);
+  frameLen += size;
+  if (!overflow && len + size > capacity)
+  {
+    // A frame larger than the page: grow it rather than lose the frame.
+    size_t grown = capacity * 2;
+    if (grown < len + size)
+      grown = len + size;
+    overflow = !allocate(grown);
+  }
+  if (overflow)
+    return 0;
+  memcpy(buf + len, buffer, size);
+  len += size;
+  return size;
 }
-void BlaeckTCP::write(int signalIndex, char *value, unsigned long messageID)
+
+bool BlaeckTCP::StorePage::commit()
 {
-  this->write(signalIndex, value, messageID, getTimeStamp());
+  size_t recordLen = frameLen + 2;
+  if (recordLen > reserve)
+    reserve = recordLen;
+  if (overflow || frameLen == 0 || frameLen > 0xFFFF)
+  {
+    len = frameStart;
+    return false;
+  }
+  buf[frameStart] = (uint8_t)(frameLen & 0xFF);
+  buf[frameStart + 1] = (uint8_t)((frameLen >> 8) & 0xFF);
+  frames++;
+  return true;
 }
-void BlaeckTCP::write(int signalIndex, char *value, unsigned long messageID, unsigned long long timestamp)
+
+void BlaeckTCP::_forwardStoredFrames()
 {
-  if (signalIndex >= 0 && signalIndex < _signalIndex)
+  if (_frameStore == nullptr || (_storeCursor >= _storeSize && _storePage.len == 0))
+    return;
+
+  // Stick to one client until the log is through.
+  if (_storeClient >= _maxClients || !_clientConnected(_storeClient) ||
+      bitRead(_blaeckWriteDataClientMask, _storeClient) == 0)
   {
-    if (Signals[signalIndex].DataType == Blaeck_string)
+    _storeClient = 0xFF;
+    for (byte client = 0; client < _maxClients; client++)
     {
-      // String values live in a user-owned buffer; repoint Address like addSignal(char*).
-      Signals[signalIndex].Address = value;
-
-      for (byte client = 0; client < _maxClients; client++)
-        if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
-        {
-          this->writeData(messageID, client, signalIndex, signalIndex, false, timestamp);
-        }
-      _sendRestartFlag = false;
+      if (_clientConnected(client) && bitRead(_blaeckWriteDataClientMask, client) == 1)
+      {
+        _storeClient = client;
+        break;
+      }
     }
+    if (_storeClient == 0xFF)
+      return;
   }
-}
 
-int BlaeckTCP::findSignalIndex(String signalName)
-{
-  for (int i = 0; i < _signalIndex; i++)
+  // Nothing is recorded while a client is connected, so once flushed the
+  // page doubles as the read buffer.
+  flushFrameStore();
+  uint32_t forwarded = 0;
+  bool full = false;
+  while (!full && forwarded < BLAECK_STORE_FORWARD_BYTES && _storeCursor < _storeSize)
   {
-    if (Signals[i].SignalName == signalName)
+    uint32_t want = _storeSize - _storeCursor;
+    if (want > _storePage.capacity)
+      want = _storePage.capacity;
+    uint8_t *buf = _storePage.buf;
+    size_t n = _frameStore->read(_storeCursor, buf, want);
+
+    size_t pos = 0;
+    while (pos + 2 <= n)
     {
-      return i;
+      size_t len = buf[pos] | (buf[pos + 1] << 8);
+      if (pos + 2 + len > n)
+        break;
+      // A record the client's queue can never hold is lost; one it has no
+      // room for yet waits for the next tick, as in _continueReplay()
+      size_t limit = (size_t)-1;
+      size_t room = (size_t)-1;
+#if BLAECK_NETWORK_TASK
+      if (_netTask != nullptr)
+      {
+        limit = _netTx.ring.capacity() - 6;
+        room = _netTx.ring.availableForWrite();
+        room = (room > 6) ? room - 6 : 0;
+      }
+#endif
+#if BLAECK_ASYNC_TCP
+      limit = BLAECK_ASYNC_TCP_TX_SIZE;
+      room = Clients[_storeClient].connection.availableForWrite();
+#endif
+      if (len > limit)
+      {
+        _storeLostCount++;
+        pos += 2 + len;
+        continue;
+      }
+      if (room < len)
+      {
+        full = true;
+        break;
+      }
+      Print &out = _frameBegin(_storeClient);
+      size_t written = out.write(buf + pos + 2, len);
+      _frameEnd(_storeClient);
+      if (written < len)
+      {
+        // Sent again whole next time; the host drops the torn copy by its CRC
+        full = true;
+        break;
+      }
+      pos += 2 + len;
+    }
+    if (pos == 0 && !full)
+    {
+      // A record larger than the page (stored before a reboot, say): read it
+      // whole next time. Otherwise the log is unreadable or damaged; give up
+      // on it instead of retrying forever.
+      size_t len = (n >= 2) ? (buf[0] | (buf[1] << 8)) : 0;
+      if (n == want && len + 2 > _storePage.capacity && _storeCursor + 2 + len <= _storeSize &&
+          _storePage.allocate(len + 2))
+        continue;
+      _storeCursor = _storeSize;
+      break;
     }
+    _storeCursor += pos;
+    forwarded += pos;
   }
-  return -1; // Not found
-}
 
-void BlaeckTCP::writeAllData()
-{
-  this->writeAllData(1);
+  if (_storeCursor >= _storeSize)
+  {
+    _frameStore->clear();
+    _storeSize = 0;
+    _storeCursor = 0;
+  }
 }
 
-void BlaeckTCP::writeAllData(unsigned long msg_id)
+void BlaeckTCP::beginDataUdp(UDP *udp, IPAddress ip, uint16_t port)
 {
-  this->writeAllData(msg_id, getTimeStamp());
+  _dataUdp = udp;
+  _dataUdpIp = ip;
+  _dataUdpPort = port;
+  _dataUdpSeq = 0;
+  _dataUdpErrorCount = 0;
 }
 
-void BlaeckTCP::writeAllData(unsigned long msg_id, unsigned long long timestamp)
+bool BlaeckTCP::_writeDataToClients(unsigned long msg_id, int signalIndex_start, int signalIndex_end, bool onlyUpdated, unsigned long long timestamp, bool useSnapshot)
 {
-  bool dataSent = false;
+  uint32_t clientMask = 0;
   for (byte client = 0; client < _maxClients; client++)
-    if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
+    if (_clientConnected(client) && bitRead(_blaeckWriteDataClientMask, client) == 1)
+      clientMask |= (1UL << client);
+  if (clientMask == 0 && _dataUdp == nullptr && !_history.ring.isAllocated() && _frameStore == nullptr)
+    return false;
+
+  if (useSnapshot && _snapshotMode != BLAECK_SNAPSHOT_OFF)
+  {
+    if (_snapshotMode == BLAECK_SNAPSHOT_AUTO && !(onlyUpdated && !hasUpdatedSignals()))
     {
-      this->writeData(msg_id, client, 0, _signalIndex - 1, false, timestamp);
-      dataSent = true;
+      // The callback may refresh the values, so it runs once, before the copy.
+      if (_beforeWriteCallback != NULL)
+      {
+        BLAECK_TRACE_SCOPE(BLAECK_TRACE_BEFORE_WRITE);
+        _beforeWriteCallback();
+      }
+      snapshot();
     }
-  if (dataSent)
-    _sendRestartFlag = false;
-}
+    // Pinned for the whole fan-out, so all clients get the same instant.
+    _snapshotRead = _pinSnapshot();
+  }
 
-void BlaeckTCP::writeUpdatedData()
-{
-  this->writeUpdatedData(1);
-}
+  // The history records the frame as it is encoded for the first receiver
+  // (see HistoryTee), so the frame is still encoded once per receiver only.
+  bool record = _history.ring.isAllocated() && !_historyStaging && _signalIndex > 0 &&
+                !(onlyUpdated && !hasUpdatedSignals());
+  if (record)
+  {
+    while (_history.ring.availableForWrite() < _history.reserve && _historyFrames > 0)
+      _dropOldestHistoryFrame();
+    _history.begin(timestamp);
+    _historyStaging = true;
+  }
+  HistoryTee tee(record ? &_history : nullptr);
 
-void BlaeckTCP::writeUpdatedData(unsigned long msg_id)
-{
-  this->writeUpdatedData(msg_id, getTimeStamp());
-}
+  bool stored = false;
+  if (clientMask == 0 && _dataUdp == nullptr && _frameStore != nullptr &&
+      _signalIndex > 0 && !(onlyUpdated && !hasUpdatedSignals()))
+  {
+    if (_storePage.capacity - _storePage.len < _storePage.reserve)
+      flushFrameStore();
+    _storePage.begin();
+    this->writeData(msg_id, tee.to(_storePage), signalIndex_start, signalIndex_end, onlyUpdated, timestamp);
+    stored = _storePage.commit();
+    if (!stored)
+      _storeLostCount++;
+  }
 
-void BlaeckTCP::writeUpdatedData(unsigned long messageID, unsigned long long timestamp)
-{
-  bool dataSent = false;
-  for (byte client = 0; client < _maxClients; client++)
-    if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
+  if (_dataUdp != nullptr)
+  {
+    // One datagram for all receivers; nothing goes to the TCP clients.
+    if (_signalIndex > 0 && !(onlyUpdated && !hasUpdatedSignals()))
     {
-      this->writeData(messageID, client, 0, _signalIndex - 1, true, timestamp);
-      dataSent = true;
+      ulngCvt.val = _dataUdpSeq++;
+      if (_dataUdp->beginPacket(_dataUdpIp, _dataUdpPort) == 1)
+      {
+        _dataUdp->write(ulngCvt.bval, 4);
+        this->writeData(msg_id, tee.to(*_dataUdp), signalIndex_start, signalIndex_end, onlyUpdated, timestamp);
+        if (_dataUdp->endPacket() != 1)
+          _dataUdpErrorCount++;
+      }
+      else
+      {
+        _dataUdpErrorCount++;
+      }
     }
-  if (dataSent)
+  }
+  else
+#if BLAECK_NETWORK_TASK
+  if (_netTask != nullptr)
   {
-    _sendRestartFlag = false;
-    clearAllUpdateFlags();
+    // Every client gets the same bytes: encode once, let the task fan out.
+    _netTx.begin(clientMask);
+    this->writeData(msg_id, tee.to(_netTx), signalIndex_start, signalIndex_end, onlyUpdated, timestamp);
+    if (!_netTx.commit())
+      _netTxDropCount++;
+  }
+  else
+#endif
+  {
+    for (byte client = 0; client < _maxClients; client++)
+    {
+      if (bitRead(clientMask, client) == 0)
+        continue;
+      _frameTimerStart(client);
+      this->writeData(msg_id, tee.to(_clientOut(client)), signalIndex_start, signalIndex_end, onlyUpdated, timestamp);
+      _frameTimerStop(client);
+    }
+#if BLAECK_ASYNC_TCP
+    _asyncFlush();
+#endif
+  }
+
+  if (record)
+  {
+    // Nobody else took the frame: encode it for the history alone.
+    if (!tee.used)
+      this->writeData(msg_id, _history, signalIndex_start, signalIndex_end, onlyUpdated, timestamp);
+    if (_history.commit())
+      _historyFrames++;
+    _historyStaging = false;
+  }
+
+  if (_snapshotRead != nullptr)
+  {
+    _snapshotRead = nullptr;
+    _unpinSnapshot();
   }
+  // A frame that only went into the history reached nobody: the restart flag
+  // and the update flags stay for the next one.
+  return clientMask != 0 || _dataUdp != nullptr || stored;
 }
 
-void BlaeckTCP::writeData(unsigned long msg_id, byte i, int signalIndex_start, int signalIndex_end, bool onlyUpdated, unsigned long long timestamp)
+void BlaeckTCP::writeData(unsigned long msg_id, Print &out, int signalIndex_start, int signalIndex_end, bool onlyUpdated, unsigned long long timestamp)
 {
   if (onlyUpdated && !hasUpdatedSignals())
     return; // No updated signals
@@ -2534,9 +5370,19 @@ void BlaeckTCP::writeData(unsigned long msg_id, byte i, int signalIndex_start, i
   if (signalIndex_start > signalIndex_end)
     return; // No valid range
 
-  if (_beforeWriteCallback != NULL)
+  BLAECK_STATS_TIME(writeData);
+  BLAECK_STATS_COUNT(dataFrames);
+
+  // In AUTO snapshot mode the callback already ran before the snapshot.
+  if (_beforeWriteCallback != NULL && !(_snapshotRead != nullptr && _snapshotMode == BLAECK_SNAPSHOT_AUTO))
+  {
+    BLAECK_TRACE_SCOPE(BLAECK_TRACE_BEFORE_WRITE);
     _beforeWriteCallback();
+  }
 
+  // The CRC runs along with the bytes, so SERIALIZE includes it; CRC is
+  // only the final step.
+  BLAECK_TRACE_BEGIN(BLAECK_TRACE_SERIALIZE);
   _crc.setPolynome(0x04C11DB7);
   _crc.setInitial(0xFFFFFFFF);
   _crc.setXorOut(0xFFFFFFFF);
@@ -2544,175 +5390,391 @@ void BlaeckTCP::writeData(unsigned long msg_id, byte i, int signalIndex_start, i
   _crc.setReverseOut(true);
   _crc.restart();
 
-  Clients[i].connection.write("<BLAECK:");
+  out.write("<BLAECK:");
 
   // Message Key
   byte msg_key = 0xD2;
-  Clients[i].connection.write(msg_key);
+  out.write(msg_key);
   _crc.add(msg_key);
 
-  Clients[i].connection.write(":");
+  out.write(":");
   _crc.add(':');
 
   // Message Id
   ulngCvt.val = msg_id;
-  Clients[i].connection.write(ulngCvt.bval, 4);
+  out.write(ulngCvt.bval, 4);
   _crc.add(ulngCvt.bval, 4);
 
-  Clients[i].connection.write(":");
+  out.write(":");
   _crc.add(':');
 
   // Restart flag
   byte restart_flag = _sendRestartFlag ? 1 : 0;
-  Clients[i].connection.write(restart_flag);
+  out.write(restart_flag);
   _crc.add(restart_flag);
 
-  Clients[i].connection.write(":");
+  out.write(":");
   _crc.add(':');
 
   // Schema hash (2 bytes, CRC16-CCITT, little-endian)
   byte hash_lo = (byte)(_schemaHash & 0xFF);
   byte hash_hi = (byte)((_schemaHash >> 8) & 0xFF);
-  Clients[i].connection.write(hash_lo);
-  Clients[i].connection.write(hash_hi);
+  out.write(hash_lo);
+  out.write(hash_hi);
   _crc.add(hash_lo);
   _crc.add(hash_hi);
 
-  Clients[i].connection.write(":");
+  out.write(":");
   _crc.add(':');
 
   // Timestamp mode
   byte timestamp_mode = (byte)_timestampMode;
-  Clients[i].connection.write(timestamp_mode);
+  out.write(timestamp_mode);
   _crc.add(timestamp_mode);
 
   // Add timestamp data if mode is not NO_TIMESTAMP
   if (_timestampMode != BLAECK_NO_TIMESTAMP && hasValidTimestampCallback())
   {
     ullCvt.val = timestamp;
-    Clients[i].connection.write(ullCvt.bval, 8);
+    out.write(ullCvt.bval, 8);
     _crc.add(ullCvt.bval, 8);
   }
 
-  Clients[i].connection.write(":");
+  out.write(":");
   _crc.add(':');
 
-  for (int j = signalIndex_start; j <= signalIndex_end; j++)
+  // A full frame of a compile-time schema needs no per-signal type switch
+  bool fullFrame = !onlyUpdated && signalIndex_start == 0 && signalIndex_end == _signalIndex - 1;
+  if (_staticSchema != nullptr && fullFrame && _snapshotRead == nullptr)
+    _staticSchema->writeValues(out, _crc, _signalAddress);
+  else
   {
-    // Skip if onlyUpdated is true and signal is not updated
-    if (onlyUpdated && !Signals[j].Updated)
-      continue;
-
-    intCvt.val = j;
-    Clients[i].connection.write(intCvt.bval, 2);
-    _crc.add(intCvt.bval, 2);
-
-    Signal signal = Signals[j];
-    switch (signal.DataType)
+    for (int j = signalIndex_start; j <= signalIndex_end; j++)
     {
-    case (Blaeck_bool):
-    {
-      boolCvt.val = *((bool *)signal.Address);
-      Clients[i].connection.write(boolCvt.bval, 1);
-      _crc.add(boolCvt.bval, 1);
-    }
-    break;
-    case (Blaeck_byte):
-    {
-      Clients[i].connection.write(*((byte *)signal.Address));
-      _crc.add(*((byte *)signal.Address));
-    }
-    break;
-    case (Blaeck_short):
-    {
-      shortCvt.val = *((short *)signal.Address);
-      Clients[i].connection.write(shortCvt.bval, 2);
-      _crc.add(shortCvt.bval, 2);
-    }
-    break;
-    case (Blaeck_ushort):
-    {
-      ushortCvt.val = *((unsigned short *)signal.Address);
-      Clients[i].connection.write(ushortCvt.bval, 2);
-      _crc.add(ushortCvt.bval, 2);
-    }
-    break;
-    case (Blaeck_int):
-    {
-      intCvt.val = *((int *)signal.Address);
-      Clients[i].connection.write(intCvt.bval, 2);
+      // Skip if onlyUpdated is true and signal is not updated
+      if (onlyUpdated && !_isSignalUpdated(j))
+        continue;
+
+      intCvt.val = j;
+      out.write(intCvt.bval, 2);
       _crc.add(intCvt.bval, 2);
-    }
-    break;
-    case (Blaeck_uint):
-    {
-      uintCvt.val = *((unsigned int *)signal.Address);
-      Clients[i].connection.write(uintCvt.bval, 2);
-      _crc.add(uintCvt.bval, 2);
-    }
-    break;
-    case (Blaeck_long):
-    {
-      lngCvt.val = *((long *)signal.Address);
-      Clients[i].connection.write(lngCvt.bval, 4);
-      _crc.add(lngCvt.bval, 4);
-    }
-    break;
-    case (Blaeck_ulong):
-    {
-      ulngCvt.val = *((unsigned long *)signal.Address);
-      Clients[i].connection.write(ulngCvt.bval, 4);
-      _crc.add(ulngCvt.bval, 4);
-    }
-    break;
-    case (Blaeck_float):
-    {
-      fltCvt.val = *((float *)signal.Address);
-      Clients[i].connection.write(fltCvt.bval, 4);
-      _crc.add(fltCvt.bval, 4);
-    }
-    break;
-    case (Blaeck_double):
-    {
-      dblCvt.val = *((double *)signal.Address);
-      Clients[i].connection.write(dblCvt.bval, 8);
-      _crc.add(dblCvt.bval, 8);
-    }
-    break;
-    case (Blaeck_string):
-    {
-      // Wire layout: 1-byte length (capped at 255) followed by that many
-      // characters. A null Address is treated as an empty string.
-      const char *str = (const char *)signal.Address;
-      size_t rawLen = (str != nullptr) ? strlen(str) : 0;
-      byte len = (rawLen > 255) ? 255 : (byte)rawLen;
-      Clients[i].connection.write(len);
-      _crc.add(len);
-      if (len > 0)
+
+      // Value source: the pinned snapshot, or the signal variable itself
+      const void *src = (_snapshotRead != nullptr) ? (const void *)(_snapshotRead + _snapshotOffsets[j]) : _signalAddress[j];
+      switch (_signalType[j])
+      {
+      case (Blaeck_bool):
       {
-        Clients[i].connection.write((const uint8_t *)str, len);
-        _crc.add((uint8_t *)str, len);
+        boolCvt.val = *((const bool *)src);
+        out.write(boolCvt.bval, 1);
+        _crc.add(boolCvt.bval, 1);
+      }
+      break;
+      case (Blaeck_byte):
+      {
+        out.write(*((const byte *)src));
+        _crc.add(*((const byte *)src));
+      }
+      break;
+      case (Blaeck_short):
+      {
+        shortCvt.val = *((const short *)src);
+        out.write(shortCvt.bval, 2);
+        _crc.add(shortCvt.bval, 2);
+      }
+      break;
+      case (Blaeck_ushort):
+      {
+        ushortCvt.val = *((const unsigned short *)src);
+        out.write(ushortCvt.bval, 2);
+        _crc.add(ushortCvt.bval, 2);
+      }
+      break;
+      case (Blaeck_int):
+      {
+        intCvt.val = *((const int *)src);
+        out.write(intCvt.bval, 2);
+        _crc.add(intCvt.bval, 2);
+      }
+      break;
+      case (Blaeck_uint):
+      {
+        uintCvt.val = *((const unsigned int *)src);
+        out.write(uintCvt.bval, 2);
+        _crc.add(uintCvt.bval, 2);
+      }
+      break;
+      case (Blaeck_long):
+      {
+        // 4 bytes, not sizeof(long): int signals have this type too, and on
+        // the host build a long is 8 bytes
+        memcpy(lngCvt.bval, src, 4);
+        out.write(lngCvt.bval, 4);
+        _crc.add(lngCvt.bval, 4);
+      }
+      break;
+      case (Blaeck_ulong):
+      {
+        memcpy(ulngCvt.bval, src, 4);
+        out.write(ulngCvt.bval, 4);
+        _crc.add(ulngCvt.bval, 4);
+      }
+      break;
+      case (Blaeck_float):
+      {
+        fltCvt.val = *((const float *)src);
+        out.write(fltCvt.bval, 4);
+        _crc.add(fltCvt.bval, 4);
+      }
+      break;
+      case (Blaeck_double):
+      {
+        dblCvt.val = *((const double *)src);
+        out.write(dblCvt.bval, 8);
+        _crc.add(dblCvt.bval, 8);
+      }
+      break;
+      case (Blaeck_string):
+      {
+        // Wire layout: 1-byte length (capped at 255) followed by that many
+        // characters. A null Address is treated as an empty string.
+        const char *str = (const char *)src;
+        byte len = (str != nullptr) ? (byte)strnlen(str, (src == _signalAddress[j]) ? _signalStringLimit(j) : 255) : 0;
+        out.write(len);
+        _crc.add(len);
+        if (len > 0)
+        {
+          out.write((const uint8_t *)str, len);
+          _crc.add((uint8_t *)str, len);
+        }
+      }
+      break;
       }
-    }
-    break;
-    }
 
-    // Updated flags are cleared by the caller after all clients are served
+      // Updated flags are cleared by the caller after all clients are served
+    }
   }
 
   // D2 tail: StatusByte + StatusPayload(4) + CRC32(4)
   byte statusByte = 0;
   byte statusPayload[4] = {0, 0, 0, 0};
-  Clients[i].connection.write(statusByte);
-  Clients[i].connection.write(statusPayload, 4);
+  out.write(statusByte);
+  out.write(statusPayload, 4);
   _crc.add(statusByte);
   _crc.add(statusPayload, 4);
+  BLAECK_TRACE_END(BLAECK_TRACE_SERIALIZE);
 
+  BLAECK_TRACE_BEGIN(BLAECK_TRACE_CRC);
   uint32_t crc_value = _crc.calc();
-  Clients[i].connection.write((byte *)&crc_value, 4);
+  BLAECK_TRACE_END(BLAECK_TRACE_CRC);
+  out.write((byte *)&crc_value, 4);
+
+  out.write("/BLAECK>");
+  out.write("\r\n");
+}
+
+byte BlaeckTCP::_dataTypeSize(dataType type)
+{
+  switch (type)
+  {
+  case Blaeck_bool:
+  case Blaeck_byte:
+    return 1;
+  case Blaeck_short:
+  case Blaeck_ushort:
+  case Blaeck_int:
+  case Blaeck_uint:
+    return 2;
+  case Blaeck_long:
+  case Blaeck_ulong:
+  case Blaeck_float:
+    return 4;
+  case Blaeck_double:
+    return 8;
+  case Blaeck_string:
+    return 1;
+  }
+  return 1;
+}
+
+bool BlaeckTCP::setSnapshotMode(BlaeckSnapshotMode mode)
+{
+  _snapshotMode = mode;
+  if (mode == BLAECK_SNAPSHOT_OFF)
+  {
+    _freeSnapshot();
+    return true;
+  }
+  if (!_layoutSnapshot())
+  {
+    _snapshotMode = BLAECK_SNAPSHOT_OFF;
+    if (StreamRef != nullptr)
+      StreamRef->println("Not enough memory for signal snapshots");
+    return false;
+  }
+  return true;
+}
+
+void BlaeckTCP::_freeSnapshot()
+{
+  delete[] _snapshotBuffer;
+  _snapshotBuffer = nullptr;
+  delete[] _snapshotOffsets;
+  _snapshotOffsets = nullptr;
+  _snapshotSize = 0;
+  _snapshotValid = false;
+  _snapshotStale = true;
+}
+
+bool BlaeckTCP::_layoutSnapshot()
+{
+  _freeSnapshot();
+
+  if (_signalIndex > 0)
+  {
+    _snapshotOffsets = new (std::nothrow) uint16_t[_signalIndex];
+    if (_snapshotOffsets == nullptr)
+      return false;
+  }
+
+  // Each value aligned to its own size, so the serializer can load it
+  // directly; a string slot is a NUL-terminated copy.
+  size_t size = 0;
+  for (int j = 0; j < _signalIndex; j++)
+  {
+    byte valueSize = _dataTypeSize((dataType)_signalType[j]);
+    if (_signalType[j] == Blaeck_string)
+      valueSize = 1;
+    size = (size + valueSize - 1) / valueSize * valueSize;
+    _snapshotOffsets[j] = (uint16_t)size;
+    size += (_signalType[j] == Blaeck_string) ? BLAECK_SNAPSHOT_STRING_MAX + 1 : valueSize;
+  }
+  // Keep the second buffer 8-byte aligned as well.
+  size = (size + 7) / 8 * 8;
+  if (size > 0xFFFF)
+    return false;
+
+  if (size > 0)
+  {
+    _snapshotBuffer = new (std::nothrow) uint8_t[2 * size];
+    if (_snapshotBuffer == nullptr)
+      return false;
+  }
+  _snapshotSize = size;
+  _snapshotFront = 0;
+  _snapshotReading = 0xFF;
+  _snapshotStale = false;
+  return true;
+}
+
+// Interrupts off for the lifetime of the object, then back to the state they
+// were in: safe inside an ISR or an enclosing critical section.
+struct BlaeckIrqLock
+{
+#if defined(ESP32)
+  static portMUX_TYPE mux;
+  BlaeckIrqLock() { portENTER_CRITICAL_SAFE(&mux); }
+  ~BlaeckIrqLock() { portEXIT_CRITICAL_SAFE(&mux); }
+#elif defined(ESP8266)
+  uint32_t savedPS;
+  BlaeckIrqLock() : savedPS(xt_rsil(15)) {}
+  ~BlaeckIrqLock() { xt_wsr_ps(savedPS); }
+#elif defined(__AVR__)
+  uint8_t savedSREG;
+  BlaeckIrqLock() : savedSREG(SREG) { cli(); }
+  ~BlaeckIrqLock() { SREG = savedSREG; }
+#elif defined(__arm__)
+  uint32_t savedPRIMASK;
+  BlaeckIrqLock()
+  {
+    __asm__ volatile("mrs %0, primask" : "=r"(savedPRIMASK));
+    __asm__ volatile("cpsid i" ::: "memory");
+  }
+  ~BlaeckIrqLock() { __asm__ volatile("msr primask, %0" ::"r"(savedPRIMASK) : "memory"); }
+#else
+  // No way to read the state back on this core: plain off/on.
+  BlaeckIrqLock() { noInterrupts(); }
+  ~BlaeckIrqLock() { interrupts(); }
+#endif
+};
+#if defined(ESP32)
+portMUX_TYPE BlaeckIrqLock::mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+bool BlaeckTCP::snapshot()
+{
+  if (_snapshotMode == BLAECK_SNAPSHOT_OFF)
+    return false;
+  // Signals changed since the layout was made: redo it (allocates, so do not
+  // add signals while an ISR takes snapshots).
+  if (_snapshotStale && !_layoutSnapshot())
+    return false;
+  if (_snapshotBuffer == nullptr)
+    return false;
+
+  byte back = _snapshotFront ^ 1;
+  if (_snapshotReading == back)
+    return false;
+
+  uint8_t *dst = _snapshotBuffer + back * _snapshotSize;
+  // Numeric values first, at most BLAECK_SNAPSHOT_LOCK_SPAN per critical
+  // section; no string copy inside those sections.
+  int j = 0;
+  while (j < _signalIndex)
+  {
+    BlaeckIrqLock lock;
+    for (int n = 0; j < _signalIndex && (BLAECK_SNAPSHOT_LOCK_SPAN == 0 || n < BLAECK_SNAPSHOT_LOCK_SPAN); j++)
+    {
+      if (_signalType[j] == Blaeck_string)
+        continue;
+      memcpy(dst + _snapshotOffsets[j], _signalAddress[j], _dataTypeSize((dataType)_signalType[j]));
+      n++;
+    }
+  }
+  for (j = 0; j < _signalIndex; j++)
+  {
+    if (_signalType[j] != Blaeck_string)
+      continue;
+    char *slot = (char *)dst + _snapshotOffsets[j];
+    BlaeckIrqLock lock;
+    const char *str = (const char *)_signalAddress[j];
+    if (str == nullptr)
+      str = "";
+    size_t limit = _signalStringLimit(j);
+    size_t len = strnlen(str, limit < BLAECK_SNAPSHOT_STRING_MAX ? limit : BLAECK_SNAPSHOT_STRING_MAX);
+    memcpy(slot, str, len);
+    slot[len] = '\0';
+  }
+
+  // Publish the copy before flipping it to the front.
+  __sync_synchronize();
+  _snapshotFront = back;
+  _snapshotValid = true;
+  return true;
+}
+
+const uint8_t *BlaeckTCP::_pinSnapshot()
+{
+  if (!_snapshotValid || _snapshotStale)
+    return nullptr;
+
+  // Claim the front buffer, then check it is still the front: if snapshot()
+  // flipped in between, it may already be writing the buffer we claimed.
+  byte front;
+  do
+  {
+    front = _snapshotFront;
+    _snapshotReading = front;
+    __sync_synchronize();
+  } while (front != _snapshotFront);
+
+  return _snapshotBuffer + front * _snapshotSize;
+}
 
-  Clients[i].connection.write("/BLAECK>");
-  Clients[i].connection.write("\r\n");
+void BlaeckTCP::_unpinSnapshot()
+{
+  __sync_synchronize();
+  _snapshotReading = 0xFF;
 }
 
 void BlaeckTCP::timedWriteAllData()
@@ -2765,13 +5827,7 @@ void BlaeckTCP::timedWriteData(unsigned long msg_id, int signalIndex_start, int
     }
     _timedFirstTime = false;
 
-    bool dataSent = false;
-    for (byte client = 0; client < _maxClients; client++)
-      if (Clients[client].connection.connected() && bitRead(_blaeckWriteDataClientMask, client) == 1)
-      {
-        this->writeData(msg_id, client, signalIndex_start, signalIndex_end, onlyUpdated, timestamp);
-        dataSent = true;
-      }
+    bool dataSent = this->_writeDataToClients(msg_id, signalIndex_start, signalIndex_end, onlyUpdated, timestamp);
     if (dataSent)
     {
       _sendRestartFlag = false;
@@ -2785,7 +5841,7 @@ void BlaeckTCP::writeDevices()
 {
   for (byte client = 0; client < _maxClients; client++)
   {
-    if (Clients[client].connection.connected())
+    if (_clientConnected(client))
     {
       this->writeDevices(1, client);
     }
@@ -2797,7 +5853,7 @@ void BlaeckTCP::writeDevices(unsigned long msg_id)
 {
   for (byte client = 0; client < _maxClients; client++)
   {
-    if (Clients[client].connection.connected())
+    if (_clientConnected(client))
     {
       this->writeDevices(msg_id, client);
     }
@@ -2807,6 +5863,7 @@ void BlaeckTCP::writeDevices(unsigned long msg_id)
 
 void BlaeckTCP::writeDevices(unsigned long msg_id, byte i)
 {
+  Print &out = _frameBegin(i);
   String deviceName = DeviceName;
   if (deviceName == "")
     deviceName = "Unknown";
@@ -2822,45 +5879,46 @@ void BlaeckTCP::writeDevices(unsigned long msg_id, byte i)
   byte clientNo = i;
   byte clientDataEnabled = bitRead(_blaeckWriteDataClientMask, clientNo);
 
-  Clients[i].connection.write("<BLAECK:");
+  out.write("<BLAECK:");
   byte msg_key = 0xB6;
-  Clients[i].connection.write(msg_key);
-  Clients[i].connection.write(":");
+  out.write(msg_key);
+  out.write(":");
   ulngCvt.val = msg_id;
-  Clients[i].connection.write(ulngCvt.bval, 4);
-  Clients[i].connection.write(":");
+  out.write(ulngCvt.bval, 4);
+  out.write(":");
   // DeviceCount = 1
-  Clients[i].connection.write((byte)1);
+  out.write((byte)1);
   // Device entry
-  Clients[i].connection.write((byte)0);
-  Clients[i].connection.write((byte)0);
-  Clients[i].connection.print(deviceName);
-  Clients[i].connection.print('\0');
-  Clients[i].connection.print(deviceHWVersion);
-  Clients[i].connection.print('\0');
-  Clients[i].connection.print(deviceFWVersion);
-  Clients[i].connection.print('\0');
-  Clients[i].connection.print(BLAECKTCP_VERSION);
-  Clients[i].connection.print('\0');
-  Clients[i].connection.print(BLAECKTCP_NAME);
-  Clients[i].connection.print('\0');
-  Clients[i].connection.print(_serverRestarted);
-  Clients[i].connection.print('\0');
-  Clients[i].connection.print("server");
-  Clients[i].connection.print('\0');
-  Clients[i].connection.print("0");
-  Clients[i].connection.print('\0');
+  out.write((byte)0);
+  out.write((byte)0);
+  out.print(deviceName);
+  out.print('\0');
+  out.print(deviceHWVersion);
+  out.print('\0');
+  out.print(deviceFWVersion);
+  out.print('\0');
+  out.print(BLAECKTCP_VERSION);
+  out.print('\0');
+  out.print(BLAECKTCP_NAME);
+  out.print('\0');
+  out.print(_serverRestarted);
+  out.print('\0');
+  out.print("server");
+  out.print('\0');
+  out.print("0");
+  out.print('\0');
   // Client trailer
-  Clients[i].connection.print(clientNo);
-  Clients[i].connection.print('\0');
-  Clients[i].connection.print(clientDataEnabled);
-  Clients[i].connection.print('\0');
-  Clients[i].connection.print(Clients[i].name);
-  Clients[i].connection.print('\0');
-  Clients[i].connection.print(Clients[i].type);
-  Clients[i].connection.print('\0');
-  Clients[i].connection.write("/BLAECK>");
-  Clients[i].connection.write("\r\n");
+  out.print(clientNo);
+  out.print('\0');
+  out.print(clientDataEnabled);
+  out.print('\0');
+  out.print(Clients[i].name);
+  out.print('\0');
+  out.print(Clients[i].type);
+  out.print('\0');
+  out.write("/BLAECK>");
+  out.write("\r\n");
+  _frameEnd(i);
 }
 
 void BlaeckTCP::tickUpdated()
@@ -2887,15 +5945,19 @@ void BlaeckTCP::tick(unsigned long msg_id)
 
 void BlaeckTCP::tick(unsigned long msg_id, bool onlyUpdated)
 {
+  BLAECK_STATS_TIME(tick);
+  BLAECK_TRACE_SCOPE(BLAECK_TRACE_TICK);
   this->read();
   this->timedWriteData(msg_id, 0, _signalIndex - 1, onlyUpdated, getTimeStamp());
+  this->_forwardStoredFrames();
+  this->_continueReplay();
 }
 
 void BlaeckTCP::markSignalUpdated(int signalIndex)
 {
   if (signalIndex >= 0 && signalIndex < _signalIndex)
   {
-    Signals[signalIndex].Updated = true;
+    _setSignalUpdated(signalIndex);
   }
 }
 
@@ -2903,9 +5965,9 @@ void BlaeckTCP::markSignalUpdated(String signalName)
 {
   for (int i = 0; i < _signalIndex; i++)
   {
-    if (Signals[i].SignalName == signalName)
+    if (_signalNameEquals(i, signalName.c_str()))
     {
-      Signals[i].Updated = true;
+      _setSignalUpdated(i);
       break;
     }
   }
@@ -2915,23 +5977,22 @@ void BlaeckTCP::markAllSignalsUpdated()
 {
   for (int i = 0; i < _signalIndex; i++)
   {
-    Signals[i].Updated = true;
+    _setSignalUpdated(i);
   }
 }
 
 void BlaeckTCP::clearAllUpdateFlags()
 {
-  for (int i = 0; i < _signalIndex; i++)
-  {
-    Signals[i].Updated = false;
-  }
+  if (_signalUpdated != nullptr)
+    memset(_signalUpdated, 0, (_signalIndex + 7) / 8);
 }
 
 bool BlaeckTCP::hasUpdatedSignals()
 {
-  for (int i = 0; i < _signalIndex; i++)
+  // Bits past _signalIndex are never set: whole bytes can be tested.
+  for (int i = 0; i < (_signalIndex + 7) / 8; i++)
   {
-    if (Signals[i].Updated)
+    if (_signalUpdated[i] != 0)
     {
       return true;
     }
@@ -3012,6 +6073,11 @@ void BlaeckTCP::validatePlatformSizes()
   static_assert(sizeof(unsigned int) == 2, "BlaeckTCP: Expected 2-byte unsigned int on AVR");
   static_assert(sizeof(double) == 4, "BlaeckTCP: Expected 4-byte double on AVR");
   static_assert(sizeof(double) == sizeof(float), "BlaeckTCP: double should equal float on AVR");
+#elif defined(BLAECK_HOST)
+  // Host build (extras/host), 64-bit Linux: long is 8 bytes there and long
+  // signals go out as their low 4 bytes, like on the boards.
+  static_assert(sizeof(int) == 4, "BlaeckTCP: Expected 4-byte int on the host");
+  static_assert(sizeof(double) == 8, "BlaeckTCP: Expected 8-byte double on the host");
 #else
   // 32-bit platform checks
   static_assert(sizeof(int) == 4, "BlaeckTCP: Expected 4-byte int on 32-bit platforms");
@@ -3027,7 +6093,9 @@ void BlaeckTCP::validatePlatformSizes()
   static_assert(sizeof(byte) == 1, "BlaeckTCP: Expected 1-byte byte");
   static_assert(sizeof(short) == 2, "BlaeckTCP: Expected 2-byte short");
   static_assert(sizeof(unsigned short) == 2, "BlaeckTCP: Expected 2-byte unsigned short");
+#ifndef BLAECK_HOST
   static_assert(sizeof(long) == 4, "BlaeckTCP: Expected 4-byte long");
   static_assert(sizeof(unsigned long) == 4, "BlaeckTCP: Expected 4-byte unsigned long");
+#endif
   static_assert(sizeof(float) == 4, "BlaeckTCP: Expected 4-byte float");
 }
@@ -94,6 +94,36 @@
   #define BLAECK_ENABLE_COMMAND_META 1
 #endif
 
+// Runtime statistics about the library itself (default ON; OFF on AVR):
+// counters and min/max/mean timers for tick(), read(), writeData() and socket
+// writes, read with getStats() or over the wire with BLAECK.GET_STATS (0xC0
+// frame). Each timed section costs two micros() calls, each socket write one
+// extra virtual call. Turn OFF to drop all of it.
+#ifndef BLAECK_ENABLE_STATS
+  #if defined(__AVR__)
+    #define BLAECK_ENABLE_STATS 0
+  #else
+    #define BLAECK_ENABLE_STATS 1
+  #endif
+#endif
+
+// Trace points around the phases of tick() (default OFF): accept, receive,
+// parse, dispatch, before-write callback, serialize, CRC and socket writes
+// record begin/end events with a cycle-counter timestamp into a ring of
+// BLAECK_TRACE_SIZE events (8 bytes each). Read with getTraceEvent(), print
+// with dumpTrace() or fetch with BLAECK.GET_TRACE (0xC1 frame). OFF compiles
+// every trace point away.
+#ifndef BLAECK_ENABLE_TRACE
+  #define BLAECK_ENABLE_TRACE 0
+#endif
+
+#ifndef BLAECK_TRACE_SIZE
+  #if defined(__AVR__)
+    #define BLAECK_TRACE_SIZE 32
+  #else
+    #define BLAECK_TRACE_SIZE 128
+  #endif
+#endif
 
 // Disable Nagle's algorithm for lower latency on ESP32/ESP8266.
 // Set to false in BlaeckTCPConfig.h if you prefer throughput over latency.
@@ -101,15 +131,190 @@
   #define BLAECK_TCP_NO_DELAY_DEFAULT true
 #endif
 
+// Dedicated network task (ESP32 only, default OFF).
+// When ON, startNetworkTask() spawns a FreeRTOS task - pinned to the core the
+// Arduino loop does not run on - that owns all socket I/O: accepting and
+// dropping clients, receiving commands and writing frames. The loop task only
+// samples, dispatches commands and encodes frames into a lock-free queue, so a
+// stalled socket no longer stalls the control loop.
+// The TX queue holds encoded frames waiting for the socket; a frame that does
+// not fit is dropped and counted (getNetworkTxDropCount()). The RX queue
+// carries received commands and connect/disconnect events to the loop task.
+#ifndef BLAECK_NETWORK_TASK
+  #define BLAECK_NETWORK_TASK 0
+#endif
+
+#if BLAECK_NETWORK_TASK
+  #if !defined(ARDUINO_ARCH_ESP32)
+    #error "BLAECK_NETWORK_TASK needs an ESP32 (FreeRTOS)"
+  #endif
+  #ifndef BLAECK_NETWORK_TASK_TX_SIZE
+    #define BLAECK_NETWORK_TASK_TX_SIZE 8192
+  #endif
+  #ifndef BLAECK_NETWORK_TASK_RX_SIZE
+    #define BLAECK_NETWORK_TASK_RX_SIZE 1024
+  #endif
+  // The core the loop task is not pinned to; single-core chips share core 0.
+  #ifndef BLAECK_NETWORK_TASK_CORE_DEFAULT
+    #if CONFIG_FREERTOS_UNICORE
+      #define BLAECK_NETWORK_TASK_CORE_DEFAULT 0
+    #else
+      #define BLAECK_NETWORK_TASK_CORE_DEFAULT (1 - ARDUINO_RUNNING_CORE)
+    #endif
+  #endif
+#endif
+
+// Event-driven TCP backend (ESP32: AsyncTCP, ESP8266: ESPAsyncTCP; default OFF).
+// Instead of polling every socket through NetServer/NetClient on each tick,
+// the AsyncTCP callbacks push received bytes into a per-client ring and flag
+// disconnects, so an idle tick only checks a few counters. Outgoing frames are
+// queued whole in a per-client ring of BLAECK_ASYNC_TCP_TX_SIZE bytes and
+// handed to lwIP as its send buffer has room; a frame that does not fit the
+// ring is dropped whole. Needs the AsyncTCP (ESP32) or ESPAsyncTCP (ESP8266)
+// library.
+#ifndef BLAECK_ASYNC_TCP
+  #define BLAECK_ASYNC_TCP 0
+#endif
+
+#if BLAECK_ASYNC_TCP
+  #if !defined(ESP32) && !defined(ESP8266)
+    #error "BLAECK_ASYNC_TCP needs an ESP32 (AsyncTCP) or an ESP8266 (ESPAsyncTCP)"
+  #endif
+  #if BLAECK_NETWORK_TASK
+    #error "BLAECK_ASYNC_TCP and BLAECK_NETWORK_TASK are alternatives, enable only one"
+  #endif
+  #ifndef BLAECK_ASYNC_TCP_RX_SIZE
+    #define BLAECK_ASYNC_TCP_RX_SIZE 1024
+  #endif
+  #ifndef BLAECK_ASYNC_TCP_TX_SIZE
+    #if defined(ESP8266)
+      #define BLAECK_ASYNC_TCP_TX_SIZE 4096
+    #else
+      #define BLAECK_ASYNC_TCP_TX_SIZE 8192
+    #endif
+  #endif
+#endif
+
+// Signal snapshots: string signals are copied into the snapshot up to this
+// many bytes (longer strings are cut). Each string signal costs twice this
+// plus two bytes of snapshot buffer.
+#ifndef BLAECK_SNAPSHOT_STRING_MAX
+  #if defined(__AVR__)
+    #define BLAECK_SNAPSHOT_STRING_MAX 16
+  #else
+    #define BLAECK_SNAPSHOT_STRING_MAX 32
+  #endif
+#endif
+
+// Signal snapshots: the numeric values are copied with interrupts off, in
+// runs of at most this many signals (0: all in one run, coherent against ISRs
+// across the whole set). Lower it if the interrupt latency of one run is too
+// long for the sketch; each value is still copied whole.
+#ifndef BLAECK_SNAPSHOT_LOCK_SPAN
+  #define BLAECK_SNAPSHOT_LOCK_SPAN 0
+#endif
+
+// History (beginHistory()): bytes of a BLAECK.REPLAY sent per tick(), so live
+// data keeps priority over the replay and the network task's TX queue is not
+// overrun.
+#ifndef BLAECK_HISTORY_REPLAY_BYTES
+  #define BLAECK_HISTORY_REPLAY_BYTES 1024
+#endif
+
+// Store-and-forward (setFrameStore()): data frames produced while no
+// data-enabled client is connected are collected in a RAM page of this size
+// and appended to the store one page at a time. A frame larger than the page
+// grows it to the frame's size (heap), so every frame can be stored.
+#ifndef BLAECK_STORE_PAGE_SIZE
+  #if defined(__AVR__)
+    #define BLAECK_STORE_PAGE_SIZE 256
+  #else
+    #define BLAECK_STORE_PAGE_SIZE 512
+  #endif
+#endif
+
+// Stored bytes forwarded per tick() once a client is back, so live data keeps
+// priority over the backlog.
+#ifndef BLAECK_STORE_FORWARD_BYTES
+  #define BLAECK_STORE_FORWARD_BYTES 1024
+#endif
+
+// Bridge mode rings, one per direction. TX holds bytes from the TCP clients
+// on their way to the serial device; RX holds bytes from the device on their
+// way to the clients and must cover the time between two bridgePoll() calls
+// at the device's baud rate (921600 baud is about 92 bytes per millisecond).
+#ifndef BLAECK_BRIDGE_TX_SIZE
+  #if defined(__AVR__)
+    #define BLAECK_BRIDGE_TX_SIZE 128
+  #else
+    #define BLAECK_BRIDGE_TX_SIZE 1024
+  #endif
+#endif
+
+#ifndef BLAECK_BRIDGE_RX_SIZE
+  #if defined(__AVR__)
+    #define BLAECK_BRIDGE_RX_SIZE 256
+  #else
+    #define BLAECK_BRIDGE_RX_SIZE 4096
+  #endif
+#endif
+
+// Frame-aware bridge: requests forwarded to the device and still waiting for
+// their response or ack. The oldest is reused when all are taken; an entry
+// nobody answered is given up after the timeout.
+#ifndef BLAECK_BRIDGE_MAX_REQUESTS
+  #define BLAECK_BRIDGE_MAX_REQUESTS 8
+#endif
+
+#ifndef BLAECK_BRIDGE_REQUEST_TIMEOUT_MS
+  #define BLAECK_BRIDGE_REQUEST_TIMEOUT_MS 3000
+#endif
+
+// Bridge mode: serial devices one bridge serves, the first one passed to
+// beginBridge(), the others added with addBridgeDevice(). Each has its own
+// pair of rings.
+#ifndef BLAECK_BRIDGE_MAX_DEVICES
+  #if defined(__AVR__)
+    #define BLAECK_BRIDGE_MAX_DEVICES 1
+  #else
+    #define BLAECK_BRIDGE_MAX_DEVICES 4
+  #endif
+#endif
+
+#if BLAECK_BRIDGE_MAX_DEVICES < 1 || BLAECK_BRIDGE_MAX_DEVICES > 8
+  #error "BLAECK_BRIDGE_MAX_DEVICES must be 1..8"
+#endif
+
+// Frame-aware bridge: largest symbol (0xB0) or device (0xB6) frame the bridge
+// keeps to answer repeat requests itself. Each of the two is allocated on
+// first use; 0 turns the cache off and limits the bridge to one device, as
+// several devices' answers are merged in these buffers.
+#ifndef BLAECK_BRIDGE_CACHE_SIZE
+  #if defined(__AVR__)
+    #define BLAECK_BRIDGE_CACHE_SIZE 0
+  #else
+    #define BLAECK_BRIDGE_CACHE_SIZE 2048
+  #endif
+#endif
+
+#if !BLAECK_ASYNC_TCP
 #include <TelnetPrint.h>
+#endif
 #include <CRC.h>
+#include <Udp.h>
 // std::nothrow, so an oversized signal array fails to a null pointer that
 // begin() can report rather than aborting.
 #include <new>
 // strcmp/strncpy/strlen/... are used throughout; do not rely on Arduino.h
 // happening to pull this in.
 #include <string.h>
+// offsetof for the struct-mapped schema
+#include <stddef.h>
+#if defined(ESP32) || defined(ESP8266)
+#include <FS.h>
+#endif
 
+// The values double as the type codes of the symbol list (0xB0) frame.
 typedef enum DataType
 {
   Blaeck_bool,
@@ -125,13 +330,18 @@ typedef enum DataType
   Blaeck_string
 } dataType;
 
-struct Signal
-{
-  String SignalName;
-  dataType DataType;
-  void *Address;
-  bool Updated = false;
-};
+// Wire type of the platform-sized C types
+#ifdef __AVR__
+#define BLAECK_TYPE_INT Blaeck_int   // 2 bytes
+#define BLAECK_TYPE_UINT Blaeck_uint // 2 bytes
+/*On the Uno and other ATMEGA based boards, the double implementation occupies 4 bytes
+and is exactly the same as the float, with no gain in precision.*/
+#define BLAECK_TYPE_DOUBLE Blaeck_float
+#else
+#define BLAECK_TYPE_INT Blaeck_long   // Treat as 4-byte long
+#define BLAECK_TYPE_UINT Blaeck_ulong // Treat as 4-byte unsigned long
+#define BLAECK_TYPE_DOUBLE Blaeck_double
+#endif
 
 enum BlaeckTimestampMode
 {
@@ -141,18 +351,548 @@ enum BlaeckTimestampMode
   BLAECK_RTC = BLAECK_UNIX // Deprecated alias
 };
 
+// Where data frames take their values from.
+//   OFF     signal variables are read while the frame is serialized (default)
+//   AUTO    all values are copied into a snapshot right before each data
+//           frame; every client gets the same instant
+//   MANUAL  frames use the latest snapshot() taken by the sketch
+enum BlaeckSnapshotMode
+{
+  BLAECK_SNAPSHOT_OFF = 0,
+  BLAECK_SNAPSHOT_AUTO = 1,
+  BLAECK_SNAPSHOT_MANUAL = 2
+};
+
 enum BlaeckIntervalMode
 {
   BLAECK_INTERVAL_CLIENT = -1,
   BLAECK_INTERVAL_OFF = -2
 };
 
+// Single-producer/single-consumer byte ring. The producer only ever moves the
+// head and the consumer only the tail, so one writer and one reader (two
+// tasks, or a task and an ISR) share it without a lock. One byte of the
+// buffer stays unused to tell "full" from "empty".
+// Staged writes let the producer assemble a record past the head and publish
+// it in one step (stageCommit), so the consumer never sees half a record.
+class BlaeckByteRing
+{
+public:
+  ~BlaeckByteRing();
+
+  bool begin(size_t size);
+  void end();
+  bool isAllocated() const { return _buf != nullptr; }
+  size_t capacity() const { return _size ? _size - 1 : 0; }
+
+  // Consumer side
+  size_t available() const;
+  size_t peek(uint8_t *data, size_t len, size_t offset = 0) const;
+  // Overwrites bytes not consumed yet, offset from the front
+  void patch(size_t offset, const uint8_t *data, size_t len);
+  size_t readable(const uint8_t **data, size_t offset = 0) const;
+  void consume(size_t len);
+
+  // Producer side
+  size_t availableForWrite() const;
+  size_t write(const uint8_t *data, size_t len);
+  // Contiguous free space at the head, filled in place and published by produce()
+  size_t writable(uint8_t **data) const;
+  void produce(size_t len);
+  void stageBegin();
+  bool stage(const uint8_t *data, size_t len);
+  void stagePatch(size_t offset, const uint8_t *data, size_t len);
+  size_t staged() const { return _stageLen; }
+  bool stageCommit();
+
+private:
+  uint8_t *_buf = nullptr;
+  size_t _size = 0;
+  volatile size_t _head = 0;
+  volatile size_t _tail = 0;
+  size_t _stageLen = 0;
+  bool _stageOverflow = false;
+};
+
+#if BLAECK_ASYNC_TCP
+class AsyncClient;
+class AsyncServer;
+
+// One socket of the async backend. The AsyncTCP callbacks (async_tcp task on
+// ESP32, lwIP context on ESP8266) claim a FREE socket, fill rx and clear
+// `open`; tx and everything else is touched by the loop task only.
+// A closed socket's AsyncClient is deleted by whichever comes last: the
+// loop's stop() or the disconnect callback (see release()).
+struct BlaeckAsyncSocket
+{
+  enum : byte { FREE, PENDING, IN_USE, CLOSING };
+
+  AsyncClient *client = nullptr;
+  volatile byte state = FREE;
+  volatile bool open = false;
+  volatile bool released = false;
+  byte generation = 0;
+  BlaeckByteRing rx;
+  volatile uint32_t dropped = 0;
+  // Whole frames waiting for room in lwIP's send buffer. The frame being
+  // written is staged and published (or dropped) by commit().
+  BlaeckByteRing tx;
+  bool txStaging = false;
+
+  void commit();
+  void push();
+  bool release();
+};
+
+// NetClient look-alike on top of a BlaeckAsyncSocket, so Clients[i].connection
+// and CommandingClient work the same with both backends. A copy of a closed
+// connection tests false even after its socket was reused.
+class BlaeckAsyncConnection : public Stream
+{
+public:
+  BlaeckAsyncConnection() {}
+  explicit BlaeckAsyncConnection(BlaeckAsyncSocket *socket)
+      : _socket(socket), _generation(socket->generation) {}
+
+  operator bool() const { return _valid(); }
+  bool connected();
+  int available() override;
+  int read() override;
+  int read(uint8_t *buf, size_t size);
+  int peek() override;
+  size_t write(uint8_t b) override;
+  // All or nothing: 0 once the frame being written no longer fits the TX ring
+  size_t write(const uint8_t *buf, size_t size) override;
+  using Print::write;
+  int availableForWrite() override;
+  // Ends the frame being written and hands queued bytes to lwIP.
+  void flush() override;
+  void stop();
+  IPAddress remoteIP();
+  uint16_t remotePort();
+
+private:
+  bool _valid() const
+  {
+    return _socket != nullptr && _socket->state == BlaeckAsyncSocket::IN_USE &&
+           _socket->generation == _generation;
+  }
+
+  BlaeckAsyncSocket *_socket = nullptr;
+  byte _generation = 0;
+};
+
+typedef BlaeckAsyncConnection BlaeckConnection;
+#else
+typedef NetClient BlaeckConnection;
+#endif
+
+// Backing store for store-and-forward: a log the library appends whole pages
+// to and reads back front to back. Implement it for any medium (SD card,
+// external flash, a file on the host); BlaeckFSStore covers LittleFS/SPIFFS/SD
+// on ESP32 and ESP8266.
+class BlaeckFrameStore
+{
+public:
+  virtual ~BlaeckFrameStore() {}
+  // Appends len bytes at the end. Returns false if they could not be stored.
+  virtual bool append(const uint8_t *data, size_t len) = 0;
+  // Reads up to len bytes starting offset bytes from the front.
+  virtual size_t read(uint32_t offset, uint8_t *data, size_t len) = 0;
+  // Bytes stored (also what survived a reboot).
+  virtual uint32_t size() = 0;
+  // Drops everything; called once the log was forwarded completely.
+  virtual void clear() = 0;
+};
+
+#if defined(ESP32) || defined(ESP8266)
+// BlaeckFrameStore on one file of an fs::FS (LittleFS, SPIFFS, SD, ...).
+// The file is only ever appended to, one page per write, and removed once
+// forwarded; the file system does the wear leveling.
+class BlaeckFSStore : public BlaeckFrameStore
+{
+public:
+  BlaeckFSStore(fs::FS &fs, const char *path) : _fs(fs), _path(path) {}
+  bool append(const uint8_t *data, size_t len) override;
+  size_t read(uint32_t offset, uint8_t *data, size_t len) override;
+  uint32_t size() override;
+  void clear() override;
+
+private:
+  fs::FS &_fs;
+  const char *_path;
+};
+#endif
+
+// ----- Compile-time signal schema -----
+// For a signal set fixed at build time: the type codes and the schema hash
+// are constants, and a full data frame is written by code unrolled per
+// signal instead of a type switch per signal. Declare each signal once,
+//   BLAECK_STATIC_SIGNAL(Temperature, float, "Temperature");
+//   BLAECK_STATIC_SIGNAL(Counter, long, "Counter");
+// list them in a schema together with the variables they read,
+//   BlaeckStaticSchema<Temperature, Counter> schema(&temp, &counter);
+// and register it with setSchema(schema).
+#define BLAECK_STATIC_SIGNAL(id, type, signalName)             \
+  struct id                                                     \
+  {                                                             \
+    typedef type value_type;                                    \
+    static constexpr const char *name() { return signalName; } \
+  }
+
+// Wire type code and encoder per C type (char: a string signal).
+template <typename T>
+struct BlaeckWire;
+
+template <typename T, byte Code, size_t Size = sizeof(T)>
+struct BlaeckWireFixed
+{
+  static constexpr byte code = Code;
+  static constexpr size_t size = Size;
+  static void write(Print &out, CRC32 &crc, const T *value)
+  {
+    // The low Size bytes: little-endian targets only, like the unions in writeData()
+    out.write((const uint8_t *)value, Size);
+    crc.add((const uint8_t *)value, Size);
+  }
+};
+
+template <> struct BlaeckWire<bool> : BlaeckWireFixed<bool, Blaeck_bool> {};
+template <> struct BlaeckWire<byte> : BlaeckWireFixed<byte, Blaeck_byte> {};
+template <> struct BlaeckWire<short> : BlaeckWireFixed<short, Blaeck_short> {};
+template <> struct BlaeckWire<unsigned short> : BlaeckWireFixed<unsigned short, Blaeck_ushort> {};
+template <> struct BlaeckWire<int> : BlaeckWireFixed<int, BLAECK_TYPE_INT, (sizeof(int) < 4 ? sizeof(int) : 4)> {};
+template <> struct BlaeckWire<unsigned int> : BlaeckWireFixed<unsigned int, BLAECK_TYPE_UINT, (sizeof(int) < 4 ? sizeof(int) : 4)> {};
+template <> struct BlaeckWire<long> : BlaeckWireFixed<long, Blaeck_long, 4> {};
+template <> struct BlaeckWire<unsigned long> : BlaeckWireFixed<unsigned long, Blaeck_ulong, 4> {};
+template <> struct BlaeckWire<float> : BlaeckWireFixed<float, Blaeck_float> {};
+template <> struct BlaeckWire<double> : BlaeckWireFixed<double, BLAECK_TYPE_DOUBLE> {};
+template <>
+struct BlaeckWire<char>
+{
+  static constexpr byte code = Blaeck_string;
+  // At most maxLen characters are read: the length byte caps them at 255
+  // anyway, and a char[N] member may lack its terminator.
+  static void write(Print &out, CRC32 &crc, const char *value, size_t maxLen = 255)
+  {
+    byte len = (value != nullptr) ? (byte)strnlen(value, maxLen < 255 ? maxLen : 255) : 0;
+    out.write(len);
+    crc.add(len);
+    if (len > 0)
+    {
+      out.write((const uint8_t *)value, len);
+      crc.add((const uint8_t *)value, len);
+    }
+  }
+};
+
+// CRC16-CCITT (init 0, poly 0x1021) of the schema, as _schemaHashAdd()
+// does it at runtime. Single-return constexpr functions for C++11.
+constexpr uint16_t blaeckCrc16Shift(uint16_t crc, byte bits)
+{
+  return bits == 0 ? crc : blaeckCrc16Shift((crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1), bits - 1);
+}
+
+constexpr uint16_t blaeckCrc16Add(uint16_t crc, byte b)
+{
+  return blaeckCrc16Shift(crc ^ ((uint16_t)b << 8), 8);
+}
+
+constexpr uint16_t blaeckCrc16Add(uint16_t crc, const char *text)
+{
+  return *text == 0 ? crc : blaeckCrc16Add(blaeckCrc16Add(crc, (byte)*text), text + 1);
+}
+
+template <typename... Signals>
+struct BlaeckSchemaHash
+{
+  static constexpr uint16_t calc(uint16_t crc) { return crc; }
+};
+
+template <typename Head, typename... Tail>
+struct BlaeckSchemaHash<Head, Tail...>
+{
+  static constexpr uint16_t calc(uint16_t crc)
+  {
+    return BlaeckSchemaHash<Tail...>::calc(blaeckCrc16Add(blaeckCrc16Add(crc, Head::name()), BlaeckWire<typename Head::value_type>::code));
+  }
+};
+
+// A char[N] struct member: a string signal of at most N characters.
+template <size_t N>
+struct BlaeckCharArray
+{
+  char text[N];
+};
+
+template <size_t N>
+struct BlaeckWire<BlaeckCharArray<N>>
+{
+  static constexpr byte code = Blaeck_string;
+  static void write(Print &out, CRC32 &crc, const BlaeckCharArray<N> *value)
+  {
+    BlaeckWire<char>::write(out, crc, (const char *)value, N);
+  }
+};
+
+// Most characters a string signal of type T can hold (the wire's 255 cap
+// unless it is a char[N] member).
+template <typename T>
+struct BlaeckStringLimit
+{
+  static constexpr size_t value = 255;
+};
+
+template <size_t N>
+struct BlaeckStringLimit<BlaeckCharArray<N>>
+{
+  static constexpr size_t value = N < 255 ? N : 255;
+};
+
+// Encodes the value of schema signal i: the declared variable, except for
+// strings, which write(i, char *) can repoint; they follow the signal table.
+template <typename T>
+struct BlaeckSchemaValue
+{
+  static void write(Print &out, CRC32 &crc, const void *declared, void *const *, unsigned int)
+  {
+    BlaeckWire<T>::write(out, crc, (const T *)declared);
+  }
+};
+
+template <>
+struct BlaeckSchemaValue<char>
+{
+  static void write(Print &out, CRC32 &crc, const void *, void *const *addresses, unsigned int i)
+  {
+    BlaeckWire<char>::write(out, crc, (const char *)addresses[i]);
+  }
+};
+
+template <size_t N>
+struct BlaeckSchemaValue<BlaeckCharArray<N>>
+{
+  static void write(Print &out, CRC32 &crc, const void *declared, void *const *addresses, unsigned int i)
+  {
+    // Bounded by the member only while it is still the one pointed to
+    const char *value = (const char *)addresses[i];
+    BlaeckWire<char>::write(out, crc, value, (value == declared) ? N : 255);
+  }
+};
+
+// What setSchema() needs from a schema, independent of its signal list.
+class BlaeckSchema
+{
+public:
+  virtual ~BlaeckSchema() {}
+  virtual unsigned int signalCount() const = 0;
+  virtual const char *signalName(unsigned int i) const = 0;
+  virtual byte signalType(unsigned int i) const = 0;
+  virtual void *signalAddress(unsigned int i) const = 0;
+  virtual uint16_t hash() const = 0;
+  // Characters string signal i can hold at its declared address
+  virtual size_t stringLimit(unsigned int i) const { return 255; }
+  // Index + value of every signal, in order: the body of a full data frame.
+  // addresses is the signal table (string signals are read through it).
+  virtual void writeValues(Print &out, CRC32 &crc, void *const *addresses) const = 0;
+};
+
+template <typename... Signals>
+class BlaeckStaticSchema : public BlaeckSchema
+{
+public:
+  static constexpr unsigned int count = sizeof...(Signals);
+  static constexpr uint16_t schemaHash = BlaeckSchemaHash<Signals...>::calc(0);
+
+  // One pointer per signal, type-checked against its declaration.
+  BlaeckStaticSchema(typename Signals::value_type *...values) : _values{values...} {}
+
+  unsigned int signalCount() const override { return count; }
+  const char *signalName(unsigned int i) const override
+  {
+    static const char *const names[] = {Signals::name()...};
+    return names[i];
+  }
+  byte signalType(unsigned int i) const override
+  {
+    static const byte codes[] = {BlaeckWire<typename Signals::value_type>::code...};
+    return codes[i];
+  }
+  void *signalAddress(unsigned int i) const override { return _values[i]; }
+  uint16_t hash() const override { return schemaHash; }
+  void writeValues(Print &out, CRC32 &crc, void *const *addresses) const override { _write<0, Signals...>(out, crc, addresses); }
+
+private:
+  template <unsigned int Index>
+  void _write(Print &, CRC32 &, void *const *) const {}
+
+  template <unsigned int Index, typename Head, typename... Tail>
+  void _write(Print &out, CRC32 &crc, void *const *addresses) const
+  {
+    static const uint8_t index[2] = {(uint8_t)(Index & 0xFF), (uint8_t)(Index >> 8)};
+    out.write(index, 2);
+    crc.add(index, 2);
+    BlaeckSchemaValue<typename Head::value_type>::write(out, crc, _values[Index], addresses, Index);
+    _write<Index + 1, Tail...>(out, crc, addresses);
+  }
+
+  void *_values[count > 0 ? count : 1];
+};
+
+template <typename... Signals>
+constexpr unsigned int BlaeckStaticSchema<Signals...>::count;
+template <typename... Signals>
+constexpr uint16_t BlaeckStaticSchema<Signals...>::schemaHash;
+
+// Struct-mapped variant: the signals are members of one struct, declared by
+// member instead of by type,
+//   struct Telemetry { float temperature; long counter; char state[16]; };
+//   BLAECK_STRUCT_SIGNAL(Temperature, Telemetry, temperature, "Temperature");
+//   BLAECK_STRUCT_SIGNAL(Counter, Telemetry, counter, "Counter");
+//   BLAECK_STRUCT_SIGNAL(State, Telemetry, state, "State");
+//   BlaeckStructSchema<Telemetry, Temperature, Counter, State> schema(&telemetry);
+// Each value is read at a compile-time offset from the one struct pointer. A
+// char array member is a string signal.
+#define BLAECK_STRUCT_SIGNAL(id, structType, member, signalName)                                  \
+  struct id                                                                                         \
+  {                                                                                                 \
+    typedef BlaeckFieldType<decltype(((structType *)nullptr)->member)>::type value_type;            \
+    static constexpr size_t offset() { return offsetof(structType, member); }                      \
+    static constexpr const char *name() { return signalName; }                                     \
+  }
+
+template <typename T>
+struct BlaeckFieldType
+{
+  typedef T type;
+};
+
+template <size_t N>
+struct BlaeckFieldType<char[N]>
+{
+  typedef BlaeckCharArray<N> type;
+};
+
+template <typename Struct, typename... Signals>
+class BlaeckStructSchema : public BlaeckSchema
+{
+public:
+  static constexpr unsigned int count = sizeof...(Signals);
+  static constexpr uint16_t schemaHash = BlaeckSchemaHash<Signals...>::calc(0);
+
+  BlaeckStructSchema(Struct *data) : _data((uint8_t *)data) {}
+
+  unsigned int signalCount() const override { return count; }
+  const char *signalName(unsigned int i) const override
+  {
+    static const char *const names[] = {Signals::name()...};
+    return names[i];
+  }
+  byte signalType(unsigned int i) const override
+  {
+    static const byte codes[] = {BlaeckWire<typename Signals::value_type>::code...};
+    return codes[i];
+  }
+  void *signalAddress(unsigned int i) const override
+  {
+    static const size_t offsets[] = {Signals::offset()...};
+    return _data + offsets[i];
+  }
+  uint16_t hash() const override { return schemaHash; }
+  size_t stringLimit(unsigned int i) const override
+  {
+    static const size_t limits[] = {BlaeckStringLimit<typename Signals::value_type>::value...};
+    return limits[i];
+  }
+  void writeValues(Print &out, CRC32 &crc, void *const *addresses) const override { _write<0, Signals...>(out, crc, addresses); }
+
+private:
+  template <unsigned int Index>
+  void _write(Print &, CRC32 &, void *const *) const {}
+
+  template <unsigned int Index, typename Head, typename... Tail>
+  void _write(Print &out, CRC32 &crc, void *const *addresses) const
+  {
+    static const uint8_t index[2] = {(uint8_t)(Index & 0xFF), (uint8_t)(Index >> 8)};
+    out.write(index, 2);
+    crc.add(index, 2);
+    BlaeckSchemaValue<typename Head::value_type>::write(out, crc, _data + Head::offset(), addresses, Index);
+    _write<Index + 1, Tail...>(out, crc, addresses);
+  }
+
+  uint8_t *_data;
+};
+
+template <typename Struct, typename... Signals>
+constexpr unsigned int BlaeckStructSchema<Struct, Signals...>::count;
+template <typename Struct, typename... Signals>
+constexpr uint16_t BlaeckStructSchema<Struct, Signals...>::schemaHash;
+
 struct BlaeckClient {
-    NetClient connection;
+    BlaeckConnection connection;
     char name[20];
     char type[8];
+    unsigned long connectedSince_ms;  // millis() when the slot was filled
+    unsigned long lastActivity_ms;    // millis() of the last byte received
+    bool reportsRoom;                 // availableForWrite() reported room once
+    int mostRoom;                     // the most room it reported
+#if BLAECK_ENABLE_STATS
+    uint32_t bytesSent;               // bytes written to it since it connected
+#endif
+};
+
+#if BLAECK_ENABLE_TRACE
+// Where a trace event was recorded
+enum BlaeckTracePoint : byte
+{
+  BLAECK_TRACE_TICK,         // tick(): everything below
+  BLAECK_TRACE_ACCEPT,       // polling for and greeting a new client
+  BLAECK_TRACE_RECEIVE,      // reading command bytes from the clients
+  BLAECK_TRACE_PARSE,        // parseData()
+  BLAECK_TRACE_DISPATCH,     // BLAECK.* commands and registered handlers
+  BLAECK_TRACE_BEFORE_WRITE, // the before-write callback
+  BLAECK_TRACE_SERIALIZE,    // encoding a data frame, running CRC included
+  BLAECK_TRACE_CRC,          // finishing the CRC32
+  BLAECK_TRACE_SOCKET_WRITE, // one write to a client socket
+  BLAECK_TRACE_POINT_COUNT
 };
 
+struct BlaeckTraceEvent
+{
+  uint32_t cycles; // cycle counter (micros() where there is none)
+  byte point;      // BlaeckTracePoint
+  bool end;        // false: phase began, true: phase ended
+};
+#endif
+
+#if BLAECK_ENABLE_STATS
+// Durations of one timed section, in microseconds
+struct BlaeckTimer
+{
+  uint32_t count;
+  uint32_t min_us;
+  uint32_t max_us;
+  unsigned long long total_us;
+
+  uint32_t mean_us() const { return count ? (uint32_t)(total_us / count) : 0; }
+  void add(uint32_t us);
+};
+
+// What the library did since begin() or resetStats()
+struct BlaeckStats
+{
+  uint32_t dataFrames;       // data frames encoded (once per receiver)
+  uint32_t bytesSent;        // bytes written to client sockets
+  uint32_t writeStalls;      // socket writes that took fewer bytes than given
+  uint32_t commandsParsed;   // commands received
+  uint32_t commandsRejected; // commands acked as rejected
+  BlaeckTimer tick;          // tick() / tickUpdated()
+  BlaeckTimer read;          // read() calls that received a command
+  BlaeckTimer writeData;     // encoding one data frame
+  BlaeckTimer socketWrite;   // one frame written to a client socket
+};
+#endif
+
 typedef void (*BlaeckCommandHandler)(const char *command, const char *const *params, byte paramCount);
 typedef void (*BlaeckAnyCommandHandler)(const char *command, const char *const *params, byte paramCount);
 
@@ -180,8 +920,16 @@ enum BlaeckCommandAckReason
   BLAECK_ACK_TOO_LONG = 5      // rejected: text value longer than the advertised max length
 };
 
+template <typename T>
+class BlaeckSignal;
+
 class BlaeckTCP
 {
+  template <typename T>
+  friend class BlaeckSignal;
+  // extras/BlaeckBench times the private encoder, parser and dispatcher
+  friend class BlaeckBench;
+
 public:
   // ----- Constructor -----
   BlaeckTCP();
@@ -202,25 +950,63 @@ public:
 
   BlaeckClient *Clients = nullptr;
   // CommandingClient is the client which sent the parsed command
-  NetClient CommandingClient;
+  BlaeckConnection CommandingClient;
 
   // ----- Signals -----
-  // Add a Signal
-  void addSignal(String signalName, bool *value);
-  void addSignal(String signalName, byte *value);
-  void addSignal(String signalName, short *value);
-  void addSignal(String signalName, unsigned short *value);
-  void addSignal(String signalName, int *value);
-  void addSignal(String signalName, unsigned int *value);
-  void addSignal(String signalName, long *value);
-  void addSignal(String signalName, unsigned long *value);
-  void addSignal(String signalName, float *value);
-  void addSignal(String signalName, double *value);
+  // Add a Signal. The returned BlaeckSignal<T> handle updates/writes it without
+  // the name lookup and type check of update()/write(); keep it or ignore it.
+  BlaeckSignal<bool> addSignal(String signalName, bool *value);
+  BlaeckSignal<byte> addSignal(String signalName, byte *value);
+  BlaeckSignal<short> addSignal(String signalName, short *value);
+  BlaeckSignal<unsigned short> addSignal(String signalName, unsigned short *value);
+  BlaeckSignal<int> addSignal(String signalName, int *value);
+  BlaeckSignal<unsigned int> addSignal(String signalName, unsigned int *value);
+  BlaeckSignal<long> addSignal(String signalName, long *value);
+  BlaeckSignal<unsigned long> addSignal(String signalName, unsigned long *value);
+  BlaeckSignal<float> addSignal(String signalName, float *value);
+  BlaeckSignal<double> addSignal(String signalName, double *value);
   // String signal: value points to a user-owned, null-terminated char buffer.
   // The buffer is read (not copied) at transmit time; keep it valid and updated
   // in place. Emitted on the wire as a 1-byte length (capped at 255) + bytes,
   // so keep strings short - especially on RAM-constrained targets.
-  void addSignal(String signalName, char *value);
+  BlaeckSignal<char> addSignal(String signalName, char *value);
+  // Same with the name in flash, e.g. addSignal(F("Temperature"), &temp):
+  // only a pointer to it is kept, the name takes no RAM.
+  BlaeckSignal<bool> addSignal(const __FlashStringHelper *signalName, bool *value);
+  BlaeckSignal<byte> addSignal(const __FlashStringHelper *signalName, byte *value);
+  BlaeckSignal<short> addSignal(const __FlashStringHelper *signalName, short *value);
+  BlaeckSignal<unsigned short> addSignal(const __FlashStringHelper *signalName, unsigned short *value);
+  BlaeckSignal<int> addSignal(const __FlashStringHelper *signalName, int *value);
+  BlaeckSignal<unsigned int> addSignal(const __FlashStringHelper *signalName, unsigned int *value);
+  BlaeckSignal<long> addSignal(const __FlashStringHelper *signalName, long *value);
+  BlaeckSignal<unsigned long> addSignal(const __FlashStringHelper *signalName, unsigned long *value);
+  BlaeckSignal<float> addSignal(const __FlashStringHelper *signalName, float *value);
+  BlaeckSignal<double> addSignal(const __FlashStringHelper *signalName, double *value);
+  BlaeckSignal<char> addSignal(const __FlashStringHelper *signalName, char *value);
+
+  // Adds count signals for the elements of an array, named "baseName[0]",
+  // "baseName[1]", ...; the base name is stored once. All or none are added.
+  // Returns the index of element 0, -1 if they did not fit.
+  template <typename T>
+  int addSignalArray(String baseName, T *values, unsigned int count)
+  {
+    return _addSignalArray(baseName.c_str(), false, BlaeckWire<T>::code, values, sizeof(T), count);
+  }
+  template <typename T>
+  int addSignalArray(const __FlashStringHelper *baseName, T *values, unsigned int count)
+  {
+    return _addSignalArray(reinterpret_cast<const char *>(baseName), true, BlaeckWire<T>::code, values, sizeof(T), count);
+  }
+  // A char array is one string signal: use addSignal(name, char *value)
+  int addSignalArray(String baseName, char *values, unsigned int count) = delete;
+  int addSignalArray(const __FlashStringHelper *baseName, char *values, unsigned int count) = delete;
+
+  // Replaces all signals with a compile-time schema (see BlaeckStaticSchema).
+  // Full data frames are then written by the schema's unrolled encoder; frames
+  // with only updated signals or from a snapshot take the regular path. Any
+  // later addSignal()/deleteSignals() drops back to the runtime schema.
+  // Returns false if the schema does not fit maximumSignalCount.
+  bool setSchema(BlaeckSchema &schema);
 
   // Delete all Signals
   void deleteSignals();
@@ -253,6 +1039,43 @@ public:
   void writeMessage(const char *channelName, const char *text);
   void writeMessage(const char *channelName, const char *text, unsigned long messageID);
 
+#if BLAECK_ENABLE_STATS
+  // ----- Runtime statistics (0xC0) -----
+  // writeStats() sends the counters of getStats() and the bytes sent to each
+  // client to every connected client; BLAECK.GET_STATS does the same.
+  // Socket writes the network task does are not timed or counted.
+  const BlaeckStats &getStats() const { return _stats; }
+  void resetStats();
+  uint32_t getClientBytesSent(byte clientNo) const;
+  void writeStats();
+  void writeStats(unsigned long messageID);
+#endif
+
+#if BLAECK_ENABLE_TRACE
+  // ----- Trace (0xC1) -----
+  // The newest BLAECK_TRACE_SIZE events, index 0 the oldest. Timestamps count
+  // getTraceClockHz() ticks: CPU cycles on ESP32/ESP8266 and Cortex-M cores
+  // with a DWT cycle counter, microseconds elsewhere. setTracePoints() takes a
+  // bit mask of BlaeckTracePoint (default: all); leave out
+  // BLAECK_TRACE_SOCKET_WRITE to keep a data frame from filling the ring.
+  // Nothing is recorded while a dump or 0xC1 frame is being written.
+  void setTracePoints(uint16_t mask) { _traceMask = mask; }
+  uint16_t getTracePoints() const { return _traceMask; }
+  void clearTrace();
+  unsigned int getTraceCount() const { return _traceCount; }
+  bool getTraceEvent(unsigned int index, BlaeckTraceEvent &event) const;
+  uint32_t getTraceClockHz() const;
+  // One line per event: time since the oldest event, the phase indented by
+  // nesting depth, and the duration on end events. Without an argument it
+  // goes to the debug stream.
+  void dumpTrace();
+  void dumpTrace(Print &out);
+  // The same events as a 0xC1 frame to every connected client;
+  // BLAECK.GET_TRACE does the same.
+  void writeTrace();
+  void writeTrace(unsigned long messageID);
+#endif
+
   // ----- Data Write -----
   // Update value and write directly - by name
   void write(String signalName, bool value);
@@ -329,6 +1152,8 @@ public:
   void write(int signalIndex, char *value, unsigned long messageID, unsigned long long timestamp);
 
   // ----- Data Update -----
+  // Only the bytes sent on the wire are stored: where long is 8 bytes (host
+  // build) a long or unsigned long value sets the low 4 bytes of the signal.
   // Update value and mark Signal as updated - by name
   void update(String signalName, bool value);
   void update(String signalName, byte value);
@@ -378,6 +1203,37 @@ public:
   void timedWriteUpdatedData(unsigned long messageID);
   void timedWriteUpdatedData(unsigned long messageID, unsigned long long timestamp);
 
+  // ----- Data Write Batch -----
+  // Between beginBatch() and commitBatch() the write(...) calls (also through
+  // BlaeckSignal handles) only store their value; commitBatch() then sends all
+  // of the written signals in one data frame with one timestamp.
+  // abortBatch() sends nothing; the stored values stay.
+  void beginBatch();
+  void commitBatch();
+  void commitBatch(unsigned long messageID);
+  void commitBatch(unsigned long messageID, unsigned long long timestamp);
+  void abortBatch();
+  bool isBatchActive() const { return _batchActive; }
+
+  // ----- Snapshots -----
+  // A data frame reading the signal variables directly can catch a value that
+  // an ISR or another task changes mid-frame: a torn double, or a frame mixing
+  // two instants. With snapshots on, values are first copied into one of two
+  // buffers in a single pass and frames are serialized from that copy.
+  // Call setSnapshotMode() after adding the signals; it allocates the buffers
+  // and returns false if they do not fit.
+  // snapshot() fills the back buffer and flips it to the front. Numeric values
+  // are copied with interrupts off (see BLAECK_SNAPSHOT_LOCK_SPAN), so they are
+  // coherent against ISRs; each string is copied in its own short section. The
+  // interrupt state is saved and restored, so snapshot() may be called from an
+  // ISR or with interrupts already off. On multi-core boards call snapshot()
+  // from the task that updates the values, once a set is complete. It returns
+  // false if a frame is still being serialized from the buffer it would
+  // overwrite (only possible from another task or an ISR).
+  bool setSnapshotMode(BlaeckSnapshotMode mode);
+  BlaeckSnapshotMode getSnapshotMode() const { return _snapshotMode; }
+  bool snapshot();
+
   // ----- Tick -----
   void tick();
   void tick(unsigned long messageID);
@@ -436,6 +1292,101 @@ public:
   void setClientDisconnectedCallback(void (*callback)(byte clientNo));
   bool isClientDataEnabled(byte clientNo) const;
 
+  // ----- Connection slots -----
+  // A client which sends nothing for timeout_ms is disconnected, freeing its
+  // slot (catches half-open connections after a switch/host reboot). Hosts
+  // must then send something (e.g. <BLAECK.GET_DEVICES>) within the timeout.
+  // 0 (default) disables the timeout.
+  void setClientTimeout(unsigned long timeout_ms) { _clientTimeout_ms = timeout_ms; }
+  unsigned long getClientTimeout() const { return _clientTimeout_ms; }
+  // Milliseconds since the client connected / last sent a byte (0: not connected)
+  unsigned long getClientConnectionAge(byte clientNo) const;
+  unsigned long getClientIdleTime(byte clientNo) const;
+
+#if BLAECK_NETWORK_TASK
+  // ----- Dedicated network task (ESP32) -----
+  // Call after begin(). From then on the task owns Clients[] and all socket
+  // I/O; do not touch Clients[i].connection from the sketch. CommandingClient
+  // is not updated in this mode (a NetClient must not be shared between
+  // tasks): use getCommandingClientNo() and writeMessage() to answer.
+  // Returns false for more than 32 clients.
+  bool startNetworkTask(int core = BLAECK_NETWORK_TASK_CORE_DEFAULT, uint32_t stackSize = 4096, unsigned int priority = 1);
+  void stopNetworkTask();
+  bool isNetworkTaskRunning() const { return _netTask != nullptr; }
+  uint32_t getNetworkTxDropCount() const { return _netTxDropCount; }
+#endif
+#if BLAECK_ASYNC_TCP
+  // Received bytes that did not fit a client's ring plus outgoing frames that
+  // did not fit its TX ring (both dropped instead of blocking).
+  uint32_t getAsyncDropCount() const;
+#endif
+
+  // ----- Arena -----
+  // Carves the signal table, the signal name pool and the client table out of
+  // one block instead of separate heap allocations, so repeated begin() calls
+  // and schema changes cannot fragment the heap. Call before begin(); every
+  // begin()/beginBridge() starts the arena over. The name pool is the last
+  // block and grows in place. Pass your own buffer (e.g. a static array) or a
+  // size for the library to allocate once. When the arena runs out the
+  // tables fall back to the heap.
+  bool setArena(void *buffer, size_t size);
+  bool setArena(size_t size);
+  size_t getArenaSize() const { return _arenaSize; }
+  size_t getArenaUsed() const { return _arenaUsed; }
+  // Most bytes ever used: size the arena to this plus room for names added later
+  size_t getArenaHighWater() const { return _arenaHighWater; }
+
+  // ----- History -----
+  // Keeps the most recent data frames, exactly as sent, in a ring of `bytes`
+  // bytes (oldest dropped first). Frames are recorded even while no client is
+  // connected, so a host back from a Wi-Fi blip can fill the gap:
+  // <BLAECK.REPLAY,b0,...,b7> sends it every stored frame whose timestamp is
+  // newer than the 64-bit timestamp b7..b0 (little-endian), oldest first;
+  // 0 replays everything. Without a timestamp mode only the full replay works.
+  // The replay is spread over the following ticks, BLAECK_HISTORY_REPLAY_BYTES
+  // per call; a new REPLAY restarts it. Frames sent from inside the
+  // before-write callback are not recorded.
+  bool beginHistory(size_t bytes);
+  void endHistory();
+  unsigned int getHistoryFrameCount() const { return _historyFrames; }
+  // Frames that did not fit the history (larger than any before them)
+  uint32_t getHistoryLostCount() const { return _history.lost; }
+
+  // ----- Store-and-forward -----
+  // While no data-enabled client is connected, data frames are appended to
+  // `store` (in pages of at least BLAECK_STORE_PAGE_SIZE bytes) instead of
+  // being lost.
+  // Once a data-enabled client is connected, tick() forwards the log to it,
+  // BLAECK_STORE_FORWARD_BYTES per call and oldest first, and clears the store
+  // when done. Frames already in the store (e.g. from before a reboot) are
+  // forwarded as well. nullptr detaches the store.
+  bool setFrameStore(BlaeckFrameStore *store);
+  // Appends the frames still held in RAM now (e.g. before deep sleep).
+  void flushFrameStore();
+  // Bytes waiting to be forwarded (store plus RAM page)
+  uint32_t getFrameStorePending() const;
+  // Frames lost because the page could not grow for them or the store refused
+  // them
+  uint32_t getFrameStoreLostCount() const { return _storeLostCount; }
+
+  // ----- UDP data stream -----
+  // Publishes each data frame (0xD2) once as a UDP datagram to ip:port - a
+  // unicast host or a multicast group - instead of to every TCP client. TCP
+  // keeps carrying commands, symbols, devices and acks. A datagram is a
+  // 4-byte little-endian sequence number followed by the unchanged frame, so
+  // receivers can spot lost datagrams. Call udp->begin(localPort) first and
+  // keep frames below the MTU (about 1400 bytes).
+  void beginDataUdp(UDP *udp, IPAddress ip, uint16_t port);
+  void endDataUdp() { _dataUdp = nullptr; }
+  bool isDataUdpActive() const { return _dataUdp != nullptr; }
+  // Sequence number of the next datagram
+  uint32_t getDataUdpSequence() const { return _dataUdpSeq; }
+  // Datagrams the UDP stack refused (the sequence number is used up anyway)
+  uint32_t getDataUdpErrorCount() const { return _dataUdpErrorCount; }
+
+  // Number of the client which sent the command being dispatched (0xFF: none)
+  byte getCommandingClientNo() const { return _commandingClientNo; }
+
   /**
   Handles bidirectional data transfer between TCP and UART interface. This function
   should be called in the main loop to maintain communication flow.
@@ -443,6 +1394,75 @@ public:
   */
   void bridgePoll();
 
+  // Bridge traffic since beginBridge(). Bytes are counted once forwarded.
+  // Device -> clients: bytes the RX ring had no room for, and bytes a client's
+  // socket did not take (once per client), are dropped and counted as
+  // overflow. Clients -> device: nothing is dropped, the bytes
+  // wait in the TCP stack; the overflow count tells how often the TX ring was
+  // full while clients had more to send.
+  uint32_t getBridgeBytesToDevice() const { return _bridgeBytesToDevice; }
+  uint32_t getBridgeBytesToClients() const { return _bridgeBytesToClients; }
+  uint32_t getBridgeOverflowsToDevice() const { return _bridgeOverflowsToDevice; }
+  uint32_t getBridgeOverflowsToClients() const { return _bridgeOverflowsToClients; }
+
+  // Another serial device behind the bridge (call after beginBridge()). The
+  // devices' UARTs are read in turn without waiting on any of them, and their
+  // output reaches the clients a frame at a time, device after device, so
+  // frames of two devices never mix. Commands from the clients go to every
+  // device. A slaveID other than 0 is written into the slaveID field of the
+  // device's symbol frames and of its (single-entry) device frame, so the
+  // clients can tell whose symbols they are. With several devices the
+  // clients see one device: a symbol list request is answered with a single
+  // 0xB0 frame listing every device's signals, device after device (none
+  // until every device has sent its list), and a device list request with a
+  // single 0xB6 frame with one entry per device. Data frames are renumbered
+  // into that list's index space and carry its schema hash, with a new CRC;
+  // data is dropped (and counted in getBridgeOverflowsToClients()) until
+  // every device's symbol list has passed, or when a frame does not match
+  // its device's list. Each device's 0xB0 and 0xB6 frame
+  // must fit BLAECK_BRIDGE_CACHE_SIZE.
+  // Returns false when BLAECK_BRIDGE_MAX_DEVICES are in use, when
+  // BLAECK_BRIDGE_CACHE_SIZE is 0, or out of memory.
+  bool addBridgeDevice(Stream *bridgeStream, byte slaveID);
+  byte getBridgeDeviceCount() const { return _bridgeDeviceCount; }
+
+#if defined(ESP32)
+  // ESP32: read bridge device `device` (0: the one given to beginBridge())
+  // through the ESP-IDF UART driver of port uartNum instead of its Stream.
+  // Bytes go from the driver's RX buffer into the bridge ring in one copy,
+  // without HardwareSerial's per-call locking and timeouts; writes still use
+  // the Stream. Call after the HardwareSerial's begin(); -1 goes back to the
+  // Stream. Returns false if the device or the driver does not exist.
+  bool setBridgeUart(byte device, int uartNum);
+#endif
+
+  // Time spent inside bridgePoll() since beginBridge(), in microseconds
+  // (wraps after about 71 minutes). Its growth per second of wall time is the
+  // share of the CPU the bridge takes.
+  uint32_t getBridgeBusyMicros() const { return _bridgeBusy_us; }
+
+  // Frame-aware bridge (default off). Commands from the clients are forwarded
+  // to the device whole, one at a time, so two clients can no longer
+  // interleave on the UART. The device's frames are routed: the response to
+  // WRITE_SYMBOLS, GET_DEVICES, WRITE_DATA or WRITE_COMMANDS (matched by key
+  // and message id) and command acks (matched by command hash) go only to
+  // the client that asked; data frames and everything else go to all.
+  // Responses are routed by a 32-bit client mask: with more than 32 clients
+  // the bridge stays byte-transparent.
+  void setBridgeFrameAware(bool enable);
+  bool isBridgeFrameAware() const { return _bridgeFrameAware; }
+
+  // Symbol and device cache of the frame-aware bridge (default on). The last
+  // symbol list and device info the device sent are kept, and later
+  // WRITE_SYMBOLS / GET_DEVICES requests are answered from them with the
+  // requester's message id, without a round trip over the UART. Both are
+  // dropped when a data frame from the device shows another schema hash or
+  // its restart flag. A hit counts one request answered from the cache.
+  void setBridgeCache(bool enable);
+  bool isBridgeCacheEnabled() const { return _bridgeCacheEnabled; }
+  void clearBridgeCache();
+  uint32_t getBridgeCacheHits() const { return _bridgeCacheHits; }
+
   // Timestamp configuration methods
   void setTimestampMode(BlaeckTimestampMode mode);
   void setTimestampCallback(unsigned long long (*callback)());
@@ -452,12 +1472,21 @@ public:
 private:
   unsigned long long getTimeStamp();
   int findSignalIndex(String signalName);
-  void setSignalName(int signalIndex, String signalName);
+  // Returns the new signal's index, -1 if it did not fit
+  int _addSignal(const char *signalName, bool nameInFlash, byte type, void *address);
+  int _addSignalArray(const char *baseName, bool nameInFlash, byte type, void *values, size_t elementSize, unsigned int count);
+  bool _storeSignalValue(int signalIndex, byte type, const void *value, size_t size);
+  void _writeSignal(int signalIndex, unsigned long messageID, unsigned long long timestamp);
+  BlaeckSchema *_staticSchema = nullptr;
+  bool _setSignalName(int signalIndex, const char *signalName, bool inFlash);
+  bool _signalNameEquals(int i, const char *name) const;
+  void _printSignalName(Print &out, int i) const;
   void _setTimedDataState(bool timedActivated, unsigned long timedInterval_ms);
   void _parseCommandTokens(const char *raw);
   void _dispatchRegisteredHandlers();
   // Send a 0xF0 Command Ack frame (cmdHash + status + reason) to CommandingClient.
   void _writeCommandAck(const char *rawCommand, byte status, byte reasonCode);
+  byte _commandingClientNo = 0xFF;
   // FNV-1a 32-bit hash of a NUL-terminated string; correlation id for acks.
   static uint32_t _fnv1a32(const char *s);
   // Monotonic message id stamped into the 0xF0 ack frame header.
@@ -465,13 +1494,63 @@ private:
 
   // Send a 0x90 Message frame (channel name + length-prefixed UTF-8 text) to one client.
   void writeMessage(const char *channelName, const char *text, unsigned long messageID, byte client);
+  void _writeMessageFrame(Print &out, const char *channelName, const char *text, unsigned long messageID);
   // Monotonic message id stamped into the 0x90 message frame header.
   unsigned long _messageMsgId = 0;
 
   void timedWriteData(unsigned long msg_id, int signalIndex_start, int signalIndex_end, bool onlyUpdated, unsigned long long timestamp);
   void tick(unsigned long messageID, bool onlyUpdated);
 
-  void writeData(unsigned long msg_id, byte i, int signalIndex_start, int signalIndex_end, bool onlyUpdated, unsigned long long timestamp);
+  // Sends one data frame to every connected, data-enabled client, or as one
+  // datagram while the UDP data stream is on. Returns false if there was
+  // nobody to send to.
+  // single-signal write()s pass useSnapshot = false: they send the value
+  // they were just handed.
+  bool _writeDataToClients(unsigned long msg_id, int signalIndex_start, int signalIndex_end, bool onlyUpdated, unsigned long long timestamp, bool useSnapshot = true);
+  void writeData(unsigned long msg_id, Print &out, int signalIndex_start, int signalIndex_end, bool onlyUpdated, unsigned long long timestamp);
+
+  // Every frame writer gets its output from _frameBegin() and closes it with
+  // _frameEnd(): the client's socket directly, or the network task's queue.
+  Print &_frameBegin(byte client);
+  void _frameEnd(byte client);
+  bool _clientConnected(byte client) const;
+  // A client's socket as the frame writers see it: counted and traced when
+  // statistics or tracing are on. One wrapper per client, so a frame sent to
+  // another client from inside a frame (the before-write callback) cannot
+  // redirect the rest of it.
+  Print &_clientOut(byte client);
+
+#if BLAECK_ENABLE_STATS || BLAECK_ENABLE_TRACE
+  class ClientPrint : public Print
+  {
+  public:
+    BlaeckTCP *owner = nullptr;
+    byte client = 0;
+    unsigned long frameStart_us = 0; // socketWrite times whole frames
+    using Print::write;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+  };
+  ClientPrint *_clientPrints = nullptr;
+#endif
+  void _frameTimerStart(byte client);
+  void _frameTimerStop(byte client);
+
+#if BLAECK_ENABLE_STATS
+  BlaeckStats _stats = {};
+  void writeStats(unsigned long messageID, byte client);
+#endif
+
+#if BLAECK_ENABLE_TRACE
+  friend struct BlaeckTraceScope;
+  BlaeckTraceEvent _trace[BLAECK_TRACE_SIZE];
+  unsigned int _traceHead = 0;  // slot the next event goes to
+  unsigned int _traceCount = 0;
+  uint16_t _traceMask = 0xFFFF;
+  bool _tracePaused = false;
+  void _traceRecord(byte point, bool end);
+  void writeTrace(unsigned long messageID, byte client);
+#endif
 
   void writeDevices(unsigned long messageID, byte client);
 
@@ -492,27 +1571,305 @@ private:
   static void _percentDecodeInPlace(char *s);
 #endif
 
-  uint16_t _computeSchemaHash();
+  uint16_t _schemaHashAdd(uint16_t crc, int first, int end) const;
+
+  static byte _dataTypeSize(dataType type);
+  bool _layoutSnapshot();
+  void _freeSnapshot();
+  const uint8_t *_pinSnapshot();
+  void _unpinSnapshot();
 
   static void validatePlatformSizes();
 
   void _initClientMeta();
-  void _parseClientIdentity(const char *raw);
+  void _acceptClients();
+  void _pruneClients();
+  void _dropClient(byte clientNo, const char *reason);
+  bool _receiveCommand(char *dest, byte &clientNo);
+  void _notifyClientConnected(byte clientNo);
+  void _notifyClientDisconnected(byte clientNo);
+  void _printClientEvent(const char *text);
+  void _parseClientIdentity(byte clientNo, const char *raw);
   void _startServer(uint16_t port);
 
   Stream *StreamRef = nullptr;
   int _blaeckWriteDataClientMask;
   byte _maxClients = 0;
-  Stream *BridgeStreamRef = nullptr;
+  unsigned long _clientTimeout_ms = 0;
+  // History records: length(2) timestamp(8) frame[length]
+  class HistoryRing : public Print
+  {
+  public:
+    BlaeckByteRing ring;
+    size_t frameLen = 0;
+    // Room made before each frame: the largest record seen so far.
+    size_t reserve = 64;
+    uint32_t lost = 0;
+    void begin(unsigned long long timestamp);
+    bool commit();
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+      frameLen += size;
+      return ring.stage(buffer, size) ? size : 0;
+    }
+    using Print::write;
+  };
+  // Passes the first receiver's frame through to the history as well, so
+  // recording costs no extra writeData() (nor before-write callback).
+  class HistoryTee : public Print
+  {
+  public:
+    explicit HistoryTee(HistoryRing *history) : _history(history) {}
+    bool used = false;
+    Print &to(Print &out)
+    {
+      if (_history == nullptr || used)
+        return out;
+      used = true;
+      _out = &out;
+      return *this;
+    }
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+      _history->write(buffer, size);
+      return _out->write(buffer, size);
+    }
+    using Print::write;
+
+  private:
+    HistoryRing *_history;
+    Print *_out = nullptr;
+  };
+  static const byte HISTORY_HEADER_SIZE = 10;
+  void _dropOldestHistoryFrame();
+  void _replayHistory(unsigned long long since);
+  void _continueReplay();
+  HistoryRing _history;
+  unsigned int _historyFrames = 0;
+  // A record is open: a frame sent from the before-write callback is not
+  // recorded in the middle of it
+  bool _historyStaging = false;
+  // Replay in progress: byte offsets into the ring, moved along when the
+  // oldest frame is dropped
+  byte _replayClient = 0xFF;
+  unsigned long long _replaySince = 0;
+  size_t _replayOffset = 0;
+  size_t _replayEnd = 0;
+
+  // Store-and-forward page: records length(2) frame[length]. It starts at
+  // BLAECK_STORE_PAGE_SIZE bytes and grows to hold the largest record.
+  class StorePage : public Print
+  {
+  public:
+    uint8_t *buf = nullptr;
+    size_t capacity = 0;
+    size_t len = 0;
+    size_t frameStart = 0;
+    size_t frameLen = 0;
+    bool overflow = false;
+    // Room made before each frame: the largest record seen so far.
+    size_t reserve = 64;
+    unsigned int frames = 0;
+    bool allocate(size_t size);
+    void release();
+    void begin();
+    bool commit();
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+  };
+  void _forwardStoredFrames();
+  BlaeckFrameStore *_frameStore = nullptr;
+  StorePage _storePage;
+  uint32_t _storeSize = 0;
+  uint32_t _storeCursor = 0;
+  byte _storeClient = 0xFF;
+  uint32_t _storeLostCount = 0;
+
+  UDP *_dataUdp = nullptr;
+  IPAddress _dataUdpIp;
+  uint16_t _dataUdpPort = 0;
+  uint32_t _dataUdpSeq = 0;
+  uint32_t _dataUdpErrorCount = 0;
   bool _bridgeMode = false;
 
-  Signal *Signals = nullptr;
+  // Last 0xB0 and 0xB6 frames from a device, as received
+  struct BridgeCacheEntry
+  {
+    uint8_t *buf = nullptr;
+    size_t len = 0; // 0: nothing cached
+    // Several devices: an answer waiting for the other devices' answers
+    bool held = false;
+    uint32_t msgId = 0;
+    uint32_t mask = 0; // its receivers
+    unsigned long held_ms = 0;
+  };
+  struct BridgeDevice
+  {
+    Stream *stream = nullptr;
+    byte slaveID = 0;
+    BlaeckByteRing tx; // clients -> device
+    BlaeckByteRing rx; // device -> clients
+    bool reportsRoom = false;
+    size_t scanPos = 0; // where the search for the frame end resumes
+    BridgeCacheEntry cache[2]; // symbols, devices
+    bool dataSeen = false; // dataHash is set
+    uint16_t dataHash = 0;
+    // Several devices: its signals, from its last symbol frame
+    bool layoutKnown = false;
+    byte *types = nullptr;    // type code of each signal
+    uint16_t signalCount = 0;
+    uint16_t symbolHash = 0;  // its schema hash
+    size_t symbolBytes = 0;   // bytes that hash is over
+#if defined(ESP32)
+    int uart = -1; // read through this UART driver port instead of stream
+#endif
+  };
+  BridgeDevice _bridgeDevices[BLAECK_BRIDGE_MAX_DEVICES];
+  byte _bridgeDeviceCount = 0;
+  byte _bridgeNextDevice = 0; // first in line for the next unit
+  uint32_t _bridgeBytesToDevice = 0;
+  uint32_t _bridgeBytesToClients = 0;
+  uint32_t _bridgeOverflowsToDevice = 0;
+  uint32_t _bridgeOverflowsToClients = 0;
+  uint32_t _bridgeBusy_us = 0;
+  void _bridgeInitDevice(BridgeDevice &device, Stream *stream, byte slaveID);
+  void _bridgeReadClients();
+  void _bridgeReadDevices();
+  void _bridgeReadDevice(BridgeDevice &device);
+#if defined(ESP32)
+  void _bridgeReadUart(BridgeDevice &device);
+#endif
+  size_t _bridgeTxRoom() const;
+  size_t _bridgeFlushToDevices();
+  size_t _bridgeFlushToDevice(BridgeDevice &device);
+  size_t _bridgeFlushToClients();
+  size_t _bridgeSendToClients(byte device, uint32_t &clientMask, size_t maxLen, bool frame);
+  bool _bridgeFrameRoom();
+
+  // Frame-aware bridge
+  struct BridgeCommand
+  {
+    uint16_t len;
+    bool complete;
+    char buf[BLAECK_COMMAND_MAX_CHARS_DEFAULT + 3]; // '<' command '>' NUL
+  };
+  struct BridgeRequest
+  {
+    byte client;
+    byte responseKey;     // 0: no response
+    byte responsePending; // devices whose response is still to be routed
+    byte ackPending;      // devices whose ack is still to be routed
+    uint32_t msgId;
+    uint32_t hash; // FNV-1a of the command, as the device's ack carries it
+    unsigned long sent_ms;
+  };
+  bool _bridgeFrameAware = false;
+  BridgeCommand *_bridgeCommands = nullptr;
+  BridgeRequest _bridgeRequests[BLAECK_BRIDGE_MAX_REQUESTS];
+  byte _bridgeOutDevice = 0;   // sender of the unit being sent
+  uint32_t _bridgeOutMask = 0; // its receivers
+  size_t _bridgeOutLeft = 0;   // bytes of it still to send
+  bool _bridgeOutFrame = false; // it is a frame: never continued after a short write
+  bool _bridgeOutStarted = false; // some of the frame has gone out
+  void _bridgeAllocCommands();
+  void _bridgeReadCommands();
+  void _bridgeTrackRequest(byte client, byte key, uint32_t msgId, uint32_t hash, bool acked);
+  bool _bridgeNextUnit();
+  bool _bridgeNextUnitFrom(byte device);
+  uint32_t _bridgeRouteFrame(byte device, byte key, uint32_t msgId, uint32_t ackHash);
+  void _bridgeTagFrame(BridgeDevice &device, byte key, size_t frameLen);
+
+  bool _bridgeCacheEnabled = true;
+  uint32_t _bridgeCacheHits = 0;
+  BridgeCacheEntry *_bridgeCacheFor(BridgeDevice &device, byte key);
+  bool _bridgeCacheComplete(byte key);
+  void _bridgeCacheStore(BridgeDevice &device, byte key, size_t frameLen);
+  void _bridgeCacheCheckData(BridgeDevice &device, byte restartFlag, uint16_t schemaHash);
+  void _bridgeCacheServe(byte client, byte key, uint32_t msgId);
+
+  // Several devices: one symbol list and one device list for all of them,
+  // data frames renumbered into that list's index space
+  uint16_t _bridgeSchemaHash = 0; // of the merged symbol list
+  bool _bridgeHoldAnswer(byte d, byte key, uint32_t msgId, size_t frameLen);
+  void _bridgeReleaseAnswers(byte key);
+  void _bridgeWriteMerged(byte client, byte key, uint32_t msgId);
+  void _bridgeLearnLayout(BridgeDevice &device, const BridgeCacheEntry &symbols);
+  void _bridgeForgetLayout(BridgeDevice &device);
+  void _bridgeUpdateSchemaHash();
+  bool _bridgeRemapData(byte d, size_t frameLen);
+  bool _bridgeWalkData(BridgeDevice &device, size_t pos, size_t end, uint16_t offset);
+  uint32_t _bridgeFrameCrc(BlaeckByteRing &rx, size_t frameLen);
+
+  // Signal table as parallel arrays, indexed by signal: the serialization and
+  // update-flag loops only touch the columns they need.
+  bool _allocSignalTable(unsigned int capacity);
+  void _freeSignalTable();
+  void _allocClientTable(byte count);
+  void _freeClientTable();
+  void _resetTables();
+  void *_tableAlloc(size_t size);
+  bool _arenaFits(size_t size) const;
+  void _tableFree(void *block);
+  bool _inArena(const void *block) const
+  {
+    return _arena != nullptr && (const uint8_t *)block >= _arena && (const uint8_t *)block < _arena + _arenaSize;
+  }
+  uint8_t *_arena = nullptr;
+  size_t _arenaSize = 0;
+  size_t _arenaUsed = 0;
+  size_t _arenaHighWater = 0;
+  bool _arenaOwned = false;
+  byte _clientTableSize = 0;
+  // RAM names: offset into _signalNames; flash names: the PROGMEM address;
+  // the names of a schema (the first _signalNamesInPlace): their address.
+  const char *_signalName(int i) const
+  {
+    return (_isSignalNameInFlash(i) || i < _signalNamesInPlace) ? (const char *)_signalNameRef[i]
+                                                                  : _signalNames + _signalNameRef[i];
+  }
+  bool _isSignalNameInFlash(int i) const { return (_signalNameInFlash[i >> 3] >> (i & 7)) & 1; }
+  bool _isSignalInArray(int i) const { return (_signalInArray[i >> 3] >> (i & 7)) & 1; }
+  size_t _signalStringLimit(int i) const;
+  unsigned int _signalElement(int i) const { return _signalArrayElement[i]; }
+  bool _isSignalUpdated(int i) const { return (_signalUpdated[i >> 3] >> (i & 7)) & 1; }
+  void _setSignalUpdated(int i) { _signalUpdated[i >> 3] |= (byte)(1 << (i & 7)); }
+  void **_signalAddress = nullptr;
+  byte *_signalType = nullptr;           // dataType, one byte
+  byte *_signalUpdated = nullptr;        // bitset, bit i = signal i
+  byte *_signalBatched = nullptr;        // bitset, written during the open batch
+  bool _batchActive = false;
+  uintptr_t *_signalNameRef = nullptr;   // see _signalName()
+  byte *_signalNameInFlash = nullptr;    // bitset, bit i = name i is in flash
+  byte *_signalInArray = nullptr;        // bitset, bit i = name i is "base[element]"
+  uint16_t *_signalArrayElement = nullptr; // element of array signal i, from the first array
+  char *_signalNames = nullptr;          // NUL-terminated names back to back
+  uint16_t _signalNamesSize = 0;
+  uint16_t _signalNamesUsed = 0;
+  int _signalNamesInPlace = 0;          // signals named by a schema, see _signalName()
   int _signalIndex = 0;
+  unsigned long _signalGeneration = 0;  // bumped when the table is emptied; BlaeckSignal checks it
   unsigned int _signalCapacity = 0;
   bool _signalOverflowOccurred = false;
   uint16_t _signalOverflowCount = 0;
   uint16_t _schemaHash = 0;
 
+  BlaeckSnapshotMode _snapshotMode = BLAECK_SNAPSHOT_OFF;
+  // Two buffers of _snapshotSize bytes back to back; each signal's value sits
+  // at _snapshotOffsets[j], aligned to its size.
+  uint8_t *_snapshotBuffer = nullptr;
+  uint16_t *_snapshotOffsets = nullptr;
+  size_t _snapshotSize = 0;
+  bool _snapshotStale = true;
+  volatile bool _snapshotValid = false;
+  volatile byte _snapshotFront = 0;
+  // Buffer a frame is being serialized from (0xFF: none)
+  volatile byte _snapshotReading = 0xFF;
+  // Buffer the current frame reads from; nullptr reads the signal variables
+  const uint8_t *_snapshotRead = nullptr;
+
   bool _serverRestarted = true;
   bool _sendRestartFlag = true;
 
@@ -570,6 +1927,57 @@ private:
   bool recvWithStartEndMarkers();
   void parseData();
 
+#if BLAECK_NETWORK_TASK
+  // Frame queue fed by the loop task, drained by the network task. Each record
+  // is clientMask(4) + length(2) + the encoded frame, so a data frame for
+  // several clients is encoded once.
+  class FrameQueue : public Print
+  {
+  public:
+    BlaeckByteRing ring;
+    void begin(uint32_t clientMask);
+    bool commit();
+    size_t write(uint8_t b) override { return ring.stage(&b, 1) ? 1 : 0; }
+    size_t write(const uint8_t *buffer, size_t size) override { return ring.stage(buffer, size) ? size : 0; }
+    using Print::write;
+  };
+
+  // Records in the RX queue: type(1) client(1) length(1) text[length]
+  static const byte NET_EVENT_COMMAND = 0;
+  static const byte NET_EVENT_CONNECTED = 1;
+  static const byte NET_EVENT_DISCONNECTED = 2;
+  static const byte NET_EVENT_TEXT = 3; // debug output for StreamRef
+
+  static void _networkTaskEntry(void *arg);
+  void _networkTaskLoop();
+  bool _netDrainTx();
+  void _netPushEvent(byte type, byte clientNo, const char *text);
+  bool _netPollEvents();
+
+  // Polled by stopNetworkTask() while the task clears it
+  volatile TaskHandle_t _netTask = nullptr;
+  volatile bool _netTaskStop = false;
+  volatile uint32_t _netConnectedMask = 0;
+  uint32_t _netTxDropCount = 0;
+  FrameQueue _netTx;
+  BlaeckByteRing _netRx;
+  char _netRxChars[MAXIMUM_CHAR_COUNT];
+#endif
+
+#if BLAECK_ASYNC_TCP
+  // ----- Async TCP backend -----
+  static void _asyncOnClient(void *arg, AsyncClient *client);
+  static void _asyncOnData(void *arg, AsyncClient *client, void *data, size_t len);
+  static void _asyncOnDisconnect(void *arg, AsyncClient *client);
+  BlaeckConnection _asyncAccept();
+  void _asyncFlush();
+  void _asyncEnd();
+  AsyncServer *_asyncServer = nullptr;
+  // _maxClients + 1: the spare one lets a client be told "Server full".
+  BlaeckAsyncSocket *_asyncSockets = nullptr;
+  byte _asyncSocketCount = 0;
+#endif
+
   void (*_beforeWriteCallback)() = nullptr;
   void (*_clientConnectedCallback)(byte clientNo) = nullptr;
   void (*_clientDisconnectedCallback)(byte clientNo) = nullptr;
@@ -643,4 +2051,114 @@ private:
   } dblCvt;
 };
 
+// Handle to one signal, returned by addSignal(). The index and the type were
+// checked when the signal was added, so set()/write() only store the value
+// and mark or send it. A handle of a signal that did not fit, or a
+// default-constructed one, is inert (valid() == false). Handles become stale
+// with deleteSignals(), setSchema() or begin(); a stale handle neither stores
+// nor sends anything, even once its index is taken by a new signal.
+template <typename T>
+class BlaeckSignal
+{
+public:
+  BlaeckSignal() {}
+  BlaeckSignal(BlaeckTCP *blaeck, int index, T *value)
+      : _blaeck(index >= 0 ? blaeck : nullptr), _index(index), _generation((blaeck != nullptr) ? blaeck->_signalGeneration : 0), _value(value) {}
+
+  bool valid() const { return _blaeck != nullptr; }
+  int index() const { return _index; }
+  T get() const { return (_value != nullptr) ? *_value : T(); }
+
+  // Like update(): store the value and mark the signal updated
+  void set(T value)
+  {
+    if (!_live())
+      return;
+    *_value = value;
+    _blaeck->_setSignalUpdated(_index);
+  }
+  void mark()
+  {
+    if (_live())
+      _blaeck->_setSignalUpdated(_index);
+  }
+
+  // Like write(): store the value and send it in its own data frame
+  void write(T value) { write(value, 1); }
+  void write(T value, unsigned long messageID)
+  {
+    write(value, messageID, (_blaeck != nullptr) ? _blaeck->getTimeStamp() : 0);
+  }
+  void write(T value, unsigned long messageID, unsigned long long timestamp)
+  {
+    if (!_live())
+      return;
+    *_value = value;
+    _blaeck->_writeSignal(_index, messageID, timestamp);
+  }
+
+private:
+  bool _live() const
+  {
+    return _blaeck != nullptr && _generation == _blaeck->_signalGeneration && _index < _blaeck->_signalIndex;
+  }
+
+  BlaeckTCP *_blaeck = nullptr;
+  int _index = -1;
+  unsigned long _generation = 0;
+  T *_value = nullptr;
+};
+
+// String signal: the value is a user-owned buffer, set()/write() repoint it.
+template <>
+class BlaeckSignal<char>
+{
+public:
+  BlaeckSignal() {}
+  BlaeckSignal(BlaeckTCP *blaeck, int index, char *value)
+      : _blaeck(index >= 0 ? blaeck : nullptr), _index(index), _generation((blaeck != nullptr) ? blaeck->_signalGeneration : 0) {}
+
+  bool valid() const { return _blaeck != nullptr; }
+  int index() const { return _index; }
+
+  void set(char *value)
+  {
+    if (_live())
+    {
+      _blaeck->_signalAddress[_index] = value;
+      _blaeck->_setSignalUpdated(_index);
+    }
+  }
+  void mark()
+  {
+    if (_live())
+      _blaeck->_setSignalUpdated(_index);
+  }
+
+  void write(char *value) { write(value, 1); }
+  void write(char *value, unsigned long messageID)
+  {
+    if (_blaeck != nullptr)
+      write(value, messageID, _blaeck->getTimeStamp());
+  }
+  void write(char *value, unsigned long messageID, unsigned long long timestamp)
+  {
+    if (_live())
+    {
+      _blaeck->_signalAddress[_index] = value;
+      _blaeck->_writeSignal(_index, messageID, timestamp);
+    }
+  }
+
+private:
+  bool _live() const
+  {
+    return _blaeck != nullptr && _generation == _blaeck->_signalGeneration && _index < _blaeck->_signalIndex;
+  }
+
+  BlaeckTCP *_blaeck = nullptr;
+  int _index = -1;
+  unsigned long _generation = 0;
+};
+
 #endif //  BLAECKTCP_H